@@ -0,0 +1,102 @@
+/*================================================================================
+
+File: bench_book_lookup.cpp                                                     
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-17 09:12:26                                                 
+last edited: 2025-05-17 09:12:26                                                
+
+================================================================================*/
+
+//orderbook id -> book resolution cost as the number of tracked books grows
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <span>
+#include <unordered_set>
+#include <vector>
+
+#include "BookIndex.hpp"
+#include "utils/utils.hpp"
+
+volatile bool error = false;
+
+static constexpr size_t LOOKUPS = 1 << 16;
+static constexpr size_t ROUNDS = 64;
+static constexpr std::array<size_t, 7> BOOK_COUNTS = {23, 64, 256, 1024, 2048, 4096, 8192};
+
+template <typename Lookup>
+static double timeLookups(const std::vector<uint32_t> &queries, Lookup &&lookup)
+{
+  uint64_t sink = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < ROUNDS; ++round)
+  {
+    for (const uint32_t id : queries)
+    {
+      sink += lookup(id);
+      asm volatile("" : "+r"(sink));
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::nano>(end - start).count() / (ROUNDS * queries.size());
+}
+
+int main(void)
+{
+  std::mt19937 rng(42);
+
+  std::printf("ns per lookup, 1 in 8 ids is not whitelisted\n");
+  std::printf("%8s %16s %12s\n", "books", "set + linear", "book index");
+
+  for (const size_t books_count : BOOK_COUNTS)
+  {
+    std::unordered_set<uint32_t> whitelist;
+    while (whitelist.size() < books_count)
+      whitelist.insert(1 + rng() % 1000000);
+
+    const std::vector<uint32_t> ids(whitelist.begin(), whitelist.end());
+    BookIndex book_index;
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+      book_index.insert(ids[i]);
+      book_index.setBook(ids[i], i);
+    }
+
+    std::vector<uint32_t> queries(LOOKUPS);
+    for (uint32_t &id : queries)
+      id = (rng() % 8) ? ids[rng() % ids.size()] : 1000001 + rng() % 1000000;
+
+    //what MessageHandler did before: whitelist check on 'R', linear scan on every message
+    const double linear = timeLookups(queries, [&](const uint32_t id)
+    {
+      static constexpr std::equal_to<uint32_t> comp{};
+      return whitelist.contains(id) ? utils::forward_lower_bound(std::span<const uint32_t>{ids}, id, comp) : -1;
+    });
+
+    const double indexed = timeLookups(queries, [&](const uint32_t id)
+    {
+      return book_index.find(id);
+    });
+
+    for (const uint32_t id : queries)
+    {
+      const auto it = std::find(ids.begin(), ids.end(), id);
+      const uint32_t expected = (it == ids.end()) ? BookIndex::NO_BOOK : it - ids.begin();
+      if (book_index.find(id) != expected)
+      {
+        std::fprintf(stderr, "book index: id %u resolved to %u, expected %u\n", id, book_index.find(id), expected);
+        return 1;
+      }
+    }
+
+    std::printf("%8zu %16.2f %12.2f\n", books_count, linear, indexed);
+  }
+}
@@ -0,0 +1,175 @@
+/*================================================================================
+
+File: bench_decode.cpp                                                          
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-24 15:36:08                                                 
+last edited: 2025-06-24 15:36:08                                                
+
+================================================================================*/
+
+//decode cost of the order book messages: field by field through the boost big endian types, against one
+//byte shuffle per message with MessageDecoder. Both sides produce the same DecodedMessage
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "MessageDecoder.hpp"
+#include "Packets.hpp"
+
+volatile bool error = false;
+
+static constexpr uint32_t MESSAGES = 1 << 14;
+static constexpr uint32_t ROUNDS = 256;
+static constexpr std::array<char, 5> TYPES = {'A', 'D', 'E', 'C', 'Z'};
+
+//what the handlers read before MessageDecoder
+static DecodedMessage decodeBoost(const MessageData &data) noexcept
+{
+  DecodedMessage m{};
+
+  switch (data.type)
+  {
+    case 'A':
+      m.order_id = data.new_order.order_id;
+      m.orderbook_id = data.new_order.orderbook_id;
+      m.side = data.new_order.side;
+      m.qty = data.new_order.quantity;
+      m.price = data.new_order.price;
+      break;
+    case 'D':
+      m.order_id = data.deleted_order.order_id;
+      m.orderbook_id = data.deleted_order.orderbook_id;
+      m.side = data.deleted_order.side;
+      break;
+    case 'E':
+      m.order_id = data.execution_notice.order_id;
+      m.orderbook_id = data.execution_notice.orderbook_id;
+      m.side = data.execution_notice.side;
+      m.qty = data.execution_notice.executed_quantity;
+      break;
+    case 'C':
+      m.order_id = data.execution_notice_with_trade_info.order_id;
+      m.orderbook_id = data.execution_notice_with_trade_info.orderbook_id;
+      m.side = data.execution_notice_with_trade_info.side;
+      m.qty = data.execution_notice_with_trade_info.executed_quantity;
+      break;
+    case 'Z':
+      m.order_id = data.ep.available_bid_quantity;
+      m.orderbook_id = data.ep.orderbook_id;
+      m.qty = data.ep.available_ask_quantity;
+      m.price = data.ep.equilibrium_price;
+      break;
+  }
+
+  return m;
+}
+
+static DecodedMessage decodeShuffle(const MessageData &data) noexcept
+{
+  switch (data.type)
+  {
+    case 'A':
+      return MessageDecoder::decode<'A'>(data);
+    case 'D':
+      return MessageDecoder::decode<'D'>(data);
+    case 'E':
+      return MessageDecoder::decode<'E'>(data);
+    case 'C':
+      return MessageDecoder::decode<'C'>(data);
+    case 'Z':
+      return MessageDecoder::decode<'Z'>(data);
+    default:
+      return {};
+  }
+}
+
+//message blocks back to back, as in a packet payload
+static std::vector<char> makeBlocks(std::mt19937_64 &rng)
+{
+  static constexpr std::array<uint16_t, 'Z' + 1> data_lengths = MessageDecoder::getDataLengths();
+
+  std::vector<char> blocks;
+
+  for (uint32_t i = 0; i < MESSAGES; ++i)
+  {
+    MessageBlock block{};
+    MessageData &data = block.data;
+
+    data.type = TYPES[rng() % TYPES.size()];
+    block.length = sizeof(data.type) + data_lengths[data.type];
+
+    //every field of every type gets random bytes, the shuffle must pick the right ones
+    std::array<uint64_t, sizeof(MessageData) / 8 + 1> noise;
+    for (uint64_t &word : noise)
+      word = rng();
+    std::memcpy(reinterpret_cast<char *>(&data) + sizeof(data.type), noise.data(), block.length - sizeof(data.type));
+
+    const char *bytes = reinterpret_cast<const char *>(&block);
+    blocks.insert(blocks.end(), bytes, bytes + sizeof(block.length) + block.length);
+  }
+
+  return blocks;
+}
+
+template <typename Decode>
+static double timeDecode(const std::vector<char> &blocks, uint64_t &checksum, Decode &&decode)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  for (uint32_t round = 0; round < ROUNDS; ++round)
+  {
+    for (const char *buffer = blocks.data(); buffer < blocks.data() + blocks.size();)
+    {
+      const MessageBlock &block = *reinterpret_cast<const MessageBlock *>(buffer);
+      const DecodedMessage m = decode(block.data);
+
+      checksum += m.order_id ^ m.orderbook_id ^ m.side ^ m.qty ^ static_cast<uint32_t>(m.price);
+      asm volatile("" : "+r"(checksum));
+
+      buffer += sizeof(block.length) + block.length;
+    }
+  }
+
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / (static_cast<double>(ROUNDS) * MESSAGES);
+}
+
+int main(void)
+{
+  std::mt19937_64 rng(42);
+  const std::vector<char> blocks = makeBlocks(rng);
+
+  for (const char *buffer = blocks.data(); buffer < blocks.data() + blocks.size();)
+  {
+    const MessageBlock &block = *reinterpret_cast<const MessageBlock *>(buffer);
+    const DecodedMessage expected = decodeBoost(block.data);
+    const DecodedMessage decoded = decodeShuffle(block.data);
+
+    const bool same = (expected.order_id == decoded.order_id) & (expected.orderbook_id == decoded.orderbook_id)
+      & (expected.side == decoded.side) & (expected.qty == decoded.qty) & (expected.price == decoded.price);
+    if (!same)
+    {
+      std::fprintf(stderr, "'%c' decoded differently\n", block.data.type);
+      return 1;
+    }
+
+    buffer += sizeof(block.length) + block.length;
+  }
+
+  uint64_t boost_checksum = 0;
+  uint64_t shuffle_checksum = 0;
+  const double boost_ns = timeDecode(blocks, boost_checksum, decodeBoost);
+  const double shuffle_ns = timeDecode(blocks, shuffle_checksum, decodeShuffle);
+
+  std::printf("ns per message, %u random 'A' 'D' 'E' 'C' 'Z' messages decoded %u times\n", MESSAGES, ROUNDS);
+  std::printf("%14s %14s\n", "boost", "shuffle");
+  std::printf("%14.2f %14.2f\n", boost_ns, shuffle_ns);
+
+  return boost_checksum != shuffle_checksum;
+}
@@ -0,0 +1,67 @@
+/*================================================================================
+
+File: bench_delete.cpp                                                          
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-06 11:47:03                                                 
+last edited: 2025-05-06 11:47:03                                                
+
+================================================================================*/
+
+//delete latency of orders far from the touch, as a function of book depth
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "OrderBook.hpp"
+
+volatile bool error = false;
+
+static constexpr uint32_t ORDERS_PER_LEVEL = 4;
+static constexpr uint32_t ROUNDS = 256;
+static constexpr uint64_t ORDER_QTY = 100;
+
+static double benchDeletes(const uint32_t depth)
+{
+  OrderBook book;
+  std::mt19937 rng(depth);
+
+  for (uint32_t level = 0; level < depth; ++level)
+    for (uint32_t i = 0; i < ORDERS_PER_LEVEL; ++i)
+      book.addOrder(level * ORDERS_PER_LEVEL + i + 1, OrderBook::BID, level + 1, ORDER_QTY);
+
+  //one order out of every level in the deeper half of the book, the touch is never hit
+  const uint32_t deep_levels = (depth + 1) / 2;
+  std::vector<uint64_t> victims(deep_levels);
+  std::chrono::nanoseconds elapsed{0};
+
+  for (uint32_t round = 0; round < ROUNDS; ++round)
+  {
+    for (uint32_t level = 0; level < deep_levels; ++level)
+      victims[level] = level * ORDERS_PER_LEVEL + rng() % ORDERS_PER_LEVEL + 1;
+    std::shuffle(victims.begin(), victims.end(), rng);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (const uint64_t id : victims)
+      book.removeOrder(id, OrderBook::BID);
+    elapsed += std::chrono::steady_clock::now() - start;
+
+    for (const uint64_t id : victims)
+      book.addOrder(id, OrderBook::BID, (id - 1) / ORDERS_PER_LEVEL + 1, ORDER_QTY);
+  }
+
+  return static_cast<double>(elapsed.count()) / (static_cast<double>(ROUNDS) * deep_levels);
+}
+
+int main(void)
+{
+  static constexpr uint32_t depths[] = { 1, 10, 100, 1000, 10000 };
+
+  std::printf("%10s %12s\n", "depth", "ns/delete");
+  for (const uint32_t depth : depths)
+    std::printf("%10u %12.1f\n", depth, benchDeletes(depth));
+}
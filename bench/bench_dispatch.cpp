@@ -0,0 +1,213 @@
+/*================================================================================
+
+File: bench_dispatch.cpp                                                        
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-23 09:12:37                                                 
+last edited: 2025-06-23 09:12:37                                                
+
+================================================================================*/
+
+//instructions retired, branch mispredictions and time per message through MessageHandler, on a stream of
+//adds, deletes and executions spread over a growing number of books. The counters are read with
+//perf_event_open, n/a where the kernel does not expose them (perf_event_paranoid > 2, most VMs)
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "MessageHandler.hpp"
+#include "Packets.hpp"
+
+volatile bool error = false;
+
+static constexpr uint32_t MESSAGES = 1 << 16;
+static constexpr uint32_t ROUNDS = 32;
+static constexpr uint32_t PRICE_LEVELS = 16;
+static constexpr std::array<uint32_t, 3> BOOK_COUNTS = {1, 23, 1024};
+
+class PerfCounters
+{
+  public:
+    PerfCounters(void) noexcept
+    {
+      leader = open(PERF_COUNT_HW_INSTRUCTIONS, -1);
+      branch_misses = open(PERF_COUNT_HW_BRANCH_MISSES, leader);
+    }
+
+    ~PerfCounters()
+    {
+      if (branch_misses != -1)
+        close(branch_misses);
+      if (leader != -1)
+        close(leader);
+    }
+
+    bool isAvailable(void) const noexcept { return (leader != -1) & (branch_misses != -1); }
+
+    void start(void) const noexcept
+    {
+      ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    //instructions and branch misses since start
+    std::array<uint64_t, 2> stop(void) const noexcept
+    {
+      ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+      struct { uint64_t count; uint64_t values[2]; } group{};
+      if (read(leader, &group, sizeof(group)) != sizeof(group))
+        return {0, 0};
+      return {group.values[0], group.values[1]};
+    }
+
+  private:
+    int leader;
+    int branch_misses;
+
+    static int open(const uint64_t config, const int group_fd) noexcept
+    {
+      perf_event_attr attr{};
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = config;
+      attr.disabled = (group_fd == -1);
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+
+      return syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+    }
+};
+
+//every order added is deleted or fully executed by the end, so the stream can be replayed on the same books
+static std::vector<MessageData> makeStream(const uint32_t books_count, std::mt19937 &rng)
+{
+  struct Resting
+  {
+    uint64_t id;
+    uint32_t book;
+    char side;
+    uint64_t qty;
+  };
+
+  std::vector<MessageData> stream;
+  std::vector<Resting> resting;
+  uint64_t next_id = 1;
+
+  stream.reserve(MESSAGES);
+
+  const auto remove = [&](const size_t idx, const bool executed)
+  {
+    const Resting order = resting[idx];
+    MessageData &data = stream.emplace_back();
+
+    if (executed)
+    {
+      data.type = 'E';
+      data.execution_notice.order_id = order.id;
+      data.execution_notice.orderbook_id = order.book;
+      data.execution_notice.side = order.side;
+      data.execution_notice.executed_quantity = order.qty;
+    }
+    else
+    {
+      data.type = 'D';
+      data.deleted_order.order_id = order.id;
+      data.deleted_order.orderbook_id = order.book;
+      data.deleted_order.side = order.side;
+    }
+
+    resting[idx] = resting.back();
+    resting.pop_back();
+  };
+
+  while (stream.size() + resting.size() < MESSAGES)
+  {
+    if (resting.empty() || rng() % 2)
+    {
+      const Resting order = { next_id++, 1 + static_cast<uint32_t>(rng() % books_count), (rng() % 2) ? 'S' : 'B', 1 + rng() % 100 };
+      const int32_t offset = rng() % PRICE_LEVELS;
+
+      MessageData &data = stream.emplace_back();
+      data.type = 'A';
+      data.new_order.order_id = order.id;
+      data.new_order.orderbook_id = order.book;
+      data.new_order.side = order.side;
+      data.new_order.quantity = order.qty;
+      data.new_order.price = (order.side == 'S') ? 1000 + offset : 999 - offset;
+
+      resting.push_back(order);
+    }
+    else
+      remove(rng() % resting.size(), rng() % 4 == 0);
+  }
+
+  while (!resting.empty())
+    remove(resting.size() - 1, false);
+
+  return stream;
+}
+
+int main(void)
+{
+  std::mt19937 rng(42);
+  const PerfCounters perf;
+
+  std::printf("per message, %u messages replayed %u times\n", MESSAGES, ROUNDS);
+  std::printf("%8s %14s %14s %10s\n", "books", "instructions", "branch misses", "ns");
+
+  for (const uint32_t books_count : BOOK_COUNTS)
+  {
+    const std::vector<MessageData> stream = makeStream(books_count, rng);
+
+    MessageHandler handler;
+    for (uint32_t id = 1; id <= books_count; ++id)
+      handler.addOrderBook(id);
+
+    //one warm round grows every pool and index to its working size
+    for (const MessageData &data : stream)
+      handler.handleMessage(data);
+
+    std::array<uint64_t, 2> events{};
+    std::chrono::nanoseconds elapsed{0};
+
+    for (uint32_t round = 0; round < ROUNDS; ++round)
+    {
+      perf.start();
+      const auto start = std::chrono::steady_clock::now();
+
+      for (const MessageData &data : stream)
+        handler.handleMessage(data);
+
+      elapsed += std::chrono::steady_clock::now() - start;
+      const std::array<uint64_t, 2> round_events = perf.stop();
+      events[0] += round_events[0];
+      events[1] += round_events[1];
+    }
+
+    const double messages = static_cast<double>(stream.size()) * ROUNDS;
+    const double ns = elapsed.count() / messages;
+
+    if (perf.isAvailable())
+      std::printf("%8u %14.1f %14.3f %10.1f\n", books_count, events[0] / messages, events[1] / messages, ns);
+    else
+      std::printf("%8u %14s %14s %10.1f\n", books_count, "n/a", "n/a", ns);
+
+    const OrderPool::Stats pool = handler.getPoolStats();
+    if (pool.orders != 0)
+    {
+      std::fprintf(stderr, "%zu orders left in the books\n", pool.orders);
+      return 1;
+    }
+  }
+}
@@ -0,0 +1,205 @@
+/*================================================================================
+
+File: bench_listener.cpp                                                        
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-29 11:21:06                                                 
+last edited: 2025-06-29 11:21:06                                                
+
+================================================================================*/
+
+//time per message through MessageHandler without a listener, with one that only wants the touch and with
+//one that wants every event. The events of the last one are checked against the stream, which leaves
+//every book empty
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "MessageHandler.tpp"
+#include "Packets.hpp"
+
+volatile bool error = false;
+
+static constexpr uint32_t MESSAGES = 1 << 16;
+static constexpr uint32_t ROUNDS = 32;
+static constexpr uint32_t PRICE_LEVELS = 16;
+static constexpr uint32_t BOOKS_COUNT = 64;
+
+struct TouchListener : BookListener
+{
+  uint64_t changes = 0;
+
+  void onBboChanged(UNUSED const uint32_t orderbook_id, UNUSED const int32_t bid_price, UNUSED const uint64_t bid_qty, UNUSED const int32_t ask_price, UNUSED const uint64_t ask_qty) noexcept
+  {
+    changes++;
+  }
+};
+
+struct CountingListener : BookListener
+{
+  uint64_t added = 0;
+  uint64_t removed = 0;
+  uint64_t executed = 0;
+  uint64_t added_qty = 0;
+  uint64_t left_qty = 0;
+  uint64_t levels = 0;
+  uint64_t changes = 0;
+
+  void onOrderAdded(UNUSED const uint32_t orderbook_id, UNUSED const uint8_t side, UNUSED const uint64_t order_id, UNUSED const int32_t price, const uint64_t qty) noexcept
+  {
+    added++;
+    added_qty += qty;
+  }
+
+  void onOrderRemoved(UNUSED const uint32_t orderbook_id, UNUSED const uint8_t side, UNUSED const uint64_t order_id, UNUSED const int32_t price, const uint64_t qty) noexcept
+  {
+    removed++;
+    left_qty += qty;
+  }
+
+  void onOrderExecuted(UNUSED const uint32_t orderbook_id, UNUSED const uint8_t side, UNUSED const uint64_t order_id, UNUSED const int32_t price, const uint64_t qty) noexcept
+  {
+    executed++;
+    left_qty += qty;
+  }
+
+  void onLevelCreated(UNUSED const uint32_t orderbook_id, UNUSED const uint8_t side, UNUSED const int32_t price) noexcept
+  {
+    levels++;
+  }
+
+  void onLevelRemoved(UNUSED const uint32_t orderbook_id, UNUSED const uint8_t side, UNUSED const int32_t price) noexcept
+  {
+    levels--;
+  }
+
+  void onBboChanged(UNUSED const uint32_t orderbook_id, UNUSED const int32_t bid_price, UNUSED const uint64_t bid_qty, UNUSED const int32_t ask_price, UNUSED const uint64_t ask_qty) noexcept
+  {
+    changes++;
+  }
+};
+
+template class BasicMessageHandler<TouchListener>;
+template class BasicMessageHandler<CountingListener>;
+
+//every order added is deleted or fully executed by the end
+static std::vector<MessageData> makeStream(std::mt19937 &rng)
+{
+  struct Resting
+  {
+    uint64_t id;
+    uint32_t book;
+    char side;
+    uint64_t qty;
+  };
+
+  std::vector<MessageData> stream;
+  std::vector<Resting> resting;
+  uint64_t next_id = 1;
+
+  stream.reserve(MESSAGES);
+
+  const auto remove = [&](const size_t idx, const bool executed)
+  {
+    const Resting order = resting[idx];
+    MessageData &data = stream.emplace_back();
+
+    if (executed)
+    {
+      data.type = 'E';
+      data.execution_notice.order_id = order.id;
+      data.execution_notice.orderbook_id = order.book;
+      data.execution_notice.side = order.side;
+      data.execution_notice.executed_quantity = order.qty;
+    }
+    else
+    {
+      data.type = 'D';
+      data.deleted_order.order_id = order.id;
+      data.deleted_order.orderbook_id = order.book;
+      data.deleted_order.side = order.side;
+    }
+
+    resting[idx] = resting.back();
+    resting.pop_back();
+  };
+
+  while (stream.size() + resting.size() < MESSAGES)
+  {
+    if (resting.empty() || rng() % 2)
+    {
+      const Resting order = { next_id++, 1 + static_cast<uint32_t>(rng() % BOOKS_COUNT), (rng() % 2) ? 'S' : 'B', 1 + rng() % 100 };
+      const int32_t offset = rng() % PRICE_LEVELS;
+
+      MessageData &data = stream.emplace_back();
+      data.type = 'A';
+      data.new_order.order_id = order.id;
+      data.new_order.orderbook_id = order.book;
+      data.new_order.side = order.side;
+      data.new_order.quantity = order.qty;
+      data.new_order.price = (order.side == 'S') ? 1000 + offset : 999 - offset;
+
+      resting.push_back(order);
+    }
+    else
+      remove(rng() % resting.size(), rng() % 4 == 0);
+  }
+
+  while (!resting.empty())
+    remove(resting.size() - 1, false);
+
+  return stream;
+}
+
+template <typename Listener>
+static Listener run(const char *name, const std::vector<MessageData> &stream)
+{
+  BasicMessageHandler<Listener> handler;
+  for (uint32_t id = 1; id <= BOOKS_COUNT; ++id)
+    handler.addOrderBook(id);
+
+  //one warm round grows every pool and index to its working size
+  for (const MessageData &data : stream)
+    handler.handleMessage(data);
+
+  const Listener warm = handler.getListener();
+  const auto start = std::chrono::steady_clock::now();
+
+  for (uint32_t round = 0; round < ROUNDS; ++round)
+    for (const MessageData &data : stream)
+      handler.handleMessage(data);
+
+  const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+  std::printf("%10s %10.1f\n", name, elapsed.count() / (static_cast<double>(stream.size()) * ROUNDS));
+
+  return warm;
+}
+
+int main(void)
+{
+  std::mt19937 rng(42);
+  const std::vector<MessageData> stream = makeStream(rng);
+
+  std::printf("per message, %u messages over %u books replayed %u times\n", MESSAGES, BOOKS_COUNT, ROUNDS);
+  std::printf("%10s %10s\n", "listener", "ns");
+
+  run<NoListener>("none", stream);
+  const TouchListener touch = run<TouchListener>("touch", stream);
+  const CountingListener all = run<CountingListener>("all", stream);
+
+  uint64_t adds = 0;
+  for (const MessageData &data : stream)
+    adds += (data.type == 'A');
+
+  const bool consistent = (all.added == adds) & (all.removed + all.executed == adds)
+    & (all.added_qty == all.left_qty) & (all.levels == 0) & (all.changes == touch.changes);
+
+  if (!consistent)
+  {
+    std::fprintf(stderr, "listener events do not match the stream\n");
+    return 1;
+  }
+}
@@ -0,0 +1,257 @@
+/*================================================================================
+
+File: bench_receive.cpp                                                         
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-14 10:03:37                                                 
+last edited: 2025-06-14 10:03:37                                                
+
+================================================================================*/
+
+//recvmmsg against io_uring multishot receives on loopback: syscalls per second and packet handling latency,
+//from the send stamp carried in the session field to the packet applied to the books.
+//usage: bench_receive <capture> [packets per second]
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "IoUring.hpp"
+#include "MessageHandler.hpp"
+#include "Packets.hpp"
+
+volatile bool error = false;
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr uint64_t STOP_SEQUENCE = UINT64_MAX;
+
+struct Result
+{
+  uint64_t packets;
+  uint64_t syscalls;
+  double seconds;
+  std::vector<uint64_t> latencies_ns;
+};
+
+static std::vector<std::vector<char>> load(const char *path)
+{
+  std::vector<std::vector<char>> packets;
+  FILE *file = std::fopen(path, "rb");
+  if (file == nullptr)
+    return packets;
+
+  uint8_t length_be[2];
+  while (std::fread(length_be, 1, 2, file) == 2)
+  {
+    std::vector<char> packet((length_be[0] << 8) | length_be[1]);
+    if (std::fread(packet.data(), 1, packet.size(), file) != packet.size())
+      break;
+    packets.push_back(std::move(packet));
+  }
+
+  std::fclose(file);
+  return packets;
+}
+
+static void setupBooks(const std::vector<std::vector<char>> &packets, MessageHandler &handler)
+{
+  std::unordered_set<uint32_t> ids;
+
+  for (const auto &packet : packets)
+  {
+    const MoldUDP64Header &header = *reinterpret_cast<const MoldUDP64Header *>(packet.data());
+    const char *payload = packet.data() + sizeof(MoldUDP64Header);
+    for (uint16_t i = 0; i < header.message_count && header.message_count != UINT16_MAX; ++i)
+    {
+      const MessageBlock &block = *reinterpret_cast<const MessageBlock *>(payload);
+      if (block.data.type == 'R')
+        ids.insert(block.data.series_info_basic.orderbook_id);
+      payload += sizeof(block.length) + block.length;
+    }
+  }
+
+  for (const uint32_t id : ids)
+    handler.addBookId(id);
+}
+
+//the send time replaces the session, the stop packet is repeated in case one is dropped
+static void publish(const std::vector<std::vector<char>> &packets, const sockaddr_in &address, const uint64_t rate)
+{
+  const int sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  const auto interval = std::chrono::nanoseconds(1000000000 / rate);
+  auto next = Clock::now();
+
+  for (std::vector<char> packet : packets)
+  {
+    next += interval;
+    std::this_thread::sleep_until(next);
+
+    const uint64_t stamp = Clock::now().time_since_epoch().count();
+    std::memcpy(packet.data(), &stamp, sizeof(stamp));
+    sendto(sock_fd, packet.data(), packet.size(), 0, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+  }
+
+  MoldUDP64Header stop{};
+  stop.sequence_number = STOP_SEQUENCE;
+  for (int i = 0; i < 16; ++i)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    sendto(sock_fd, &stop, sizeof(stop), 0, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+  }
+
+  close(sock_fd);
+}
+
+//applies one packet, false on the stop packet
+static bool handle(MessageHandler &handler, const MoldUDP64Packet &packet, Result &result)
+{
+  if (packet.header.sequence_number == STOP_SEQUENCE)
+    return false;
+
+  const uint16_t message_count = packet.header.message_count;
+  if (message_count != UINT16_MAX)
+    handler.handleMessageBlocks(packet.payload, message_count);
+
+  uint64_t stamp;
+  std::memcpy(&stamp, packet.header.session, sizeof(stamp));
+  result.latencies_ns.push_back(Clock::now().time_since_epoch().count() - stamp);
+  result.packets++;
+  return true;
+}
+
+static void receiveRecvmmsg(const int sock_fd, MessageHandler &handler, Result &result)
+{
+  mmsghdr mmsgs[MAX_BURST_PACKETS]{};
+  iovec iov[MAX_BURST_PACKETS];
+  static MoldUDP64Packet packets[MAX_BURST_PACKETS];
+
+  for (int i = 0; i < MAX_BURST_PACKETS; ++i)
+  {
+    iov[i] = { &packets[i], sizeof(MoldUDP64Packet) };
+    mmsgs[i].msg_hdr.msg_iov = &iov[i];
+    mmsgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  while (true)
+  {
+    const int packets_count = recvmmsg(sock_fd, mmsgs, MAX_BURST_PACKETS, MSG_WAITFORONE, nullptr);
+    result.syscalls++;
+
+    for (int i = 0; i < packets_count; ++i)
+      if (!handle(handler, packets[i], result))
+        return;
+  }
+}
+
+static void receiveUring(const int sock_fd, const bool sqpoll, MessageHandler &handler, Result &result)
+{
+  IoUring uring(sqpoll);
+  msghdr msg{};
+  bool running = true;
+
+  uring.open();
+  uring.setupBuffers(0, URING_FEED_BUFFERS, URING_FEED_BUFFER_SIZE);
+  uring.recvmsgMultishot(sock_fd, msg, 0, 0);
+  uring.submit();
+
+  while (running)
+  {
+    uring.wait(URING_SPIN_LIMIT);
+    uring.forEachCompletion([&](const io_uring_cqe &cqe)
+    {
+      if (cqe.flags & IORING_CQE_F_BUFFER)
+      {
+        const uint16_t id = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+        const char *const buffer = uring.getBuffer(0, id);
+        running &= handle(handler, *reinterpret_cast<const MoldUDP64Packet *>(buffer + sizeof(io_uring_recvmsg_out)), result);
+        uring.recycleBuffer(0, id);
+      }
+
+      if (!(cqe.flags & IORING_CQE_F_MORE) && running)
+      {
+        uring.recvmsgMultishot(sock_fd, msg, 0, 0);
+        uring.submit();
+      }
+    });
+  }
+
+  result.syscalls = uring.getEnters();
+}
+
+template <typename Receive>
+static Result run(const std::vector<std::vector<char>> &packets, const uint64_t rate, Receive &&receive)
+{
+  MessageHandler handler;
+  setupBooks(packets, handler);
+
+  const int sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  constexpr int recv_bufsize = SOCK_BUFSIZE;
+  setsockopt(sock_fd, SOL_SOCKET, SO_RCVBUF, &recv_bufsize, sizeof(recv_bufsize));
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t address_size = sizeof(address);
+  bind(sock_fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+  getsockname(sock_fd, reinterpret_cast<sockaddr *>(&address), &address_size);
+
+  Result result{};
+  result.latencies_ns.reserve(packets.size());
+
+  std::thread publisher(publish, std::cref(packets), address, rate);
+  const auto start = Clock::now();
+  receive(sock_fd, handler, result);
+  result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  publisher.join();
+
+  close(sock_fd);
+  return result;
+}
+
+static void print(const char *name, Result &result)
+{
+  std::sort(result.latencies_ns.begin(), result.latencies_ns.end());
+  const auto percentile = [&](const double p) { return result.latencies_ns.empty() ? 0 : result.latencies_ns[(result.latencies_ns.size() - 1) * p]; };
+
+  std::printf("%-14s %10lu %12lu %14.0f %10lu %10lu %10lu\n", name, result.packets, result.syscalls, result.syscalls / result.seconds,
+    percentile(0.5), percentile(0.99), percentile(0.999));
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    std::fprintf(stderr, "usage: %s <capture> [packets per second]\n", argv[0]);
+    return 1;
+  }
+
+  const std::vector<std::vector<char>> packets = load(argv[1]);
+  const uint64_t rate = (argc > 2) ? std::stoull(argv[2]) : 100000;
+
+  if (packets.empty())
+    return 1;
+
+  std::printf("%zu packets at %lu packets/s, latency from send to books applied, ns\n", packets.size(), rate);
+  std::printf("%-14s %10s %12s %14s %10s %10s %10s\n", "backend", "packets", "syscalls", "syscalls/s", "p50", "p99", "p99.9");
+
+  Result recvmmsg_result = run(packets, rate, receiveRecvmmsg);
+  print("recvmmsg", recvmmsg_result);
+
+  Result uring_result = run(packets, rate, [](const int sock_fd, MessageHandler &handler, Result &result) { receiveUring(sock_fd, false, handler, result); });
+  print("uring", uring_result);
+
+  Result sqpoll_result = run(packets, rate, [](const int sock_fd, MessageHandler &handler, Result &result) { receiveUring(sock_fd, true, handler, result); });
+  print("uring sqpoll", sqpoll_result);
+}
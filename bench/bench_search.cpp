@@ -0,0 +1,194 @@
+/*================================================================================
+
+File: bench_search.cpp                                                          
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-15 18:22:40                                                 
+last edited: 2025-05-15 18:22:40                                                
+
+================================================================================*/
+
+//lookup latency of the linear and binary search strategies, per element type, size and match position
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "utils/utils.hpp"
+
+volatile bool error = false;
+
+static constexpr size_t KEYS_COUNT = 256;
+static constexpr size_t SCANNED_PER_RUN = 1 << 22;
+static constexpr std::array<size_t, 15> SIZES = {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 4096, 16384, 65536, 100000};
+
+enum Position : uint8_t { NEAR_END, MIDDLE, MISSING };
+static constexpr std::array<const char *, 3> POSITION_NAMES = {"end", "middle", "missing"};
+
+//every strategy answers the same question: index of key in a sorted array, -1 if it is not there
+template <typename T>
+struct Strategies
+{
+  static ssize_t findIf(std::span<const T> data, const T key)
+  {
+    const auto it = std::find_if(data.begin(), data.end(), [key](const T value) { return value == key; });
+    return (it != data.end()) ? it - data.begin() : -1;
+  }
+
+  static ssize_t reverseFindIf(std::span<const T> data, const T key)
+  {
+    const auto it = std::find_if(data.rbegin(), data.rend(), [key](const T value) { return value == key; });
+    return (it != data.rend()) ? data.rend() - it - 1 : -1;
+  }
+
+  static ssize_t forward(std::span<const T> data, const T key)
+  {
+    return utils::forward_lower_bound(data, key, std::equal_to<T>{});
+  }
+
+  static ssize_t backward(std::span<const T> data, const T key)
+  {
+    return utils::backward_lower_bound(data, key, std::equal_to<T>{});
+  }
+
+  static ssize_t forwardAvx2(std::span<const T> data, const T key)
+  {
+    return utils::avx2::forward_lower_bound(data, key, std::equal_to<T>{});
+  }
+
+  static ssize_t backwardAvx2(std::span<const T> data, const T key)
+  {
+    return utils::avx2::backward_lower_bound(data, key, std::equal_to<T>{});
+  }
+
+  static ssize_t lowerBound(std::span<const T> data, const T key)
+  {
+    const auto it = std::lower_bound(data.begin(), data.end(), key);
+    return (it != data.end() && *it == key) ? it - data.begin() : -1;
+  }
+
+  static ssize_t binary(std::span<const T> data, const T key)
+  {
+    const size_t idx = utils::binary_lower_bound(data, key, std::less<T>{});
+    return (idx < data.size() && data[idx] == key) ? static_cast<ssize_t>(idx) : -1;
+  }
+};
+
+//forward and backward go through the runtime dispatch, the avx2 columns call those kernels directly
+static constexpr size_t STRATEGIES_COUNT = 8;
+static constexpr std::array<const char *, STRATEGIES_COUNT> STRATEGY_NAMES = {"find_if", "rfind_if", "forward", "backward", "fwd_avx2", "bwd_avx2", "lower_bound", "branchless"};
+
+template <typename T>
+static std::vector<T> makeKeys(const std::vector<T> &data, const Position position, std::mt19937 &rng)
+{
+  const size_t size = data.size();
+  std::vector<T> keys(KEYS_COUNT);
+
+  for (T &key : keys)
+  {
+    switch (position)
+    {
+      case NEAR_END:
+        key = data[size - 1 - rng() % std::min<size_t>(size, 8)];
+        break;
+      case MIDDLE:
+        key = data[size / 2 - std::min<size_t>(size / 2, rng() % 8)];
+        break;
+      case MISSING:
+        //values are even, odd keys fall between two of them
+        key = data[rng() % size] + 1;
+        break;
+    }
+  }
+
+  return keys;
+}
+
+template <typename T, typename Strategy>
+static double timeStrategy(const std::vector<T> &data, const std::vector<T> &keys, Strategy strategy)
+{
+  const std::span<const T> span{data};
+  const size_t runs = std::max<size_t>(1, SCANNED_PER_RUN / (KEYS_COUNT * data.size()));
+  ssize_t sink = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t run = 0; run < runs; ++run)
+  {
+    for (const T key : keys)
+    {
+      sink += strategy(span, key);
+      asm volatile("" : "+r"(sink));
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::nano>(end - start).count() / (runs * keys.size());
+}
+
+template <typename T>
+static void benchType(const char *type_name)
+{
+  using S = Strategies<T>;
+  static constexpr std::array<ssize_t (*)(std::span<const T>, const T), STRATEGIES_COUNT> strategies = {
+    S::findIf, S::reverseFindIf, S::forward, S::backward, S::forwardAvx2, S::backwardAvx2, S::lowerBound, S::binary
+  };
+
+  std::mt19937 rng(sizeof(T));
+
+  std::printf("\n%s\n%8s %-8s", type_name, "size", "match");
+  for (const char *name : STRATEGY_NAMES)
+    std::printf(" %11s", name);
+  std::printf("  %s\n", "fastest");
+
+  for (const size_t size : SIZES)
+  {
+    std::vector<T> data(size);
+    for (size_t i = 0; i < size; ++i)
+      data[i] = static_cast<T>(2 * i + 2);
+
+    for (const Position position : {NEAR_END, MIDDLE, MISSING})
+    {
+      const std::vector<T> keys = makeKeys(data, position, rng);
+
+      for (const T key : keys)
+      {
+        const ssize_t expected = S::lowerBound(data, key);
+        for (size_t i = 0; i < strategies.size(); ++i)
+        {
+          const ssize_t got = strategies[i](data, key);
+          if (got != expected)
+          {
+            std::fprintf(stderr, "%s %s: size %zu key %lu returned %zd, expected %zd\n", type_name, STRATEGY_NAMES[i], size, static_cast<uint64_t>(key), got, expected);
+            std::exit(1);
+          }
+        }
+      }
+
+      std::array<double, STRATEGIES_COUNT> ns;
+      for (size_t i = 0; i < strategies.size(); ++i)
+        ns[i] = timeStrategy(data, keys, strategies[i]);
+
+      std::printf("%8zu %-8s", size, POSITION_NAMES[position]);
+      for (const double value : ns)
+        std::printf(" %11.2f", value);
+      std::printf("  %s\n", STRATEGY_NAMES[std::min_element(ns.begin(), ns.end()) - ns.begin()]);
+    }
+  }
+}
+
+int main(void)
+{
+  static constexpr std::array<const char *, utils::simd::ISA_COUNT> isa_names = {"baseline", "avx2", "avx512"};
+
+  std::printf("ns per lookup, hot cache, dispatched kernels: %s\n", isa_names[utils::simd::isa]);
+  benchType<int32_t>("int32_t (prices)");
+  benchType<uint64_t>("uint64_t (order ids)");
+  benchType<uint32_t>("uint32_t (orderbook ids)");
+}
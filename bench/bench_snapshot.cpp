@@ -0,0 +1,83 @@
+/*================================================================================
+
+File: bench_snapshot.cpp                                                        
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-25 10:24:51                                                 
+last edited: 2025-06-25 10:24:51                                                
+
+================================================================================*/
+
+//snapshot load time of one deep book, order by order against the bulk load
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "OrderBook.hpp"
+
+volatile bool error = false;
+
+static constexpr uint32_t ORDERS_PER_LEVEL = 4;
+static constexpr int32_t MID_PRICE = 1000000;
+
+//both sides around the mid, in random arrival order as a snapshot lists them
+static std::vector<OrderBook::BulkOrder> makeSnapshot(const uint32_t depth)
+{
+  std::vector<OrderBook::BulkOrder> orders;
+  std::mt19937 rng(depth);
+
+  for (uint32_t level = 0; level < depth; ++level)
+    for (uint32_t i = 0; i < ORDERS_PER_LEVEL; ++i)
+    {
+      const uint64_t id = orders.size() + 1;
+      orders.push_back({ id, 100 + rng() % 100, MID_PRICE - 1 - static_cast<int32_t>(level), OrderBook::BID });
+      orders.push_back({ id + 1, 100 + rng() % 100, MID_PRICE + 1 + static_cast<int32_t>(level), OrderBook::ASK });
+    }
+
+  std::shuffle(orders.begin(), orders.end(), rng);
+  return orders;
+}
+
+static bool sameTop(const OrderBook &a, const OrderBook &b, const uint32_t depth)
+{
+  std::vector<int32_t> a_prices(depth), b_prices(depth);
+  std::vector<uint64_t> a_qtys(depth), b_qtys(depth);
+
+  for (const OrderBook::Side side : { OrderBook::BID, OrderBook::ASK })
+  {
+    a.copyTopLevels(side, a_prices.data(), a_qtys.data(), depth);
+    b.copyTopLevels(side, b_prices.data(), b_qtys.data(), depth);
+    if (a_prices != b_prices || a_qtys != b_qtys)
+      return false;
+  }
+
+  return a.getPoolStats().orders == b.getPoolStats().orders;
+}
+
+int main(void)
+{
+  static constexpr uint32_t depths[] = { 100, 1000, 10000, 50000 };
+
+  std::printf("%10s %10s %14s %14s %8s\n", "depth", "orders", "one by one ms", "bulk ms", "same");
+  for (const uint32_t depth : depths)
+  {
+    std::vector<OrderBook::BulkOrder> orders = makeSnapshot(depth);
+
+    OrderBook one_by_one;
+    auto start = std::chrono::steady_clock::now();
+    for (const OrderBook::BulkOrder &order : orders)
+      one_by_one.addOrder(order.id, order.side, order.price, order.qty);
+    const std::chrono::duration<double, std::milli> adds = std::chrono::steady_clock::now() - start;
+
+    OrderBook bulk;
+    start = std::chrono::steady_clock::now();
+    bulk.bulkLoad(orders);
+    const std::chrono::duration<double, std::milli> load = std::chrono::steady_clock::now() - start;
+
+    std::printf("%10u %10zu %14.2f %14.2f %8s\n", depth, orders.size(), adds.count(), load.count(), sameTop(one_by_one, bulk, depth) ? "yes" : "no");
+  }
+}
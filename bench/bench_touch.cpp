@@ -0,0 +1,98 @@
+/*================================================================================
+
+File: bench_touch.cpp                                                           
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-27 09:48:13                                                 
+last edited: 2025-06-27 09:48:13                                                
+
+================================================================================*/
+
+//top of book reads and touch updates spread over many deep books, where the books no longer fit in the caches
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "OrderBook.hpp"
+
+volatile bool error = false;
+
+static constexpr uint32_t DEPTH = 64;
+static constexpr uint32_t ORDERS_PER_LEVEL = 2;
+static constexpr uint32_t OPERATIONS = 1 << 20;
+static constexpr int32_t MID_PRICE = 1000000;
+static constexpr uint64_t ORDER_QTY = 100;
+
+//levels on both sides, ids are book local
+static std::vector<OrderBook> makeBooks(const uint32_t books_count)
+{
+  std::vector<OrderBook> books(books_count);
+
+  for (OrderBook &book : books)
+    for (uint32_t level = 0; level < DEPTH; ++level)
+      for (uint32_t i = 0; i < ORDERS_PER_LEVEL; ++i)
+      {
+        const uint64_t id = 2 * (level * ORDERS_PER_LEVEL + i) + 1;
+        book.addOrder(id, OrderBook::BID, MID_PRICE - 1 - level, ORDER_QTY);
+        book.addOrder(id + 1, OrderBook::ASK, MID_PRICE + 1 + level, ORDER_QTY);
+      }
+
+  return books;
+}
+
+//best prices and quantities of both sides of a random book
+static double benchReads(const std::vector<OrderBook> &books, const std::vector<uint32_t> &picks)
+{
+  uint64_t sink = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (const uint32_t pick : picks)
+  {
+    const OrderBook &book = books[pick];
+    sink += book.getBestBidPrice() + book.getBestAskPrice() + book.getBestBidQty() + book.getBestAskQty();
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  std::printf("%s", sink == 42 ? " " : "");
+  return std::chrono::duration<double, std::nano>(end - start).count() / picks.size();
+}
+
+//an order added at a new level inside the spread of a random book and removed again
+static double benchTouchUpdates(std::vector<OrderBook> &books, const std::vector<uint32_t> &picks)
+{
+  static constexpr uint64_t id = UINT32_MAX;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (const uint32_t pick : picks)
+  {
+    OrderBook &book = books[pick];
+    book.addOrder(id, OrderBook::BID, MID_PRICE, ORDER_QTY);
+    book.removeOrder(id, OrderBook::BID);
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::nano>(end - start).count() / picks.size();
+}
+
+int main(void)
+{
+  static constexpr uint32_t books_counts[] = { 16, 256, 4096, 16384 };
+
+  std::printf("%10s %12s %14s\n", "books", "ns/read", "ns/add+remove");
+  for (const uint32_t books_count : books_counts)
+  {
+    std::vector<OrderBook> books = makeBooks(books_count);
+    std::mt19937 rng(books_count);
+
+    std::vector<uint32_t> picks(OPERATIONS);
+    for (uint32_t &pick : picks)
+      pick = rng() % books_count;
+
+    const double reads = benchReads(books, picks);
+    const double updates = benchTouchUpdates(books, picks);
+    std::printf("%10u %12.1f %14.1f\n", books_count, reads, updates);
+  }
+}
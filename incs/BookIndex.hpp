@@ -0,0 +1,65 @@
+/*================================================================================
+
+File: BookIndex.hpp                                                             
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-17 09:12:26                                                 
+last edited: 2025-05-17 09:12:26                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "Config.hpp"
+#include "macros.hpp"
+
+//flat lookup of whitelisted orderbook id -> position of its book.
+//ids are hashed into cache line sized buckets, the multiplier is searched when the table is built
+//so that no bucket overflows: rejecting an id reads one line, resolving it reads one more.
+//the whitelist is only known at startup, so the table is simply rebuilt on every new id.
+//orderbook ids are never 0, which is used to mark empty positions
+class BookIndex
+{
+  public:
+    static constexpr uint32_t NO_BOOK = UINT32_MAX;
+
+    BookIndex(void) noexcept;
+    ~BookIndex();
+
+    void insert(const uint32_t id);
+    inline bool contains(const uint32_t id) const noexcept;
+    inline uint32_t find(const uint32_t id) const noexcept;
+    inline void setBook(const uint32_t id, const uint32_t book_idx) noexcept;
+
+  private:
+    static constexpr uint8_t BUCKET_SIZE = CACHELINE_SIZE / sizeof(uint32_t);
+
+    struct alignas(CACHELINE_SIZE) Bucket
+    {
+      uint32_t ids[BUCKET_SIZE];
+    };
+
+    struct alignas(CACHELINE_SIZE) Slots
+    {
+      uint32_t books[BUCKET_SIZE];
+    };
+
+    inline size_t getBucket(const uint32_t id) const noexcept;
+    inline ssize_t getPosition(const size_t bucket_idx, const uint32_t id) const noexcept;
+    void rebuild(std::vector<uint32_t> &ids, std::vector<uint32_t> &books);
+    bool tryBuild(const std::vector<uint32_t> &ids, const std::vector<uint32_t> &books);
+
+    std::vector<Bucket> buckets;
+    std::vector<Slots> slots;
+    uint64_t multiplier;
+    uint8_t shift;
+    size_t size;
+};
+
+#include "BookIndex.inl"
@@ -0,0 +1,54 @@
+/*================================================================================
+
+File: BookIndex.inl                                                             
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-17 09:12:26                                                 
+last edited: 2025-05-17 09:12:26                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <functional>
+#include <span>
+
+#include "BookIndex.hpp"
+#include "utils/utils.hpp"
+#include "macros.hpp"
+
+HOT ALWAYS_INLINE inline size_t BookIndex::getBucket(const uint32_t id) const noexcept
+{
+  return (id * multiplier) >> shift;
+}
+
+HOT ALWAYS_INLINE inline ssize_t BookIndex::getPosition(const size_t bucket_idx, const uint32_t id) const noexcept
+{
+  static constexpr std::equal_to<uint32_t> comp{};
+  return utils::forward_lower_bound(std::span<const uint32_t>{buckets[bucket_idx].ids}, id, comp);
+}
+
+HOT ALWAYS_INLINE inline bool BookIndex::contains(const uint32_t id) const noexcept
+{
+  return (id != 0) & (getPosition(getBucket(id), id) != -1);
+}
+
+//position of the book in MessageHandler, NO_BOOK if the id is not whitelisted or its book does not exist yet
+HOT ALWAYS_INLINE inline uint32_t BookIndex::find(const uint32_t id) const noexcept
+{
+  const size_t bucket_idx = getBucket(id);
+  const ssize_t position = getPosition(bucket_idx, id);
+
+  //empty positions hold NO_BOOK, so id 0 resolves to nothing as well
+  return (position == -1) ? NO_BOOK : slots[bucket_idx].books[position];
+}
+
+COLD inline void BookIndex::setBook(const uint32_t id, const uint32_t book_idx) noexcept
+{
+  const size_t bucket_idx = getBucket(id);
+  const ssize_t position = getPosition(bucket_idx, id);
+
+  if (position != -1 && id != 0)
+    slots[bucket_idx].books[position] = book_idx;
+}
@@ -0,0 +1,44 @@
+/*================================================================================
+
+File: BookListener.hpp                                                          
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-20 11:14:52                                                 
+last edited: 2025-06-29 11:21:06                                                
+
+================================================================================*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "macros.hpp"
+
+//events of the books of a MessageHandler, raised on the thread running it right after the book changes.
+//A listener derives from BookListener and hides the events it wants, calls are resolved at compile time so
+//the others stay empty and vanish along with the book lookups they need. Sides are 0 for bids and 1 for asks
+struct BookListener
+{
+  inline void onOrderAdded(const uint32_t orderbook_id, const uint8_t side, const uint64_t order_id, const int32_t price, const uint64_t qty) noexcept;
+  inline void onOrderRemoved(const uint32_t orderbook_id, const uint8_t side, const uint64_t order_id, const int32_t price, const uint64_t qty) noexcept;
+  inline void onOrderExecuted(const uint32_t orderbook_id, const uint8_t side, const uint64_t order_id, const int32_t price, const uint64_t qty) noexcept;
+
+  inline void onLevelCreated(const uint32_t orderbook_id, const uint8_t side, const int32_t price) noexcept;
+  inline void onLevelRemoved(const uint32_t orderbook_id, const uint8_t side, const int32_t price) noexcept;
+
+  inline void onBboChanged(const uint32_t orderbook_id, const int32_t bid_price, const uint64_t bid_qty, const int32_t ask_price, const uint64_t ask_qty) noexcept;
+  inline void onEquilibriumUpdated(const uint32_t orderbook_id, const int32_t price, const uint64_t bid_qty, const uint64_t ask_qty) noexcept;
+};
+
+//whether a listener hides an event, the handler skips the lookups of the events nobody listens to
+#define LISTENS_TO(Listener, event) (!std::is_same_v<decltype(&Listener::event), decltype(&BookListener::event)>)
+
+//the default listener, the handler does not even look the events up
+struct NoListener : BookListener
+{
+};
+
+#include "BookListener.inl"
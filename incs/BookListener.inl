@@ -0,0 +1,46 @@
+/*================================================================================
+
+File: BookListener.inl                                                          
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-20 11:14:52                                                 
+last edited: 2025-06-20 11:14:52                                                
+
+================================================================================*/
+
+
+#pragma once
+
+#include "BookListener.hpp"
+#include "macros.hpp"
+
+//removed orders carry the qty they still had, executed ones the qty that traded
+
+HOT ALWAYS_INLINE inline void BookListener::onOrderAdded(UNUSED const uint32_t orderbook_id, UNUSED const uint8_t side, UNUSED const uint64_t order_id, UNUSED const int32_t price, UNUSED const uint64_t qty) noexcept
+{
+}
+
+HOT ALWAYS_INLINE inline void BookListener::onOrderRemoved(UNUSED const uint32_t orderbook_id, UNUSED const uint8_t side, UNUSED const uint64_t order_id, UNUSED const int32_t price, UNUSED const uint64_t qty) noexcept
+{
+}
+
+HOT ALWAYS_INLINE inline void BookListener::onOrderExecuted(UNUSED const uint32_t orderbook_id, UNUSED const uint8_t side, UNUSED const uint64_t order_id, UNUSED const int32_t price, UNUSED const uint64_t qty) noexcept
+{
+}
+
+HOT ALWAYS_INLINE inline void BookListener::onLevelCreated(UNUSED const uint32_t orderbook_id, UNUSED const uint8_t side, UNUSED const int32_t price) noexcept
+{
+}
+
+HOT ALWAYS_INLINE inline void BookListener::onLevelRemoved(UNUSED const uint32_t orderbook_id, UNUSED const uint8_t side, UNUSED const int32_t price) noexcept
+{
+}
+
+HOT ALWAYS_INLINE inline void BookListener::onBboChanged(UNUSED const uint32_t orderbook_id, UNUSED const int32_t bid_price, UNUSED const uint64_t bid_qty, UNUSED const int32_t ask_price, UNUSED const uint64_t ask_qty) noexcept
+{
+}
+
+HOT ALWAYS_INLINE inline void BookListener::onEquilibriumUpdated(UNUSED const uint32_t orderbook_id, UNUSED const int32_t price, UNUSED const uint64_t bid_qty, UNUSED const uint64_t ask_qty) noexcept
+{
+}
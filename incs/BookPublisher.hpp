@@ -0,0 +1,78 @@
+/*================================================================================
+
+File: BookPublisher.hpp                                                         
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-19 10:27:14                                                 
+last edited: 2025-06-19 10:27:14                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "Config.hpp"
+#include "macros.hpp"
+
+//publishes the top of every book to other processes, through a shared memory segment (shm_open name) of one
+//cache line aligned slot per book. Each slot is a seqlock: the writer makes the sequence odd, copies the book
+//and makes it even again, so it never waits. Readers retry until they copy a slot with the same even sequence
+//before and after. Books are published once per packet, after every message of it is applied
+class BookPublisher
+{
+  public:
+    static constexpr uint32_t MAGIC = 0x4b4f4f42; //"BOOK"
+    static constexpr uint32_t VERSION = 1;
+
+    struct alignas(CACHELINE_SIZE) Header
+    {
+      uint32_t magic;
+      uint32_t version;
+      uint32_t slots_count;
+      uint32_t depth;
+      uint32_t books_count;     //slots in use
+    };
+
+    struct Snapshot
+    {
+      uint32_t orderbook_id;
+      uint32_t levels_count[2];                  //bid, ask, up to BOOK_PUBLISH_DEPTH
+      int32_t prices[2][BOOK_PUBLISH_DEPTH];     //best first
+      uint64_t qtys[2][BOOK_PUBLISH_DEPTH];
+      int32_t equilibrium_price;
+      uint64_t equilibrium_bid_qty;
+      uint64_t equilibrium_ask_qty;
+      uint64_t updates;                          //packets that changed the book
+    };
+
+    struct alignas(CACHELINE_SIZE) Slot
+    {
+      uint64_t sequence;
+      Snapshot snapshot;
+    };
+
+    BookPublisher(const std::string &name, const uint32_t slots_count);
+    ~BookPublisher();
+
+    inline bool isEnabled(void) const noexcept;
+    Slot *claimSlot(const uint32_t orderbook_id);
+
+    template <typename Book>
+    void publish(Slot &slot, const Book &book) noexcept;
+
+    static inline bool read(const Slot &slot, Snapshot &snapshot) noexcept;
+    static constexpr size_t getSize(const uint32_t slots_count) noexcept;
+
+  private:
+    const std::string name;
+    const uint32_t slots_count;
+    char *mapping;
+    std::atomic<uint32_t> books_count;
+};
+
+#include "BookPublisher.inl"
+#include "BookPublisher.tpp"
@@ -0,0 +1,38 @@
+/*================================================================================
+
+File: BookPublisher.inl                                                         
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-19 10:27:14                                                 
+last edited: 2025-06-19 10:27:14                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstring>
+
+#include "BookPublisher.hpp"
+#include "macros.hpp"
+
+HOT ALWAYS_INLINE inline bool BookPublisher::isEnabled(void) const noexcept
+{
+  return mapping != nullptr;
+}
+
+constexpr size_t BookPublisher::getSize(const uint32_t slots_count) noexcept
+{
+  return sizeof(Header) + slots_count * sizeof(Slot);
+}
+
+//false when the slot was being written, the caller retries
+HOT inline bool BookPublisher::read(const Slot &slot, Snapshot &snapshot) noexcept
+{
+  const uint64_t before = __atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE);
+  std::memcpy(&snapshot, &slot.snapshot, sizeof(snapshot));
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  const uint64_t after = __atomic_load_n(&slot.sequence, __ATOMIC_RELAXED);
+
+  return (before == after) & !(before & 1);
+}
@@ -0,0 +1,38 @@
+/*================================================================================
+
+File: BookPublisher.tpp                                                         
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-19 10:27:14                                                 
+last edited: 2025-06-19 10:27:14                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstring>
+
+#include "BookPublisher.hpp"
+#include "macros.hpp"
+
+//the snapshot is built on the stack first, the slot is only odd for the copy
+template <typename Book>
+HOT void BookPublisher::publish(Slot &slot, const Book &book) noexcept
+{
+  Snapshot snapshot;
+  snapshot.orderbook_id = slot.snapshot.orderbook_id;
+  snapshot.levels_count[0] = book.copyTopLevels(Book::BID, snapshot.prices[0], snapshot.qtys[0], BOOK_PUBLISH_DEPTH);
+  snapshot.levels_count[1] = book.copyTopLevels(Book::ASK, snapshot.prices[1], snapshot.qtys[1], BOOK_PUBLISH_DEPTH);
+  snapshot.equilibrium_price = book.getEquilibriumPrice();
+  snapshot.equilibrium_bid_qty = book.getEquilibriumBidQty();
+  snapshot.equilibrium_ask_qty = book.getEquilibriumAskQty();
+  snapshot.updates = slot.snapshot.updates + 1;
+
+  const uint64_t sequence = slot.sequence;
+
+  __atomic_store_n(&slot.sequence, sequence + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  std::memcpy(&slot.snapshot, &snapshot, sizeof(snapshot));
+  __atomic_store_n(&slot.sequence, sequence + 2, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,76 @@
+/*================================================================================
+
+File: Checkpoint.hpp                                                            
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-03 09:27:51                                                 
+last edited: 2025-06-29 14:40:52                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "Config.hpp"
+#include "macros.hpp"
+
+#define CHECKPOINT_VERSION 4
+
+//binary checkpoint of the books and the last applied sequence number.
+//every array of a book is stored as its raw bytes in a cache line aligned section, so restoring a book
+//is one bulk copy per array straight out of the mapping, with no per order decoding.
+//checkpoints are only valid for the build that wrote them
+struct CheckpointHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t book_kind;       //sizeof the book type, so that checkpoints of the other book are rejected
+  uint64_t size;            //bytes, header included
+  uint64_t sequence_number; //next sequence to apply
+  char session[10];
+};
+
+class CheckpointWriter
+{
+  public:
+    CheckpointWriter(std::vector<char> &buffer) noexcept;
+
+    template <typename T>
+    inline void write(const T &value);
+    template <typename T>
+    inline void writeArray(const T *values, const size_t count);
+    template <typename T>
+    inline void writeArray(const std::vector<T> &values);
+
+  private:
+    inline char *reserve(const size_t size, const size_t alignment);
+
+    std::vector<char> &buffer;
+};
+
+class CheckpointReader
+{
+  public:
+    CheckpointReader(const char *data, const size_t size) noexcept;
+
+    template <typename T>
+    inline void read(T &value);
+    template <typename T>
+    inline void readArray(T *values, const size_t count);
+    template <typename T>
+    inline void readArray(std::vector<T> &values);
+
+  private:
+    inline const char *consume(const size_t size, const size_t alignment);
+
+    const char *const begin;
+    const char *cursor;
+    const char *const end;
+};
+
+#include "Checkpoint.tpp"
@@ -0,0 +1,95 @@
+/*================================================================================
+
+File: Checkpoint.tpp                                                            
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-03 09:27:51                                                 
+last edited: 2025-06-03 09:27:51                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstring>
+#include <type_traits>
+
+#include "Checkpoint.hpp"
+#include "error.hpp"
+#include "macros.hpp"
+
+COLD inline CheckpointWriter::CheckpointWriter(std::vector<char> &buffer) noexcept :
+  buffer(buffer)
+{
+}
+
+COLD inline char *CheckpointWriter::reserve(const size_t size, const size_t alignment)
+{
+  const size_t offset = (buffer.size() + alignment - 1) & ~(alignment - 1);
+
+  buffer.resize(offset + size);
+  return buffer.data() + offset;
+}
+
+template <typename T>
+COLD inline void CheckpointWriter::write(const T &value)
+{
+  static_assert(std::is_trivially_copyable_v<T>, "only raw bytes are checkpointed");
+  std::memcpy(reserve(sizeof(T), 1), &value, sizeof(T));
+}
+
+template <typename T>
+COLD inline void CheckpointWriter::writeArray(const T *values, const size_t count)
+{
+  static_assert(std::is_trivially_copyable_v<T>, "only raw bytes are checkpointed");
+  std::memcpy(reserve(count * sizeof(T), CACHELINE_SIZE), values, count * sizeof(T));
+}
+
+template <typename T>
+COLD inline void CheckpointWriter::writeArray(const std::vector<T> &values)
+{
+  write<uint64_t>(values.size());
+  writeArray(values.data(), values.size());
+}
+
+COLD inline CheckpointReader::CheckpointReader(const char *data, const size_t size) noexcept :
+  begin(data),
+  cursor(data),
+  end(data + size)
+{
+}
+
+COLD inline const char *CheckpointReader::consume(const size_t size, const size_t alignment)
+{
+  const size_t offset = (cursor - begin + alignment - 1) & ~(alignment - 1);
+
+  error |= (offset + size > static_cast<size_t>(end - begin));
+  CHECK_ERROR;
+
+  cursor = begin + offset + size;
+  return begin + offset;
+}
+
+template <typename T>
+COLD inline void CheckpointReader::read(T &value)
+{
+  static_assert(std::is_trivially_copyable_v<T>, "only raw bytes are checkpointed");
+  std::memcpy(&value, consume(sizeof(T), 1), sizeof(T));
+}
+
+template <typename T>
+COLD inline void CheckpointReader::readArray(T *values, const size_t count)
+{
+  static_assert(std::is_trivially_copyable_v<T>, "only raw bytes are checkpointed");
+  std::memcpy(values, consume(count * sizeof(T), CACHELINE_SIZE), count * sizeof(T));
+}
+
+template <typename T>
+COLD inline void CheckpointReader::readArray(std::vector<T> &values)
+{
+  uint64_t count;
+  read(count);
+
+  const T *data = reinterpret_cast<const T *>(consume(count * sizeof(T), CACHELINE_SIZE));
+  values.assign(data, data + count);
+}
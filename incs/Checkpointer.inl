@@ -0,0 +1,31 @@
+/*================================================================================
+
+File: Checkpointer.inl                                                          
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-03 09:27:51                                                 
+last edited: 2025-06-16 09:48:15                                                
+
+================================================================================*/
+
+#pragma once
+
+#include "Checkpointer.hpp"
+#include "macros.hpp"
+
+HOT ALWAYS_INLINE inline bool Checkpointer::isDue(void) const noexcept
+{
+  return state.load(std::memory_order_relaxed) == DUE;
+}
+
+COLD inline uint64_t Checkpointer::getFailures(void) const noexcept
+{
+  return failures.load(std::memory_order_relaxed);
+}
+
+//duration of the last serialization, which is how long a capture stalls the processing thread
+COLD inline uint64_t Checkpointer::getSerializeNs(void) const noexcept
+{
+  return serialize_ns.load(std::memory_order_relaxed);
+}
@@ -5,7 +5,7 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-03-23 17:58:46                                                 
-last edited: 2025-04-08 19:45:06                                                
+last edited: 2025-06-26 11:07:42                                                
 
 ================================================================================*/
 
@@ -14,9 +14,20 @@ last edited: 2025-04-08 19:45:06
 #include <cstdint>
 #include <string>
 #include <string_view>
+#include <vector>
 #include <netinet/in.h>
 
+#include "BookPublisher.hpp"
+#include "Checkpointer.hpp"
+#include "GapRecovery.hpp"
+#include "HotCounters.hpp"
+#include "IoUring.hpp"
+#include "LatencyStats.hpp"
+#include "LiveQueue.hpp"
+#include "PacketRing.hpp"
+#include "SoupBinTCPReader.hpp"
 #include "MessageHandler.hpp"
+#include "Workers.hpp"
 #include "Packets.hpp"
 #include "Config.hpp"
 
@@ -35,21 +46,48 @@ class Client
     int createTcpSocket(void) const noexcept;
     int createUdpSocket(void) const noexcept;
 
+    bool restoreCheckpoint(void);
     void fetchOrderbooks(void);
-    void syncSequences(void);
+    void fetchOrderbooksUring(void);
+    void bufferLive(void);
+    void replayBuffered(void);
     void updateOrderbooks(void);
+    void updateOrderbooksRing(void);
+    void updateOrderbooksUring(void);
+
+    void openUring(void);
+    void armFeed(void);
+    void rearmFeed(const io_uring_cqe &cqe);
+    const MoldUDP64Packet &getFeedPacket(const io_uring_cqe &cqe, uint16_t &size) const noexcept;
+    uint64_t getFeedTimestamp(const io_uring_cqe &cqe) const noexcept;
+    inline void stampPacket(const uint64_t nic_ns) noexcept;
+
+    using BlocksHandler = void (*)(Client &client, const char *restrict buffer, const uint16_t blocks_count);
+
+    void handleLivePacket(const MoldUDP64Packet &packet, const uint16_t size, const BlocksHandler handleBlocks);
+    void resyncFrom(const MoldUDP64Packet &packet, const uint16_t size, const BlocksHandler handleBlocks);
 
     void sendLogin(void) const;
     void recvLogin(void);
     void recvSnapshot(void);
+    void handleSnapshotPackets(void);
+    void handleSnapshotPacket(const SoupBinTCPPacket &packet);
     void sendLogout(void) const;
 
     void processSnapshots(const char *restrict buffer, const uint16_t length);
-    void processMessageBlocks(const char *restrict buffer, uint16_t blocks_count);
 
     void handleSnapshotCompletion(const MessageData &data);
 
+    static BlocksHandler getBlocksHandler(const bool sharded, const bool timed) noexcept;
+
+    //user data of the io_uring receives, FEED is also its buffer group
+    enum UringRequest : uint16_t { FEED, SNAPSHOT };
+
     static MessageHandler message_handler;
+    HotCounters counters;
+    BookPublisher publisher;
+    Workers workers;
+    const int16_t dispatcher_core;
     const std::string username;
     const std::string password;
     const sockaddr_in glimpse_address;
@@ -59,6 +97,17 @@ class Client
     const sockaddr_in bind_address_udp;
     const int tcp_sock_fd;
     const int udp_sock_fd;
+    const FeedBackend feed_backend;
+    const bool batch_bursts;
+    PacketRing packet_ring;
+    IoUring uring;
+    msghdr feed_msg;
+    GapRecovery recovery;
+    LiveQueue live_queue;
+    SoupBinTCPReader snapshot_reader;
+    LatencyStats latency;
+    LatencyStats::PacketStamps packet_stamps;
+    Checkpointer checkpointer;
     uint64_t sequence_number;
     enum Status { CONNECTING, FETCHING, UPDATING } status;
 };
\ No newline at end of file
@@ -5,24 +5,66 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-03-30 15:01:52                                                 
-last edited: 2025-05-03 19:03:11                                                
+last edited: 2025-06-29 09:12:44                                                
 
 ================================================================================*/
 
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #define MTU 1500
 #define SOCK_BUFSIZE 8388608
 #define MAX_BURST_PACKETS 32
+#define ORDER_INDEX_CAPACITY 2048
+#define LADDER_SIZE 1024
+#define PRICE_LEVELS_CAPACITY 1024
+#define HOT_LEVELS 8
+#define ORDER_POOL_CAPACITY 4096
+#define ORDER_QUEUE_MIN_CAPACITY 4
+#define WORKER_RING_CAPACITY 65536
+#define REORDER_BUFFER_PACKETS 4096
+#define LIVE_QUEUE_RESERVE 8192
+#define LIVE_QUEUE_CHUNK_PACKETS 1024
+#define SNAPSHOT_READ_SIZE 1048576
+#define SNAPSHOT_PARALLEL_ORDERS 65536
+#define LATENCY_SUB_BUCKET_BITS 4
+#define LATENCY_CALIBRATION_MS 20
+#define LATENCY_DUMP_POLL_MS 100
+#define HOT_COUNTERS_SAMPLE_INTERVAL 64
+#define BOOK_PUBLISH_DEPTH 5
+#define REWIND_REQUEST_MESSAGES 2048
+#define REWIND_TIMEOUT_US 20000
+#define PACKET_RING_BLOCK_SIZE 262144
+#define PACKET_RING_BLOCKS_COUNT 64
+#define PACKET_RING_FRAME_SIZE 2048
+#define PACKET_RING_BLOCK_TIMEOUT_MS 1
+#define URING_ENTRIES 64
+#define URING_CQ_ENTRIES 8192
+#define URING_BUFFER_GROUPS 1
+#define URING_FEED_BUFFERS 4096
+#define URING_FEED_BUFFER_SIZE 2048
+#define URING_SQPOLL_IDLE_MS 1000
+#define URING_SPIN_LIMIT 65536
 #define CACHELINE_SIZE std::hardware_constructive_interference_size
 
+enum class FeedBackend : uint8_t
+{
+  RECVMMSG,       //recvmmsg bursts on the udp socket
+  PACKET_RING,    //TPACKET_V3 ring on feed_interface
+  IO_URING,       //multishot receives, also used for the Glimpse snapshot
+  IO_URING_SQPOLL //same, with a kernel submission thread and completions polled from userspace
+};
+
 struct Config
 {
   std::string bind_ip;
   std::string multicast_ip;
   std::string multicast_port;
+  FeedBackend feed_backend;
+  std::string feed_interface;        //only used by PACKET_RING
 
   std::string rewind_ip;
   std::string rewind_port;
@@ -31,6 +73,21 @@ struct Config
   std::string glimpse_port;
 
   std::vector<uint32_t> book_ids;
+  std::vector<uint8_t> book_workers; //worker owning each of book_ids, round robin when empty
+
+  uint8_t workers_count;             //0 processes books on the receiving thread
+  bool batch_bursts;                 //recvmmsg bursts are decoded whole and applied book by book, only without workers and latency_stats
+  int16_t dispatcher_core;           //-1 leaves the thread unpinned
+  std::vector<int16_t> worker_cores;
+
+  std::string checkpoint_path;       //empty disables checkpoints, which only cover books processed on the receiving thread (workers_count == 0)
+  uint32_t checkpoint_interval_s;
+
+  std::string counters_name;         //shm_open name of the hot path counters read by tools/counters, empty keeps them private
+
+  std::string books_name;            //shm_open name of the books published to other processes (tools/books), empty disables publishing
+
+  bool latency_stats;                //kernel receive timestamps and per stage latency histograms, dumped on SIGUSR1
 
   std::string username;
   std::string password;
@@ -0,0 +1,82 @@
+/*================================================================================
+
+File: GapRecovery.hpp                                                           
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-24 11:12:47                                                 
+last edited: 2025-06-15 16:37:52                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <netinet/in.h>
+
+#include "Packets.hpp"
+#include "Config.hpp"
+#include "macros.hpp"
+
+//fills sequence gaps of the multicast feed from the Rewind (MoldUDP64 retransmission) server.
+//while a gap is open live packets are parked in a bounded FIFO, retransmitted messages are applied as they arrive
+//and the parked packets are replayed once they are contiguous again. packets which are already queued elsewhere
+//are recovered without parking the live feed, which then stays in the socket buffer. missing ranges are requested in chunks
+//of REWIND_REQUEST_MESSAGES and re-requested after REWIND_TIMEOUT_US without progress.
+//a full FIFO stops parking: later live packets stay in the socket and only open the next gap
+class GapRecovery
+{
+  public:
+    struct Stats
+    {
+      uint64_t gaps;             //gaps detected
+      uint64_t missed_messages;  //messages requested from Rewind over all gaps
+      uint64_t max_gap;          //largest gap, in messages
+      uint64_t requests;         //retransmission requests sent
+      uint64_t recovery_ns;      //total time spent with a gap open
+      uint64_t max_recovery_ns;  //longest single recovery
+      uint64_t overflows;        //packets left to a later gap because the FIFO was full
+    };
+
+    GapRecovery(const sockaddr_in &rewind_address, const sockaddr_in &bind_address, const int live_sock_fd);
+    ~GapRecovery();
+
+    template <typename Apply>
+    static bool applyFrom(const MoldUDP64Packet &packet, uint64_t &sequence_number, Apply &&apply);
+
+    template <typename Apply>
+    void recover(const std::span<const MoldUDP64Packet> pending, uint64_t &sequence_number, Apply &&apply, const bool park_live);
+
+    const Stats &getStats(void) const noexcept;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t PARKED_MASK = REORDER_BUFFER_PACKETS - 1;
+    static_assert((REORDER_BUFFER_PACKETS & PARKED_MASK) == 0, "REORDER_BUFFER_PACKETS must be a power of 2");
+
+    int createSocket(const sockaddr_in &bind_address) const;
+
+    inline bool isFull(void) const noexcept;
+    void park(const MoldUDP64Packet &packet);
+    void receiveLive(void);
+    bool receiveRetransmission(void);
+    void request(const uint64_t sequence_number, const uint64_t until);
+
+    const sockaddr_in rewind_address;
+    const int rewind_sock_fd;
+    const int live_sock_fd;
+    char session[sizeof(MoldUDP64Header::session)];
+    std::unique_ptr<MoldUDP64Packet[]> parked;
+    size_t parked_head;
+    size_t parked_tail;
+    MoldUDP64Packet retransmission;
+    uint64_t requested_until;
+    Clock::time_point request_time;
+    Stats stats;
+};
+
+#include "GapRecovery.tpp"
@@ -0,0 +1,94 @@
+/*================================================================================
+
+File: GapRecovery.tpp                                                           
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-24 11:12:47                                                 
+last edited: 2025-06-15 16:37:52                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+
+#include "GapRecovery.hpp"
+#include "macros.hpp"
+
+HOT inline bool GapRecovery::isFull(void) const noexcept
+{
+  return (parked_tail - parked_head == REORDER_BUFFER_PACKETS);
+}
+
+//applies the messages of packet past sequence_number, returns false when the packet starts beyond it
+template <typename Apply>
+HOT bool GapRecovery::applyFrom(const MoldUDP64Packet &packet, uint64_t &sequence_number, Apply &&apply)
+{
+  const uint64_t first = packet.header.sequence_number;
+  uint16_t message_count = packet.header.message_count;
+
+  //end of session
+  message_count *= (message_count != UINT16_MAX);
+
+  if (first > sequence_number)
+    return false;
+
+  if (first + message_count <= sequence_number)
+    return true;
+
+  const char *payload = packet.payload;
+  for (uint64_t sequence = first; sequence < sequence_number; ++sequence)
+  {
+    const MessageBlock &block = *reinterpret_cast<const MessageBlock *>(payload);
+    payload += sizeof(block.length) + block.length;
+  }
+
+  apply(payload, static_cast<uint16_t>(first + message_count - sequence_number));
+  sequence_number = first + message_count;
+  return true;
+}
+
+//pending starts with the packet that revealed the gap, followed by the ones already received after it
+template <typename Apply>
+COLD void GapRecovery::recover(const std::span<const MoldUDP64Packet> pending, uint64_t &sequence_number, Apply &&apply, const bool park_live)
+{
+  const Clock::time_point start = Clock::now();
+  const uint64_t missing = pending.front().header.sequence_number - sequence_number;
+
+  stats.gaps++;
+  stats.missed_messages += missing;
+  stats.max_gap = std::max(stats.max_gap, missing);
+
+  std::memcpy(session, pending.front().header.session, sizeof(session));
+  requested_until = sequence_number;
+
+  for (const MoldUDP64Packet &packet : pending)
+    park(packet);
+
+  while (parked_head != parked_tail)
+  {
+    const MoldUDP64Packet &front = parked[parked_head & PARKED_MASK];
+
+    if (applyFrom(front, sequence_number, apply))
+    {
+      parked_head++;
+      continue;
+    }
+
+    const bool timed_out = (Clock::now() - request_time > std::chrono::microseconds(REWIND_TIMEOUT_US));
+    if (sequence_number >= requested_until || timed_out)
+      request(sequence_number, front.header.sequence_number);
+
+    if (receiveRetransmission() && applyFrom(retransmission, sequence_number, apply))
+      request_time = Clock::now();
+
+    if (park_live)
+      receiveLive();
+  }
+
+  const uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+  stats.recovery_ns += elapsed;
+  stats.max_recovery_ns = std::max(stats.max_recovery_ns, elapsed);
+}
@@ -0,0 +1,75 @@
+/*================================================================================
+
+File: HotCounters.hpp                                                           
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-18 09:41:05                                                 
+last edited: 2025-06-18 09:41:05                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Config.hpp"
+#include "macros.hpp"
+
+//always on counters of the book processing, one slot per thread running a MessageHandler. The slots live in a
+//shared memory segment (shm_open name) that tools/counters reads while the handlers run, or in private memory
+//when the name is empty. Every counter has a single writer that updates it with a relaxed load and store, so a
+//reader can see a slot half way through a message but never a torn counter
+class HotCounters
+{
+  public:
+    static constexpr uint32_t MAGIC = 0x52544348; //"HCTR"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t TYPES = 'Z' + 1;
+    static constexpr uint32_t CYCLE_BUCKETS = 32;
+
+    struct alignas(CACHELINE_SIZE) Header
+    {
+      uint32_t magic;
+      uint32_t version;
+      uint32_t slots_count;
+      uint32_t sample_interval;
+    };
+
+    struct alignas(CACHELINE_SIZE) Slot
+    {
+      std::array<uint64_t, TYPES> messages;
+      uint64_t dropped;                   //book messages of books outside the whitelist
+      uint64_t new_levels;                //orders opening a price level
+      uint64_t existing_levels;           //orders joining one
+      uint64_t removed_levels;
+      std::array<uint64_t, 2> max_depth;  //price levels, per side
+
+      //one message every sample_interval is timed, bucket i counts the ones that took [2^i, 2^(i+1)) cycles
+      std::array<std::array<uint64_t, CYCLE_BUCKETS>, TYPES> cycles;
+    };
+
+    HotCounters(const std::string &name, const uint32_t slots_count);
+    ~HotCounters();
+
+    inline Slot &getSlot(const uint32_t idx) noexcept;
+
+    static inline void increment(uint64_t &counter, const uint64_t value = 1) noexcept;
+    static inline void raise(uint64_t &counter, const uint64_t value) noexcept;
+    static inline void recordCycles(Slot &slot, const uint8_t type, const uint64_t cycles) noexcept;
+
+    static constexpr size_t getSize(const uint32_t slots_count) noexcept;
+
+    //counters of handlers and books never bound to a slot, like the ones of the benches
+    static inline Slot unbound{};
+
+  private:
+    const std::string name;
+    const uint32_t slots_count;
+    char *mapping;
+};
+
+#include "HotCounters.inl"
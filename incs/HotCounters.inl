@@ -0,0 +1,43 @@
+/*================================================================================
+
+File: HotCounters.inl                                                           
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-18 09:41:05                                                 
+last edited: 2025-06-18 09:41:05                                                
+
+================================================================================*/
+
+#pragma once
+
+#include "HotCounters.hpp"
+#include "macros.hpp"
+
+HOT ALWAYS_INLINE inline HotCounters::Slot &HotCounters::getSlot(const uint32_t idx) noexcept
+{
+  return reinterpret_cast<Slot *>(mapping + sizeof(Header))[idx];
+}
+
+constexpr size_t HotCounters::getSize(const uint32_t slots_count) noexcept
+{
+  return sizeof(Header) + slots_count * sizeof(Slot);
+}
+
+//single writer: a load and a store instead of a locked increment. The builtins stay inline in unoptimized builds
+HOT ALWAYS_INLINE inline void HotCounters::increment(uint64_t &counter, const uint64_t value) noexcept
+{
+  __atomic_store_n(&counter, __atomic_load_n(&counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+}
+
+HOT ALWAYS_INLINE inline void HotCounters::raise(uint64_t &counter, const uint64_t value) noexcept
+{
+  if (value > __atomic_load_n(&counter, __ATOMIC_RELAXED)) [[unlikely]]
+    __atomic_store_n(&counter, value, __ATOMIC_RELAXED);
+}
+
+HOT ALWAYS_INLINE inline void HotCounters::recordCycles(Slot &slot, const uint8_t type, const uint64_t cycles) noexcept
+{
+  const uint32_t msb = 63 - __builtin_clzll(cycles | 1);
+  increment(slot.cycles[type][msb < CYCLE_BUCKETS ? msb : CYCLE_BUCKETS - 1]);
+}
@@ -0,0 +1,82 @@
+/*================================================================================
+
+File: IoUring.hpp                                                               
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-14 10:03:37                                                 
+last edited: 2025-06-14 10:03:37                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/socket.h>
+#include <linux/io_uring.h>
+
+#include "Config.hpp"
+#include "macros.hpp"
+
+//minimal io_uring over the raw syscalls, for multishot receives into provided buffer rings.
+//a multishot receive is armed once and keeps posting a completion per datagram into a buffer
+//picked from its group, the buffer goes back to the kernel with recycleBuffer. with sqpoll a kernel thread
+//submits, and wait() spins on the completion queue before blocking, so a busy hot loop never enters the kernel
+class IoUring
+{
+  public:
+    IoUring(const bool sqpoll) noexcept;
+    ~IoUring();
+
+    void open(void);
+    inline bool isOpen(void) const noexcept;
+    void setupBuffers(const uint16_t group, const uint16_t count, const uint32_t size);
+
+    void recv(const int fd, void *buffer, const uint32_t size, const int flags, const uint64_t user_data);
+    void recvmsgMultishot(const int fd, const msghdr &msg, const uint16_t group, const uint64_t user_data);
+    void submit(void);
+
+    inline void wait(const uint32_t spin_limit);
+    template <typename Handler>
+    uint32_t forEachCompletion(Handler &&handler);
+
+    inline char *getBuffer(const uint16_t group, const uint16_t id) const noexcept;
+    inline void recycleBuffer(const uint16_t group, const uint16_t id) noexcept;
+
+    uint64_t getEnters(void) const noexcept;
+
+  private:
+    struct BufferGroup
+    {
+      io_uring_buf_ring *ring;
+      char *buffers;
+      size_t ring_size;
+      uint32_t buffer_size;
+      uint16_t count;
+      uint16_t tail;
+    };
+
+    io_uring_sqe *getSqe(void);
+    void enter(const uint32_t to_submit, const uint32_t min_complete, const uint32_t flags);
+
+    const bool sqpoll;
+    int ring_fd;
+    void *sq_ring;
+    void *cq_ring;
+    size_t sq_ring_size;
+    size_t cq_ring_size;
+    io_uring_sqe *sqes;
+    uint32_t *sq_tail;
+    uint32_t *sq_flags;
+    uint32_t sq_mask;
+    uint32_t sqe_tail;
+    uint32_t *cq_head;
+    uint32_t *cq_tail;
+    io_uring_cqe *cqes;
+    uint32_t cq_mask;
+    uint64_t enters;
+    BufferGroup groups[URING_BUFFER_GROUPS];
+};
+
+#include "IoUring.tpp"
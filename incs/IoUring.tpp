@@ -0,0 +1,75 @@
+/*================================================================================
+
+File: IoUring.tpp                                                               
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-14 10:03:37                                                 
+last edited: 2025-06-14 10:03:37                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <immintrin.h>
+
+#include "IoUring.hpp"
+#include "macros.hpp"
+
+COLD inline bool IoUring::isOpen(void) const noexcept
+{
+  return ring_fd != -1;
+}
+
+//blocks until a completion is posted. with sqpoll completions are polled from userspace for up to spin_limit
+//rounds first, a busy feed then never enters the kernel
+HOT inline void IoUring::wait(const uint32_t spin_limit)
+{
+  const std::atomic_ref<uint32_t> tail(*cq_tail);
+
+  if (tail.load(std::memory_order_acquire) != *cq_head)
+    return;
+
+  for (uint32_t spins = sqpoll * spin_limit; spins != 0; --spins)
+  {
+    if (tail.load(std::memory_order_acquire) != *cq_head)
+      return;
+    _mm_pause();
+  }
+
+  enter(0, 1, IORING_ENTER_GETEVENTS);
+}
+
+//hands every posted completion to handler(cqe), in order, and frees their slots
+template <typename Handler>
+HOT uint32_t IoUring::forEachCompletion(Handler &&handler)
+{
+  const uint32_t tail = std::atomic_ref<uint32_t>(*cq_tail).load(std::memory_order_acquire);
+  uint32_t head = *cq_head;
+  const uint32_t count = tail - head;
+
+  for (; head != tail; ++head)
+    handler(cqes[head & cq_mask]);
+
+  std::atomic_ref<uint32_t>(*cq_head).store(head, std::memory_order_release);
+  return count;
+}
+
+HOT ALWAYS_INLINE inline char *IoUring::getBuffer(const uint16_t group, const uint16_t id) const noexcept
+{
+  return groups[group].buffers + static_cast<size_t>(id) * groups[group].buffer_size;
+}
+
+HOT ALWAYS_INLINE inline void IoUring::recycleBuffer(const uint16_t group, const uint16_t id) noexcept
+{
+  BufferGroup &buffer_group = groups[group];
+  //bufs is not at offset 0 in C++, where the empty struct of __DECLARE_FLEX_ARRAY takes a byte
+  io_uring_buf &buffer = reinterpret_cast<io_uring_buf *>(buffer_group.ring)[buffer_group.tail & (buffer_group.count - 1)];
+
+  buffer.addr = reinterpret_cast<uint64_t>(getBuffer(group, id));
+  buffer.len = buffer_group.buffer_size;
+  buffer.bid = id;
+
+  std::atomic_ref<uint16_t>(buffer_group.ring->tail).store(++buffer_group.tail, std::memory_order_release);
+}
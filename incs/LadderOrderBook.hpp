@@ -0,0 +1,155 @@
+/*================================================================================
+
+File: LadderOrderBook.hpp                                                       
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-08 16:21:37                                                 
+last edited: 2025-06-28 10:36:18                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <span>
+#include <vector>
+
+#include "HotCounters.hpp"
+#include "OrderIndex.hpp"
+#include "OrderPool.hpp"
+#include "Config.hpp"
+#include "macros.hpp"
+
+//alternative to OrderBook: price levels live in a fixed window of LADDER_SIZE ticks per side, indexed by
+//tick offset from a movable anchor, with a two level bitmap of the non-empty levels. Orders too far from
+//the touch to fit in the window are parked in an unsorted overflow list
+class LadderOrderBook
+{
+  public:
+    LadderOrderBook(void) noexcept;
+    LadderOrderBook(LadderOrderBook &&) noexcept;
+    ~LadderOrderBook();
+
+    enum Side : uint8_t { BID = 0, ASK = 1 };
+
+    struct Sweep
+    {
+      uint64_t filled_qty;    //less than asked when the side is thinner
+      double average_price;   //0 when nothing was filled
+    };
+
+    struct BulkOrder
+    {
+      uint64_t id;
+      uint64_t qty;
+      int32_t price;
+      Side side;
+    };
+
+    inline int32_t getBestBidPrice(void) const noexcept;
+    inline int32_t getBestAskPrice(void) const noexcept;
+    inline uint64_t getBestBidQty(void) const noexcept;
+    inline uint64_t getBestAskQty(void) const noexcept;
+    inline int32_t getEquilibriumPrice(void) const noexcept;
+    inline uint64_t getEquilibriumBidQty(void) const noexcept;
+    inline uint64_t getEquilibriumAskQty(void) const noexcept;
+    uint32_t copyTopLevels(const Side side, int32_t *restrict prices, uint64_t *restrict qtys, const uint32_t depth) const noexcept;
+    uint64_t getQtyWithin(const Side side, const uint32_t distance) const noexcept;
+    Sweep getSweep(const Side side, const uint64_t qty) const noexcept;
+    bool findOrder(const uint64_t id, const Side side, int32_t &price, uint64_t &qty) noexcept;
+    uint64_t getLevelQty(const Side side, const int32_t price) const noexcept;
+
+    void addTickSize(const uint64_t tick_size, const int32_t price_from, const int32_t price_to);
+
+    void addOrder(const uint64_t id, const Side side, const int32_t price, const uint64_t qty);
+    void removeOrder(const uint64_t id, const Side side);
+    void executeOrder(const uint64_t id, const Side side, const uint64_t qty);
+    void bulkLoad(std::span<BulkOrder> orders);
+
+    inline void setEquilibrium(const int32_t price, const uint64_t bid_qty, const uint64_t ask_qty) noexcept;
+    inline void setCounters(HotCounters::Slot &slot) noexcept;
+
+    OrderPool::Stats getPoolStats(void) const noexcept;
+
+    void save(CheckpointWriter &writer) const;
+    void load(CheckpointReader &reader);
+
+  private:
+
+    static_assert(LADDER_SIZE % 64 == 0 && LADDER_SIZE <= 64 * 64, "LADDER_SIZE must be a multiple of 64, up to 4096");
+
+    //positions with this bit set are indexes in the overflow list instead of the level queue
+    static constexpr uint32_t OVERFLOW_FLAG = 1u << 31;
+
+    struct TickTier
+    {
+      int32_t price_from;
+      int32_t price_to;
+      int64_t tick_size;
+      int64_t first_tick;
+    };
+
+    struct Ladder
+    {
+      //keys are ticks for bids and negated ticks for asks, so a higher key is always a better price.
+      //slot i holds the level at key anchor + i, slot 0 is the sentinel returned when the side is empty
+      int64_t anchor;
+      uint32_t best_slot;
+      uint32_t levels_count; //non-empty levels of the window
+
+      uint64_t summary;
+      std::array<uint64_t, LADDER_SIZE / 64> bitmap;
+
+      std::array<int32_t, LADDER_SIZE> prices;
+      std::array<uint64_t, LADDER_SIZE> cumulative_qtys;
+
+      //unsorted, the orders of each level live in the book's order pool. Empty levels own no block
+      std::array<OrderQueue, LADDER_SIZE> queues;
+
+      struct Order
+      {
+        uint64_t id;
+        int32_t price;
+        uint64_t qty;
+      };
+
+      //always worse than every level of the window
+      std::vector<Order> overflow;
+
+      //order ids are only unique per book and side
+      OrderIndex order_index;
+    };
+
+    std::array<Ladder, 2> ladders;
+    std::vector<TickTier> tick_tiers;
+    OrderPool order_pool;
+
+    int32_t equilibrium_price;
+    uint64_t equilibrium_bid_qty;
+    uint64_t equilibrium_ask_qty;
+
+    HotCounters::Slot *counters;
+
+    inline int64_t getKey(const Side side, const int32_t price) const noexcept;
+    inline uint32_t getHighestSlot(const Ladder &ladder) const noexcept;
+    inline uint32_t getLowerSlot(const Ladder &ladder, const uint32_t slot) const noexcept;
+    inline void setSlot(Ladder &ladder, const uint32_t slot) noexcept;
+    inline void clearSlot(Ladder &ladder, const uint32_t slot) noexcept;
+
+    void insertOrder(Ladder &ladder, const uint32_t slot, OrderIndex::Entry *order, const uint64_t qty);
+    void sweepOverflow(const Ladder &ladder, const Side side, const uint64_t qty, uint64_t &filled, double &notional) const noexcept;
+    uint32_t copyOverflowLevels(const Ladder &ladder, const Side side, int32_t *restrict prices, uint64_t *restrict qtys, uint32_t count, const uint32_t depth) const noexcept;
+    void insertOverflowOrder(Ladder &ladder, const uint64_t id, const int32_t price, const uint64_t qty);
+
+    void reduceOrder(Ladder &ladder, OrderIndex::Entry *order, const Side side, const uint64_t qty);
+    void reduceLadderOrder(Ladder &ladder, OrderIndex::Entry *order, const Side side, const uint64_t qty);
+    void reduceOverflowOrder(Ladder &ladder, OrderIndex::Entry *order, const Side side, const uint64_t qty);
+    void removePriceLevel(Ladder &ladder, const Side side, const uint32_t slot);
+
+    void moveWindow(Ladder &ladder, const Side side, const int64_t anchor);
+    void rebuild(void);
+};
+
+#include "LadderOrderBook.inl"
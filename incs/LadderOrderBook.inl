@@ -0,0 +1,125 @@
+/*================================================================================
+
+File: LadderOrderBook.inl                                                       
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-08 16:21:37                                                 
+last edited: 2025-06-19 10:27:14                                                
+
+================================================================================*/
+
+#pragma once
+
+#include "LadderOrderBook.hpp"
+#include "macros.hpp"
+
+HOT ALWAYS_INLINE inline int32_t LadderOrderBook::getBestBidPrice(void) const noexcept
+{
+  const Ladder &ladder = ladders[BID];
+  return ladder.prices[ladder.best_slot];
+}
+
+HOT ALWAYS_INLINE inline int32_t LadderOrderBook::getBestAskPrice(void) const noexcept
+{
+  const Ladder &ladder = ladders[ASK];
+  return ladder.prices[ladder.best_slot];
+}
+
+HOT ALWAYS_INLINE inline uint64_t LadderOrderBook::getBestBidQty(void) const noexcept
+{
+  const Ladder &ladder = ladders[BID];
+  return ladder.cumulative_qtys[ladder.best_slot];
+}
+
+HOT ALWAYS_INLINE inline uint64_t LadderOrderBook::getBestAskQty(void) const noexcept
+{
+  const Ladder &ladder = ladders[ASK];
+  return ladder.cumulative_qtys[ladder.best_slot];
+}
+
+HOT ALWAYS_INLINE inline int32_t LadderOrderBook::getEquilibriumPrice(void) const noexcept
+{
+  return equilibrium_price;
+}
+
+HOT ALWAYS_INLINE inline uint64_t LadderOrderBook::getEquilibriumBidQty(void) const noexcept
+{
+  return equilibrium_bid_qty;
+}
+
+HOT ALWAYS_INLINE inline uint64_t LadderOrderBook::getEquilibriumAskQty(void) const noexcept
+{
+  return equilibrium_ask_qty;
+}
+
+inline void LadderOrderBook::setEquilibrium(const int32_t price, const uint64_t bid_qty, const uint64_t ask_qty) noexcept
+{
+  equilibrium_price = price;
+  equilibrium_bid_qty = bid_qty;
+  equilibrium_ask_qty = ask_qty;
+}
+
+inline void LadderOrderBook::setCounters(HotCounters::Slot &slot) noexcept
+{
+  counters = &slot;
+}
+
+HOT ALWAYS_INLINE inline int64_t LadderOrderBook::getKey(const Side side, const int32_t price) const noexcept
+{
+  //tiers are sorted by price_from, prices below the first tier are extrapolated with its tick size
+  const TickTier *tier = tick_tiers.data();
+  const TickTier *last = tier + tick_tiers.size() - 1;
+  while (tier != last && tier[1].price_from <= price)
+    tier++;
+
+  const int64_t distance = static_cast<int64_t>(price) - tier->price_from;
+  const int64_t ticks = distance / tier->tick_size - (distance % tier->tick_size < 0);
+  const int64_t tick = tier->first_tick + ticks;
+
+  return (side == BID) ? tick : -tick;
+}
+
+HOT ALWAYS_INLINE inline uint32_t LadderOrderBook::getHighestSlot(const Ladder &ladder) const noexcept
+{
+  const uint64_t summary = ladder.summary;
+  const uint32_t word_idx = 63 - __builtin_clzll(summary | 1);
+  const uint64_t word = ladder.bitmap[word_idx];
+  const uint32_t slot = word_idx * 64 + 63 - __builtin_clzll(word | 1);
+
+  return (summary != 0) * slot;
+}
+
+//highest non-empty slot below slot, 0 when there is none
+HOT ALWAYS_INLINE inline uint32_t LadderOrderBook::getLowerSlot(const Ladder &ladder, const uint32_t slot) const noexcept
+{
+  const uint32_t word_idx = slot / 64;
+  const uint64_t word = ladder.bitmap[word_idx] & ((1ULL << (slot % 64)) - 1);
+
+  if (word != 0)
+    return word_idx * 64 + 63 - __builtin_clzll(word);
+
+  const uint64_t summary = ladder.summary & ((1ULL << word_idx) - 1);
+  if (summary == 0)
+    return 0;
+
+  const uint32_t lower_idx = 63 - __builtin_clzll(summary);
+  return lower_idx * 64 + 63 - __builtin_clzll(ladder.bitmap[lower_idx]);
+}
+
+HOT ALWAYS_INLINE inline void LadderOrderBook::setSlot(Ladder &ladder, const uint32_t slot) noexcept
+{
+  const uint32_t word_idx = slot / 64;
+
+  ladder.bitmap[word_idx] |= 1ULL << (slot % 64);
+  ladder.summary |= 1ULL << word_idx;
+}
+
+HOT ALWAYS_INLINE inline void LadderOrderBook::clearSlot(Ladder &ladder, const uint32_t slot) noexcept
+{
+  const uint32_t word_idx = slot / 64;
+  uint64_t &word = ladder.bitmap[word_idx];
+
+  word &= ~(1ULL << (slot % 64));
+  ladder.summary &= ~(static_cast<uint64_t>(word == 0) << word_idx);
+}
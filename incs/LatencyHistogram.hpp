@@ -0,0 +1,47 @@
+/*================================================================================
+
+File: LatencyHistogram.hpp                                                      
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-17 10:12:48                                                 
+last edited: 2025-06-18 15:02:37                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "Config.hpp"
+#include "macros.hpp"
+
+//HDR style histogram of nanosecond latencies. Values below 2 << LATENCY_SUB_BUCKET_BITS get a bucket each, every
+//higher power of two is split in 1 << LATENCY_SUB_BUCKET_BITS linear buckets, so a bucket is never wider than
+//1 / (1 << LATENCY_SUB_BUCKET_BITS) of its values. One thread records with relaxed stores, any other thread can
+//read it at the same time without locks. The __atomic builtins stay inline in unoptimized builds
+class LatencyHistogram
+{
+  public:
+    LatencyHistogram(void) noexcept;
+    ~LatencyHistogram();
+
+    inline void record(const uint64_t value) noexcept;
+
+    uint64_t getCount(void) const noexcept;
+    uint64_t getPercentile(const double percentile) const noexcept;
+    uint64_t getMax(void) const noexcept;
+
+  private:
+    static constexpr uint32_t SUB_BUCKETS = 1u << LATENCY_SUB_BUCKET_BITS;
+    static constexpr uint32_t BUCKETS = (64 - LATENCY_SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    static inline uint32_t getBucket(const uint64_t value) noexcept;
+    static uint64_t getBucketHighest(const uint32_t bucket) noexcept;
+
+    std::array<uint64_t, BUCKETS> counts;
+    uint64_t max;
+};
+
+#include "LatencyHistogram.inl"
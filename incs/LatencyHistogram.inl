@@ -0,0 +1,34 @@
+/*================================================================================
+
+File: LatencyHistogram.inl                                                      
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-17 10:12:48                                                 
+last edited: 2025-06-18 15:02:37                                                
+
+================================================================================*/
+
+#pragma once
+
+#include "LatencyHistogram.hpp"
+#include "macros.hpp"
+
+//single writer: a load and a store instead of a locked increment
+HOT ALWAYS_INLINE inline void LatencyHistogram::record(const uint64_t value) noexcept
+{
+  uint64_t &count = counts[getBucket(value)];
+
+  __atomic_store_n(&count, __atomic_load_n(&count, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+  if (value > __atomic_load_n(&max, __ATOMIC_RELAXED)) [[unlikely]]
+    __atomic_store_n(&max, value, __ATOMIC_RELAXED);
+}
+
+//the top LATENCY_SUB_BUCKET_BITS + 1 bits of the value, offset by how far they were shifted down
+HOT ALWAYS_INLINE inline uint32_t LatencyHistogram::getBucket(const uint64_t value) noexcept
+{
+  const uint32_t msb = 63 - __builtin_clzll(value | SUB_BUCKETS);
+  const uint32_t shift = msb - LATENCY_SUB_BUCKET_BITS;
+
+  return (shift << LATENCY_SUB_BUCKET_BITS) + static_cast<uint32_t>(value >> shift);
+}
@@ -0,0 +1,68 @@
+/*================================================================================
+
+File: LatencyStats.hpp                                                          
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-17 10:12:48                                                 
+last edited: 2025-06-17 10:12:48                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <sys/socket.h>
+
+#include "LatencyHistogram.hpp"
+#include "macros.hpp"
+
+//wire to book latency, in three stages:
+//- exchange to NIC: exchange time rebuilt from 'T' and the message nanoseconds, to the kernel receive timestamp.
+//  It compares two clocks, so it only means something when this host is synchronized to the exchange
+//- NIC to userspace: kernel receive timestamp to the return of the receive call
+//- userspace to book applied: receive call to the rdtsc after each message is applied
+//the first and last stage are only measured for books processed on the receiving thread.
+//the histograms are dumped to stdout whenever the process gets SIGUSR1, which main blocks in every thread so that
+//only the dump thread takes it
+class LatencyStats
+{
+  public:
+    enum Stage : uint8_t { EXCHANGE_TO_NIC, NIC_TO_USER, USER_TO_BOOK, STAGES_COUNT };
+
+    //receive side of the packet being processed, nic_ns is 0 when the kernel gave no timestamp
+    struct PacketStamps
+    {
+      uint64_t nic_ns;   //CLOCK_REALTIME
+      uint64_t user_ns;  //CLOCK_REALTIME
+      uint64_t user_tsc;
+    };
+
+    LatencyStats(const bool enabled);
+    ~LatencyStats();
+
+    inline bool isEnabled(void) const noexcept;
+
+    inline void stampReceive(PacketStamps &stamps) const noexcept;
+    inline void recordReceive(const PacketStamps &stamps) noexcept;
+    inline void recordExchange(const PacketStamps &stamps, const uint64_t exchange_ns) noexcept;
+    inline void recordApplied(const PacketStamps &stamps, const uint64_t applied_tsc) noexcept;
+
+    static uint64_t getKernelTimestamp(const msghdr &msg) noexcept;
+
+    void dump(FILE *file) const;
+
+  private:
+    void calibrate(void);
+    void run(std::stop_token stop) const;
+
+    const bool enabled;
+    double ns_per_cycle;
+    std::array<LatencyHistogram, STAGES_COUNT> stages;
+    std::jthread thread;
+};
+
+#include "LatencyStats.inl"
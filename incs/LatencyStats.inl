@@ -0,0 +1,57 @@
+/*================================================================================
+
+File: LatencyStats.inl                                                          
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-17 10:12:48                                                 
+last edited: 2025-06-18 15:02:37                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <ctime>
+#include <x86intrin.h>
+
+#include "LatencyStats.hpp"
+#include "macros.hpp"
+
+HOT ALWAYS_INLINE inline bool LatencyStats::isEnabled(void) const noexcept
+{
+  return enabled;
+}
+
+//right after the receive call returns, once per call
+HOT ALWAYS_INLINE inline void LatencyStats::stampReceive(PacketStamps &stamps) const noexcept
+{
+  timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+
+  stamps.user_ns = now.tv_sec * 1'000'000'000ull + now.tv_nsec;
+  stamps.user_tsc = __rdtsc();
+}
+
+HOT ALWAYS_INLINE inline void LatencyStats::recordReceive(const PacketStamps &stamps) noexcept
+{
+  if (stamps.nic_ns == 0) [[unlikely]]
+    return;
+
+  const int64_t latency = stamps.user_ns - stamps.nic_ns;
+  stages[NIC_TO_USER].record(latency > 0 ? latency : 0);
+}
+
+//an exchange clock ahead of ours counts as 0
+HOT ALWAYS_INLINE inline void LatencyStats::recordExchange(const PacketStamps &stamps, const uint64_t exchange_ns) noexcept
+{
+  if (stamps.nic_ns == 0) [[unlikely]]
+    return;
+
+  const int64_t latency = stamps.nic_ns - exchange_ns;
+  stages[EXCHANGE_TO_NIC].record(latency > 0 ? latency : 0);
+}
+
+HOT ALWAYS_INLINE inline void LatencyStats::recordApplied(const PacketStamps &stamps, const uint64_t applied_tsc) noexcept
+{
+  stages[USER_TO_BOOK].record(static_cast<uint64_t>((applied_tsc - stamps.user_tsc) * ns_per_cycle));
+}
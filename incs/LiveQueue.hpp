@@ -0,0 +1,50 @@
+/*================================================================================
+
+File: LiveQueue.hpp                                                             
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-15 18:05:31                                                 
+last edited: 2025-06-15 18:05:31                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "Packets.hpp"
+#include "Config.hpp"
+#include "macros.hpp"
+
+//the live feed received while the snapshot is fetched. Packets are received straight into chunks of
+//LIVE_QUEUE_CHUNK_PACKETS slots, which are never initialised nor moved. The first LIVE_QUEUE_RESERVE slots
+//are preallocated, a longer snapshot only adds chunks
+class LiveQueue
+{
+  public:
+    LiveQueue(void);
+    ~LiveQueue();
+
+    inline MoldUDP64Packet *claim(uint16_t &count);
+    inline void commit(const uint16_t count) noexcept;
+
+    template <typename Callback>
+    void forEach(Callback &&callback) const;
+
+    void release(void);
+
+  private:
+    static constexpr size_t CHUNK_MASK = LIVE_QUEUE_CHUNK_PACKETS - 1;
+    static_assert((LIVE_QUEUE_CHUNK_PACKETS & CHUNK_MASK) == 0, "LIVE_QUEUE_CHUNK_PACKETS must be a power of 2");
+
+    void grow(void);
+
+    std::vector<std::unique_ptr<MoldUDP64Packet[]>> chunks;
+    size_t size;
+};
+
+#include "LiveQueue.tpp"
@@ -0,0 +1,42 @@
+/*================================================================================
+
+File: LiveQueue.tpp                                                             
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-15 18:05:31                                                 
+last edited: 2025-06-15 18:05:31                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+
+#include "LiveQueue.hpp"
+#include "macros.hpp"
+
+//free slots past the queued packets, contiguous within a chunk. count is the most wanted, on return the ones claimed
+HOT inline MoldUDP64Packet *LiveQueue::claim(uint16_t &count)
+{
+  const size_t chunk = size / LIVE_QUEUE_CHUNK_PACKETS;
+  const size_t offset = size & CHUNK_MASK;
+
+  if (chunk == chunks.size()) [[unlikely]]
+    grow();
+
+  count = std::min<size_t>(count, LIVE_QUEUE_CHUNK_PACKETS - offset);
+  return &chunks[chunk][offset];
+}
+
+HOT inline void LiveQueue::commit(const uint16_t count) noexcept
+{
+  size += count;
+}
+
+template <typename Callback>
+COLD void LiveQueue::forEach(Callback &&callback) const
+{
+  for (size_t i = 0; i < size; ++i)
+    callback(chunks[i / LIVE_QUEUE_CHUNK_PACKETS][i & CHUNK_MASK]);
+}
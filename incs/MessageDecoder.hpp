@@ -0,0 +1,78 @@
+/*================================================================================
+
+File: MessageDecoder.hpp                                                        
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-24 15:36:08                                                 
+last edited: 2025-06-24 15:36:08                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+
+#include "Packets.hpp"
+#include "macros.hpp"
+
+//the fields of an order book message in host order, at the same place for every message type
+struct alignas(32) DecodedMessage
+{
+  uint64_t order_id;      //bid quantity of 'Z', tick size of 'L'
+  uint32_t orderbook_id;
+  char side;
+  uint8_t reserved1[3];
+  uint64_t qty;           //executed quantity of 'E' and 'C', ask quantity of 'Z', price to of 'L'
+  int32_t price;          //equilibrium price of 'Z', price from of 'L'
+  uint8_t reserved2[4];
+};
+
+static_assert(sizeof(DecodedMessage) == 32);
+
+//every message type is described once by a schema of its big endian fields and where they land in DecodedMessage.
+//for each type the schema gives, at compile time, a window of the message holding all its fields and the byte shuffle
+//turning that window into the record. A field can only move within its 16 byte lane, the shuffle works lane by lane.
+//the window never reads past the message, types without such a window are swapped field by field
+class MessageDecoder
+{
+  public:
+    template <char type>
+    static inline DecodedMessage decode(const MessageData &data) noexcept;
+
+    //sizeof(MessageData::...) of every type, 0 for unknown types
+    static consteval std::array<uint16_t, 'Z' + 1> getDataLengths(void) noexcept;
+
+  private:
+
+    struct Field
+    {
+      uint8_t src;  //from the start of MessageData
+      uint8_t size;
+      uint8_t dst;  //in DecodedMessage
+    };
+
+    struct Schema
+    {
+      char type;
+      uint8_t length; //without the type
+      uint8_t fields_count;
+      std::array<Field, 5> fields;
+    };
+
+    struct Layout
+    {
+      static constexpr uint8_t NO_WINDOW = UINT8_MAX;
+
+      uint8_t window; //first byte loaded, from the start of MessageData
+      uint8_t width;  //16 or 32
+      alignas(32) std::array<uint8_t, 32> mask;
+    };
+
+    static consteval Schema getSchema(const char type) noexcept;
+    static consteval Layout makeLayout(const Schema &schema) noexcept;
+};
+
+#include "MessageDecoder.tpp"
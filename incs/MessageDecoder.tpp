@@ -0,0 +1,166 @@
+/*================================================================================
+
+File: MessageDecoder.tpp                                                        
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-24 15:36:08                                                 
+last edited: 2025-06-24 15:36:08                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstring>
+#include <immintrin.h>
+
+#include "MessageDecoder.hpp"
+
+#define SCHEMA_FIELD(message, field, record_field) \
+  Field{ offsetof(MessageData, message.field), sizeof(decltype(MessageData::message)::field), offsetof(DecodedMessage, record_field) }
+
+consteval MessageDecoder::Schema MessageDecoder::getSchema(const char type) noexcept
+{
+  constexpr std::array<Schema, 12> schemas = {{
+    { 'A', sizeof(MessageData::new_order), 5, {
+      SCHEMA_FIELD(new_order, order_id, order_id),
+      SCHEMA_FIELD(new_order, orderbook_id, orderbook_id),
+      SCHEMA_FIELD(new_order, side, side),
+      SCHEMA_FIELD(new_order, quantity, qty),
+      SCHEMA_FIELD(new_order, price, price) } },
+    { 'D', sizeof(MessageData::deleted_order), 3, {
+      SCHEMA_FIELD(deleted_order, order_id, order_id),
+      SCHEMA_FIELD(deleted_order, orderbook_id, orderbook_id),
+      SCHEMA_FIELD(deleted_order, side, side) } },
+    { 'E', sizeof(MessageData::execution_notice), 4, {
+      SCHEMA_FIELD(execution_notice, order_id, order_id),
+      SCHEMA_FIELD(execution_notice, orderbook_id, orderbook_id),
+      SCHEMA_FIELD(execution_notice, side, side),
+      SCHEMA_FIELD(execution_notice, executed_quantity, qty) } },
+    { 'C', sizeof(MessageData::execution_notice_with_trade_info), 4, {
+      SCHEMA_FIELD(execution_notice_with_trade_info, order_id, order_id),
+      SCHEMA_FIELD(execution_notice_with_trade_info, orderbook_id, orderbook_id),
+      SCHEMA_FIELD(execution_notice_with_trade_info, side, side),
+      SCHEMA_FIELD(execution_notice_with_trade_info, executed_quantity, qty) } },
+    { 'Z', sizeof(MessageData::ep), 4, {
+      SCHEMA_FIELD(ep, orderbook_id, orderbook_id),
+      SCHEMA_FIELD(ep, available_bid_quantity, order_id),
+      SCHEMA_FIELD(ep, available_ask_quantity, qty),
+      SCHEMA_FIELD(ep, equilibrium_price, price) } },
+    { 'L', sizeof(MessageData::tick_size_data), 4, {
+      SCHEMA_FIELD(tick_size_data, orderbook_id, orderbook_id),
+      SCHEMA_FIELD(tick_size_data, tick_size, order_id),
+      SCHEMA_FIELD(tick_size_data, price_from, price),
+      SCHEMA_FIELD(tick_size_data, price_to, qty) } },
+    { 'T', sizeof(MessageData::seconds), 0, {} },
+    { 'R', sizeof(MessageData::series_info_basic), 0, {} },
+    { 'M', sizeof(MessageData::series_info_basic_combination), 0, {} },
+    { 'S', sizeof(MessageData::system_event), 0, {} },
+    { 'O', sizeof(MessageData::trading_status), 0, {} },
+    { 'G', sizeof(MessageData::snapshot_completion), 0, {} }
+  }};
+
+  for (const Schema &schema : schemas)
+    if (schema.type == type)
+      return schema;
+  return {};
+}
+
+#undef SCHEMA_FIELD
+
+//the first window where every field keeps its lane, NO_WINDOW when there is none
+consteval MessageDecoder::Layout MessageDecoder::makeLayout(const Schema &schema) noexcept
+{
+  Layout layout{ Layout::NO_WINDOW, 16, {} };
+  const uint32_t message_size = sizeof(MessageData::type) + schema.length;
+
+  for (uint8_t i = 0; i < schema.fields_count; ++i)
+    if (schema.fields[i].dst + schema.fields[i].size > 16)
+      layout.width = 32;
+
+  for (uint32_t window = 0; window + layout.width <= message_size; ++window)
+  {
+    bool fits = true;
+
+    for (uint8_t i = 0; i < schema.fields_count; ++i)
+    {
+      const Field &field = schema.fields[i];
+      const int32_t first = field.src - static_cast<int32_t>(window);
+      const int32_t last = first + field.size - 1;
+
+      fits &= (first >= 0) && (first / 16 == field.dst / 16) && (last / 16 == field.dst / 16);
+    }
+
+    if (!fits)
+      continue;
+
+    layout.window = window;
+    layout.mask.fill(0x80);
+
+    //big endian, the last byte of a field is its lowest
+    for (uint8_t i = 0; i < schema.fields_count; ++i)
+    {
+      const Field &field = schema.fields[i];
+      for (uint8_t byte = 0; byte < field.size; ++byte)
+        layout.mask[field.dst + byte] = (field.src - window + field.size - 1 - byte) % 16;
+    }
+
+    return layout;
+  }
+
+  return layout;
+}
+
+consteval std::array<uint16_t, 'Z' + 1> MessageDecoder::getDataLengths(void) noexcept
+{
+  std::array<uint16_t, 'Z' + 1> data_lengths{};
+
+  for (char type = 'A'; type <= 'Z'; ++type)
+    data_lengths[type] = getSchema(type).length;
+
+  return data_lengths;
+}
+
+template <char type>
+HOT ALWAYS_INLINE inline DecodedMessage MessageDecoder::decode(const MessageData &data) noexcept
+{
+  static constexpr Schema schema = getSchema(type);
+  [[maybe_unused]] static constexpr Layout layout = makeLayout(schema);
+  static_assert(schema.fields_count != 0, "no fields to decode for this message type");
+
+  DecodedMessage decoded;
+  const char *bytes = reinterpret_cast<const char *>(&data);
+
+#if defined(__AVX2__)
+  if constexpr (layout.window != Layout::NO_WINDOW && layout.width == 32)
+  {
+    const __m256i window = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes + layout.window));
+    const __m256i mask = _mm256_load_si256(reinterpret_cast<const __m256i *>(layout.mask.data()));
+    _mm256_store_si256(reinterpret_cast<__m256i *>(&decoded), _mm256_shuffle_epi8(window, mask));
+    return decoded;
+  }
+#endif
+#if defined(__SSSE3__)
+  if constexpr (layout.window != Layout::NO_WINDOW && layout.width == 16)
+  {
+    const __m128i window = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + layout.window));
+    const __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i *>(layout.mask.data()));
+    _mm_store_si128(reinterpret_cast<__m128i *>(&decoded), _mm_shuffle_epi8(window, mask));
+    std::memset(reinterpret_cast<char *>(&decoded) + 16, 0, 16);
+    return decoded;
+  }
+#endif
+
+  //no window, or no byte shuffle on the target
+  char *record = reinterpret_cast<char *>(&decoded);
+  std::memset(record, 0, sizeof(decoded));
+
+  for (uint8_t i = 0; i < schema.fields_count; ++i)
+  {
+    const Field &field = schema.fields[i];
+    for (uint8_t byte = 0; byte < field.size; ++byte)
+      record[field.dst + byte] = bytes[field.src + field.size - 1 - byte];
+  }
+
+  return decoded;
+}
@@ -5,30 +5,72 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-04-06 18:55:50                                                 
-last edited: 2025-04-17 16:05:19                                                
+last edited: 2025-06-29 10:03:27                                                
 
 ================================================================================*/
 
 #pragma once
 
 #include <cstdint>
+#include <array>
+#include <memory>
+#include <type_traits>
 #include <vector>
-#include <unordered_set>
 
+#include "BookIndex.hpp"
+#include "BookListener.hpp"
+#include "BookPublisher.hpp"
 #include "OrderBook.hpp"
+#include "LadderOrderBook.hpp"
+#include "HotCounters.hpp"
+#include "LatencyStats.hpp"
+#include "MessageDecoder.hpp"
 #include "Packets.hpp"
+#include "macros.hpp"
 
-class MessageHandler
+//the listener gets the events of the books, resolved at compile time. The definitions live in MessageHandler.tpp,
+//which only the handler without a listener is built from in srcs/, a listener is instantiated where it is defined
+template <typename Listener>
+class BasicMessageHandler
 {
   public:
-    MessageHandler(void) noexcept;
-    ~MessageHandler() noexcept;
+    BasicMessageHandler(void) noexcept;
+    ~BasicMessageHandler() noexcept;
+
+#ifdef LADDER_BOOK
+    using Book = LadderOrderBook;
+#else
+    using Book = OrderBook;
+#endif
 
     inline void addBookId(const uint32_t orderbook_id);
+    void setCounters(HotCounters::Slot &slot) noexcept;
+    void setPublisher(BookPublisher &publisher);
+    void addOrderBook(const uint32_t orderbook_id);
     void handleMessage(const MessageData &data);
+    void stageSnapshotMessage(const MessageData &data);
+    void loadSnapshot(void);
+    void handleMessageBlocks(const char *restrict buffer, uint16_t blocks_count);
+    void handleMessageBlocks(const char *restrict buffer, uint16_t blocks_count, const LatencyStats::PacketStamps &stamps, LatencyStats &latency);
+    //bursts produce no listener events, only handlers without a listener have them
+    void enableBursts(void) requires std::is_same_v<Listener, NoListener>;
+    void decodeMessageBlocks(const char *restrict buffer, uint16_t blocks_count) requires std::is_same_v<Listener, NoListener>;
+    void applyBurst(void) requires std::is_same_v<Listener, NoListener>;
+    void publishBooks(void) noexcept;
+    inline Listener &getListener(void) noexcept;
+    inline const Book *findOrderBook(const uint32_t orderbook_id) const noexcept;
+
+    OrderPool::Stats getPoolStats(void) const noexcept;
+
+    void saveCheckpoint(CheckpointWriter &writer) const;
+    void loadCheckpoint(CheckpointReader &reader);
+    static constexpr uint32_t getBookKind(void) noexcept;
 
   private:
 
+    inline void dispatchMessage(const MessageData &data);
+    void handleSampledMessage(const MessageData &data);
+
     void handleSnapshotCompletion(const MessageData &data);
     void handleNewOrder(const MessageData &data);
     void handleDeletedOrder(const MessageData &data);
@@ -42,22 +84,75 @@ class MessageHandler
     void handleExecutionNoticeWithTradeInfo(const MessageData &data);
     void handleEquilibriumPrice(const MessageData &data);
     
-    void handleNewLimitOrder(const MessageData &data);
-    void handleNewMarketOrder(const MessageData &data);
+    void handleNewLimitOrder(const DecodedMessage &m);
+    void handleNewMarketOrder(const DecodedMessage &m);
+    void stageNewOrder(const MessageData &data);
+
+    enum Operation : uint8_t { ADD_ORDER, REMOVE_ORDER, EXECUTE_ORDER, SET_EQUILIBRIUM, ADD_TICK_SIZE };
+
+    template <Operation operation, typename Op>
+    void processOrderBookOperation(const DecodedMessage &m);
+    template <Operation operation, typename Op>
+    void applyWithEvents(Book &book, const DecodedMessage &m);
+
+    Book *getOrderBook(const uint32_t orderbook_id) noexcept;
+
+    //the book operations of a receive burst, swapped to host order and chained per book in arrival order
+    struct Burst
+    {
+      //the smallest message touching a book is a 'D'
+      static constexpr uint32_t MIN_BLOCK_SIZE = sizeof(MessageBlock::length) + sizeof(MessageData::type) + sizeof(MessageData::deleted_order);
+      static constexpr uint32_t CAPACITY = MAX_BURST_PACKETS * ((MTU - sizeof(MoldUDP64Header)) / MIN_BLOCK_SIZE);
+      static constexpr uint32_t NO_OP = UINT32_MAX;
 
-    using OrderBookOp = void (*)(OrderBook *book, const MessageData &data);
-    template <OrderBookOp op>
-    void processOrderBookOperation(const uint32_t orderbook_id, const MessageData &data);
+      uint32_t ops_count;
+      uint32_t books_count;
 
-    OrderBook *getOrderBook(const uint32_t orderbook_id) noexcept;
+      std::array<uint8_t, CAPACITY> operations;
+      std::array<uint8_t, CAPACITY> sides;
+      std::array<uint32_t, CAPACITY> next;
+      std::array<uint64_t, CAPACITY> order_ids; //bid quantity of 'Z', tick size of 'L'
+      std::array<int32_t, CAPACITY> prices;     //price from of 'L'
+      std::array<uint64_t, CAPACITY> qtys;      //ask quantity of 'Z', price to of 'L'
 
-    struct OrderBooks
+      //touched books, in the order of their first operation
+      std::array<uint32_t, CAPACITY> books;
+    };
+
+    struct BurstChain
     {
-      std::vector<uint32_t> ids;
-      std::vector<OrderBook> books;
-    } order_books;
+      uint32_t head;
+      uint32_t tail; //NO_OP while the book has nothing in the burst
+    };
+
+    inline void pushOperation(const Operation operation, const DecodedMessage &m) noexcept;
+
+    BookIndex book_index;
+    std::vector<Book> order_books;
+    std::vector<uint32_t> book_ids;
+
+    //one bit per book changed since the last publish, and the slot each book is published in
+    std::vector<uint64_t> dirty_books;
+    std::vector<BookPublisher::Slot *> book_slots;
+    BookPublisher *publisher;
+
+    //last 'T', the other messages only carry the nanoseconds within it
+    uint64_t exchange_seconds;
 
-    std::unordered_set<uint32_t> orderbook_whitelist;
+    HotCounters::Slot *counters;
+    uint32_t cycles_countdown;
+
+    std::unique_ptr<Burst> burst;
+    std::vector<BurstChain> burst_chains;
+
+    //orders of the snapshot not yet in their books, per book index, and the books that have any
+    std::vector<std::vector<typename Book::BulkOrder>> snapshot_orders;
+    std::vector<uint32_t> snapshot_books;
+
+    [[no_unique_address]] Listener listener;
 };
 
+using MessageHandler = BasicMessageHandler<NoListener>;
+extern template class BasicMessageHandler<NoListener>;
+
 #include "MessageHandler.inl"
\ No newline at end of file
@@ -5,7 +5,7 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-04-16 17:40:46                                                 
-last edited: 2025-04-17 16:05:19                                                
+last edited: 2025-06-21 09:58:20                                                
 
 ================================================================================*/
 
@@ -13,7 +13,28 @@ last edited: 2025-04-17 16:05:19
 
 #include "MessageHandler.hpp"
 
-void MessageHandler::addBookId(const uint32_t orderbook_id)
+template <typename Listener>
+void BasicMessageHandler<Listener>::addBookId(const uint32_t orderbook_id)
 {
-  orderbook_whitelist.insert(orderbook_id);
+  book_index.insert(orderbook_id);
+}
+
+template <typename Listener>
+Listener &BasicMessageHandler<Listener>::getListener(void) noexcept
+{
+  return listener;
+}
+
+//nullptr for books not tracked, the book is only safe to query from the thread running the handler
+template <typename Listener>
+const typename BasicMessageHandler<Listener>::Book *BasicMessageHandler<Listener>::findOrderBook(const uint32_t orderbook_id) const noexcept
+{
+  const uint32_t idx = book_index.find(orderbook_id);
+  return (idx != BookIndex::NO_BOOK) ? &order_books[idx] : nullptr;
+}
+
+template <typename Listener>
+constexpr uint32_t BasicMessageHandler<Listener>::getBookKind(void) noexcept
+{
+  return sizeof(Book);
 }
\ No newline at end of file
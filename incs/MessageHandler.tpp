@@ -0,0 +1,741 @@
+/*================================================================================
+
+File: MessageHandler.tpp                                                        
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-20 11:14:52                                                 
+last edited: 2025-06-29 11:21:06                                                
+
+================================================================================*/
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <span>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <x86intrin.h>
+
+#include "MessageHandler.hpp"
+#include "MessageDecoder.hpp"
+#include "Packets.hpp"
+#include "utils/utils.hpp"
+#include "macros.hpp"
+#include "error.hpp"
+
+template <typename Listener>
+COLD BasicMessageHandler<Listener>::BasicMessageHandler(void) noexcept :
+  dirty_books(1, 0),
+  book_slots(),
+  publisher(nullptr),
+  exchange_seconds(0),
+  counters(&HotCounters::unbound),
+  cycles_countdown(HOT_COUNTERS_SAMPLE_INTERVAL),
+  burst(nullptr),
+  burst_chains(),
+  snapshot_orders(),
+  snapshot_books()
+{
+}
+
+template <typename Listener>
+COLD BasicMessageHandler<Listener>::~BasicMessageHandler() noexcept
+{
+}
+
+template <typename Listener>
+COLD void BasicMessageHandler<Listener>::addOrderBook(const uint32_t orderbook_id)
+{
+  book_index.insert(orderbook_id);
+
+  if (book_index.find(orderbook_id) != BookIndex::NO_BOOK)
+    return;
+
+  const size_t book_idx = order_books.size();
+
+  book_index.setBook(orderbook_id, book_idx);
+  order_books.emplace_back().setCounters(*counters);
+  book_ids.push_back(orderbook_id);
+
+  //published with the next packet, even if it does not touch the book
+  dirty_books.resize(book_idx / 64 + 1, 0);
+  dirty_books[book_idx / 64] |= 1ULL << (book_idx % 64);
+  book_slots.push_back(publisher ? publisher->claimSlot(orderbook_id) : nullptr);
+  burst_chains.push_back({ Burst::NO_OP, Burst::NO_OP });
+}
+
+//books are published from the thread running this handler
+template <typename Listener>
+COLD void BasicMessageHandler<Listener>::setPublisher(BookPublisher &publisher)
+{
+  this->publisher = &publisher;
+
+  for (size_t i = 0; i < order_books.size(); ++i)
+    book_slots[i] = publisher.claimSlot(book_ids[i]);
+}
+
+//the slot of the thread running this handler
+template <typename Listener>
+COLD void BasicMessageHandler<Listener>::setCounters(HotCounters::Slot &slot) noexcept
+{
+  counters = &slot;
+
+  for (Book &book : order_books)
+    book.setCounters(slot);
+}
+
+template <typename Listener>
+COLD void BasicMessageHandler<Listener>::saveCheckpoint(CheckpointWriter &writer) const
+{
+  writer.write<uint32_t>(order_books.size());
+
+  for (size_t i = 0; i < order_books.size(); ++i)
+  {
+    writer.write(book_ids[i]);
+    order_books[i].save(writer);
+  }
+}
+
+template <typename Listener>
+COLD void BasicMessageHandler<Listener>::loadCheckpoint(CheckpointReader &reader)
+{
+  uint32_t books_count;
+  reader.read(books_count);
+
+  while (books_count--)
+  {
+    uint32_t orderbook_id;
+    reader.read(orderbook_id);
+
+    addOrderBook(orderbook_id);
+    getOrderBook(orderbook_id)->load(reader);
+  }
+}
+
+template <typename Listener>
+COLD OrderPool::Stats BasicMessageHandler<Listener>::getPoolStats(void) const noexcept
+{
+  OrderPool::Stats total{};
+
+  for (const auto &book : order_books)
+  {
+    const OrderPool::Stats stats = book.getPoolStats();
+    total.capacity += stats.capacity;
+    total.reserved += stats.reserved;
+    total.allocated += stats.allocated;
+    total.orders += stats.orders;
+    total.grows += stats.grows;
+  }
+
+  return total;
+}
+
+template <typename Listener>
+HOT void BasicMessageHandler<Listener>::handleMessage(const MessageData &data)
+{
+  HotCounters::increment(counters->messages[data.type]);
+
+  if (--cycles_countdown == 0) [[unlikely]]
+    return handleSampledMessage(data);
+
+  dispatchMessage(data);
+}
+
+//the timestamps cost more than most messages, only one every HOT_COUNTERS_SAMPLE_INTERVAL pays them
+template <typename Listener>
+COLD NEVER_INLINE void BasicMessageHandler<Listener>::handleSampledMessage(const MessageData &data)
+{
+  cycles_countdown = HOT_COUNTERS_SAMPLE_INTERVAL;
+
+  const uint64_t start = __rdtsc();
+  dispatchMessage(data);
+  const uint64_t end = __rdtsc();
+
+  HotCounters::recordCycles(*counters, data.type, end - start);
+}
+
+//a switch instead of a table of handlers, the hot ones inline whole into handleMessage
+template <typename Listener>
+HOT ALWAYS_INLINE inline void BasicMessageHandler<Listener>::dispatchMessage(const MessageData &data)
+{
+  switch (data.type)
+  {
+    case 'A':
+      return handleNewOrder(data);
+    case 'D':
+      return handleDeletedOrder(data);
+    case 'E':
+      return handleExecutionNotice(data);
+    case 'C':
+      return handleExecutionNoticeWithTradeInfo(data);
+    case 'T':
+      return handleSeconds(data);
+    case 'Z':
+      return handleEquilibriumPrice(data);
+    case 'R':
+      return handleSeriesInfoBasic(data);
+    case 'M':
+      return handleSeriesInfoBasicCombination(data);
+    case 'L':
+      return handleTickSizeData(data);
+    case 'S':
+      return handleSystemEvent(data);
+    case 'O':
+      return handleTradingStatus(data);
+    default:
+      return;
+  }
+}
+
+template <typename Listener>
+HOT void BasicMessageHandler<Listener>::handleMessageBlocks(const char *restrict buffer, uint16_t blocks_count)
+{
+  while (blocks_count--)
+  {
+    const MessageBlock &block = *reinterpret_cast<const MessageBlock *>(buffer);
+    const uint16_t length = sizeof(block.length) + block.length;
+
+    PREFETCH_R(buffer + length, 1);
+    handleMessage(block.data);
+
+    buffer += length;
+  }
+
+  publishBooks();
+}
+
+//same as above, also timing every message from the exchange and from the receive of its packet
+template <typename Listener>
+HOT void BasicMessageHandler<Listener>::handleMessageBlocks(const char *restrict buffer, uint16_t blocks_count, const LatencyStats::PacketStamps &stamps, LatencyStats &latency)
+{
+  while (blocks_count--)
+  {
+    const MessageBlock &block = *reinterpret_cast<const MessageBlock *>(buffer);
+    const uint16_t length = sizeof(block.length) + block.length;
+
+    PREFETCH_R(buffer + length, 1);
+    handleMessage(block.data);
+    latency.recordApplied(stamps, __rdtsc());
+
+    //every message but 'T' starts with its nanoseconds
+    if ((block.data.type != 'T') & (exchange_seconds != 0))
+      latency.recordExchange(stamps, exchange_seconds * 1'000'000'000 + block.data.series_info_basic.timestamp_nanoseconds);
+
+    buffer += length;
+  }
+
+  publishBooks();
+}
+
+//bursts are decoded whole with decodeMessageBlocks and applied book by book with applyBurst, instead of
+//message by message. Each book is then brought into cache once per burst. Messages are not cycle sampled
+template <typename Listener>
+COLD void BasicMessageHandler<Listener>::enableBursts(void) requires std::is_same_v<Listener, NoListener>
+{
+  burst = std::make_unique<Burst>();
+}
+
+//first phase, the book operations are queued and everything else is handled right away
+template <typename Listener>
+HOT void BasicMessageHandler<Listener>::decodeMessageBlocks(const char *restrict buffer, uint16_t blocks_count) requires std::is_same_v<Listener, NoListener>
+{
+  //a packet never has more operations than blocks
+  if (burst->ops_count + blocks_count > Burst::CAPACITY) [[unlikely]]
+    applyBurst();
+
+  while (blocks_count--)
+  {
+    const MessageBlock &block = *reinterpret_cast<const MessageBlock *>(buffer);
+    const MessageData &data = block.data;
+
+    buffer += sizeof(block.length) + block.length;
+    PREFETCH_R(buffer, 1);
+
+    HotCounters::increment(counters->messages[data.type]);
+
+    switch (data.type)
+    {
+      case 'A':
+      {
+        const DecodedMessage m = MessageDecoder::decode<'A'>(data);
+        if (m.price != INT32_MIN)
+          pushOperation(ADD_ORDER, m);
+        break;
+      }
+      case 'D':
+        pushOperation(REMOVE_ORDER, MessageDecoder::decode<'D'>(data));
+        break;
+      case 'E':
+        pushOperation(EXECUTE_ORDER, MessageDecoder::decode<'E'>(data));
+        break;
+      case 'C':
+        pushOperation(EXECUTE_ORDER, MessageDecoder::decode<'C'>(data));
+        break;
+      case 'Z':
+        pushOperation(SET_EQUILIBRIUM, MessageDecoder::decode<'Z'>(data));
+        break;
+#ifdef LADDER_BOOK
+      case 'L':
+        pushOperation(ADD_TICK_SIZE, MessageDecoder::decode<'L'>(data));
+        break;
+#endif
+      case 'T':
+        handleSeconds(data);
+        break;
+      case 'R':
+        handleSeriesInfoBasic(data);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+template <typename Listener>
+HOT ALWAYS_INLINE inline void BasicMessageHandler<Listener>::pushOperation(const Operation operation, const DecodedMessage &m) noexcept
+{
+  const uint32_t book_idx = book_index.find(m.orderbook_id);
+  const bool is_valid = (book_idx != BookIndex::NO_BOOK);
+
+  HotCounters::increment(counters->dropped, !is_valid);
+
+  if (!is_valid)
+    return;
+
+  Burst &ops = *burst;
+  const uint32_t op = ops.ops_count++;
+
+  ops.operations[op] = operation;
+  ops.sides[op] = (m.side == 'S');
+  ops.next[op] = Burst::NO_OP;
+  ops.order_ids[op] = m.order_id;
+  ops.prices[op] = m.price;
+  ops.qtys[op] = m.qty;
+
+  BurstChain &chain = burst_chains[book_idx];
+
+  if (chain.tail == Burst::NO_OP)
+  {
+    chain.head = op;
+    ops.books[ops.books_count++] = book_idx;
+  }
+  else
+    ops.next[chain.tail] = op;
+
+  chain.tail = op;
+}
+
+//second phase, every book gets its operations in arrival order, then the books are published
+template <typename Listener>
+HOT void BasicMessageHandler<Listener>::applyBurst(void) requires std::is_same_v<Listener, NoListener>
+{
+  Burst &ops = *burst;
+
+  for (uint32_t i = 0; i < ops.books_count; ++i)
+  {
+    const uint32_t book_idx = ops.books[i];
+    BurstChain &chain = burst_chains[book_idx];
+    Book &book = order_books[book_idx];
+
+    for (uint32_t op = chain.head; op != Burst::NO_OP; op = ops.next[op])
+    {
+      const typename Book::Side side = static_cast<typename Book::Side>(ops.sides[op]);
+
+      switch (ops.operations[op])
+      {
+        case ADD_ORDER:
+          book.addOrder(ops.order_ids[op], side, ops.prices[op], ops.qtys[op]);
+          break;
+        case REMOVE_ORDER:
+          book.removeOrder(ops.order_ids[op], side);
+          break;
+        case EXECUTE_ORDER:
+          book.executeOrder(ops.order_ids[op], side, ops.qtys[op]);
+          break;
+        case SET_EQUILIBRIUM:
+          book.setEquilibrium(ops.prices[op], ops.order_ids[op], ops.qtys[op]);
+          break;
+#ifdef LADDER_BOOK
+        case ADD_TICK_SIZE:
+          book.addTickSize(ops.order_ids[op], ops.prices[op], static_cast<int32_t>(ops.qtys[op]));
+          break;
+#endif
+        default:
+          std::unreachable();
+      }
+    }
+
+    chain.tail = Burst::NO_OP;
+    dirty_books[book_idx / 64] |= 1ULL << (book_idx % 64);
+  }
+
+  ops.ops_count = 0;
+  ops.books_count = 0;
+
+  publishBooks();
+}
+
+//the books changed since the last call, once per packet
+template <typename Listener>
+HOT void BasicMessageHandler<Listener>::publishBooks(void) noexcept
+{
+  if (publisher == nullptr)
+    return;
+
+  for (size_t word_idx = 0; word_idx < dirty_books.size(); ++word_idx)
+  {
+    for (uint64_t &word = dirty_books[word_idx]; word != 0; word &= word - 1)
+    {
+      const size_t book_idx = word_idx * 64 + __builtin_ctzll(word);
+      publisher->publish(*book_slots[book_idx], order_books[book_idx]);
+    }
+  }
+}
+
+template <typename Listener>
+HOT void BasicMessageHandler<Listener>::handleNewOrder(const MessageData &data)
+{
+  const DecodedMessage m = MessageDecoder::decode<'A'>(data);
+
+  if (m.price == INT32_MIN) [[unlikely]]
+    return handleNewMarketOrder(m);
+  handleNewLimitOrder(m);
+}
+
+//snapshot phase: new orders are held per book until loadSnapshot builds the books in one pass each.
+//Listeners get no events from a bulk load, with one every message is applied as it comes
+template <typename Listener>
+COLD void BasicMessageHandler<Listener>::stageSnapshotMessage(const MessageData &data)
+{
+  if constexpr (!std::is_same_v<Listener, NoListener>)
+    return handleMessage(data);
+
+  switch (data.type)
+  {
+    case 'A':
+      return stageNewOrder(data);
+    //whatever reduces an order sees the books with the orders staged before it
+    case 'D':
+    case 'E':
+    case 'C':
+      loadSnapshot();
+      [[fallthrough]];
+    default:
+      handleMessage(data);
+  }
+}
+
+template <typename Listener>
+COLD void BasicMessageHandler<Listener>::stageNewOrder(const MessageData &data)
+{
+  const DecodedMessage m = MessageDecoder::decode<'A'>(data);
+
+  if (m.price == INT32_MIN) [[unlikely]]
+    return handleNewMarketOrder(m);
+
+  const Book *book = getOrderBook(m.orderbook_id);
+  HotCounters::increment(counters->dropped, !book);
+  if (book == nullptr) [[unlikely]]
+    return;
+
+  //books keep being added while the snapshot is read, indexes stay valid where pointers would not
+  const uint32_t book_idx = book - order_books.data();
+  snapshot_orders.resize(order_books.size());
+
+  auto &orders = snapshot_orders[book_idx];
+  if (orders.empty())
+    snapshot_books.push_back(book_idx);
+
+  const typename Book::Side side = static_cast<typename Book::Side>(m.side == 'S');
+  orders.push_back({ m.order_id, m.qty, m.price, side });
+}
+
+//books share nothing, each core builds the next book nobody took yet. The books count into one slot per
+//thread, added to the handler's once the threads joined so that its counters keep a single writer
+template <typename Listener>
+COLD void BasicMessageHandler<Listener>::loadSnapshot(void)
+{
+  if (snapshot_books.empty())
+    return;
+
+  std::atomic<size_t> next_book{0};
+
+  const auto load = [&](HotCounters::Slot &slot) noexcept
+  {
+    for (size_t i; (i = next_book.fetch_add(1, std::memory_order_relaxed)) < snapshot_books.size();)
+    {
+      const uint32_t book_idx = snapshot_books[i];
+      Book &book = order_books[book_idx];
+
+      book.setCounters(slot);
+      book.bulkLoad(snapshot_orders[book_idx]);
+      book.setCounters(*counters);
+      std::vector<typename Book::BulkOrder>().swap(snapshot_orders[book_idx]);
+    }
+  };
+
+  //a few staged orders, like the ones before a reduction, are not worth starting threads for
+  size_t staged_orders = 0;
+  for (const uint32_t book_idx : snapshot_books)
+    staged_orders += snapshot_orders[book_idx].size();
+
+  const size_t threads_count = (staged_orders < SNAPSHOT_PARALLEL_ORDERS) ? 1
+    : std::clamp<size_t>(std::thread::hardware_concurrency(), 1, snapshot_books.size());
+  std::vector<HotCounters::Slot> slots(threads_count);
+
+  {
+    std::vector<std::jthread> threads;
+    for (size_t i = 1; i < threads_count; ++i)
+      threads.emplace_back(load, std::ref(slots[i]));
+    load(slots[0]);
+  }
+
+  for (const HotCounters::Slot &slot : slots)
+  {
+    HotCounters::increment(counters->new_levels, slot.new_levels);
+    HotCounters::increment(counters->existing_levels, slot.existing_levels);
+    HotCounters::increment(counters->removed_levels, slot.removed_levels);
+    HotCounters::raise(counters->max_depth[0], slot.max_depth[0]);
+    HotCounters::raise(counters->max_depth[1], slot.max_depth[1]);
+  }
+
+  for (const uint32_t book_idx : snapshot_books)
+    dirty_books[book_idx / 64] |= 1ULL << (book_idx % 64);
+  snapshot_books.clear();
+}
+
+template <typename Listener>
+HOT void BasicMessageHandler<Listener>::handleDeletedOrder(const MessageData &data)
+{
+  static constexpr auto op = [](Book *book, const DecodedMessage &m) noexcept
+  {
+    const Book::Side side = static_cast<Book::Side>(m.side == 'S');
+    book->removeOrder(m.order_id, side);
+  };
+
+  processOrderBookOperation<REMOVE_ORDER, decltype(op)>(MessageDecoder::decode<'D'>(data));
+}
+
+template <typename Listener>
+HOT void BasicMessageHandler<Listener>::handleExecutionNotice(const MessageData &data)
+{
+  static constexpr auto op = [](Book *book, const DecodedMessage &m) noexcept
+  {
+    const Book::Side side = static_cast<Book::Side>(m.side == 'S');
+    book->executeOrder(m.order_id, side, m.qty);
+  };
+
+  processOrderBookOperation<EXECUTE_ORDER, decltype(op)>(MessageDecoder::decode<'E'>(data));
+}
+
+template <typename Listener>
+HOT void BasicMessageHandler<Listener>::handleExecutionNoticeWithTradeInfo(const MessageData &data)
+{
+  static constexpr auto op = [](Book *book, const DecodedMessage &m) noexcept
+  {
+    const Book::Side side = static_cast<Book::Side>(m.side == 'S');
+    book->executeOrder(m.order_id, side, m.qty);
+  };
+
+  processOrderBookOperation<EXECUTE_ORDER, decltype(op)>(MessageDecoder::decode<'C'>(data));
+}
+
+template <typename Listener>
+void BasicMessageHandler<Listener>::handleEquilibriumPrice(const MessageData &data)
+{
+  static constexpr auto op = [](Book *book, const DecodedMessage &m) noexcept
+  {
+    book->setEquilibrium(m.price, m.order_id, m.qty);
+  };
+
+  processOrderBookOperation<SET_EQUILIBRIUM, decltype(op)>(MessageDecoder::decode<'Z'>(data));
+}
+
+template <typename Listener>
+HOT void BasicMessageHandler<Listener>::handleSeconds(const MessageData &data)
+{
+  exchange_seconds = data.seconds.second;
+}
+
+template <typename Listener>
+COLD void BasicMessageHandler<Listener>::handleSeriesInfoBasic(const MessageData &data)
+{
+  const uint32_t orderbook_id = data.series_info_basic.orderbook_id;
+
+  if (book_index.contains(orderbook_id) == false)
+    return;
+
+  addOrderBook(orderbook_id);
+}
+
+template <typename Listener>
+COLD void BasicMessageHandler<Listener>::handleSeriesInfoBasicCombination(UNUSED const MessageData &data)
+{
+}
+
+template <typename Listener>
+COLD void BasicMessageHandler<Listener>::handleTickSizeData(UNUSED const MessageData &data)
+{
+#ifdef LADDER_BOOK
+  static constexpr auto op = [](Book *book, const DecodedMessage &m) noexcept
+  {
+    book->addTickSize(m.order_id, m.price, static_cast<int32_t>(m.qty));
+  };
+
+  processOrderBookOperation<ADD_TICK_SIZE, decltype(op)>(MessageDecoder::decode<'L'>(data));
+#endif
+}
+
+template <typename Listener>
+COLD void BasicMessageHandler<Listener>::handleSystemEvent(UNUSED const MessageData &data)
+{
+}
+
+template <typename Listener>
+COLD void BasicMessageHandler<Listener>::handleTradingStatus(UNUSED const MessageData &data)
+{
+  //"M_ZARABA", "A_ZARABA_E", "A_ZARABA_E2", "N_ZARABA", "A_ZARABA"
+  // if (status[2] == 'Z')
+  //   resumeTrading();
+}
+
+template <typename Listener>
+HOT void BasicMessageHandler<Listener>::handleNewLimitOrder(const DecodedMessage &m)
+{
+  static constexpr auto op = [](Book *book, const DecodedMessage &m) noexcept
+  {
+    const Book::Side side = static_cast<Book::Side>(m.side == 'S');
+    book->addOrder(m.order_id, side, m.price, m.qty);
+  };
+
+  processOrderBookOperation<ADD_ORDER, decltype(op)>(m);
+}
+
+template <typename Listener>
+HOT void BasicMessageHandler<Listener>::handleNewMarketOrder(UNUSED const DecodedMessage &m)
+{
+}
+
+template <typename Listener>
+template <typename BasicMessageHandler<Listener>::Operation operation, typename Op>
+HOT void BasicMessageHandler<Listener>::processOrderBookOperation(const DecodedMessage &m)
+{
+  Book *book = getOrderBook(m.orderbook_id);
+  const uint8_t is_valid = !!book;
+
+  HotCounters::increment(counters->dropped, !is_valid);
+
+  if constexpr (std::is_same_v<Listener, NoListener>)
+  {
+    static constexpr Op op;
+    if (is_valid) [[likely]]
+      op(book, m);
+  }
+  else if (is_valid)
+    applyWithEvents<operation, Op>(*book, m);
+
+  //published at the end of the packet, a missing book marks nothing
+  const Book *marked = is_valid ? book : order_books.data();
+  const size_t book_idx = marked - order_books.data();
+  dirty_books[book_idx / 64] |= static_cast<uint64_t>(is_valid) << (book_idx % 64);
+}
+
+//the events of an operation come from the book before and after it, the lookups are only paid for the
+//events the listener hides
+template <typename Listener>
+template <typename BasicMessageHandler<Listener>::Operation operation, typename Op>
+HOT ALWAYS_INLINE inline void BasicMessageHandler<Listener>::applyWithEvents(Book &book, const DecodedMessage &m)
+{
+  static constexpr bool bbo_events = LISTENS_TO(Listener, onBboChanged);
+  static constexpr bool level_events = LISTENS_TO(Listener, onLevelCreated) || LISTENS_TO(Listener, onLevelRemoved);
+  static constexpr bool order_events = (operation == ADD_ORDER) ? LISTENS_TO(Listener, onOrderAdded)
+    : (operation == REMOVE_ORDER) ? LISTENS_TO(Listener, onOrderRemoved)
+    : (operation == EXECUTE_ORDER) ? LISTENS_TO(Listener, onOrderExecuted) : false;
+
+  const uint32_t orderbook_id = m.orderbook_id;
+  static constexpr Op op;
+
+  int32_t bid_price = 0;
+  int32_t ask_price = 0;
+  uint64_t bid_qty = 0;
+  uint64_t ask_qty = 0;
+
+  if constexpr (bbo_events)
+  {
+    bid_price = book.getBestBidPrice();
+    ask_price = book.getBestAskPrice();
+    bid_qty = book.getBestBidQty();
+    ask_qty = book.getBestAskQty();
+  }
+
+  if constexpr ((operation == ADD_ORDER || operation == REMOVE_ORDER || operation == EXECUTE_ORDER) && (order_events || level_events))
+  {
+    const typename Book::Side side = static_cast<typename Book::Side>(m.side == 'S');
+
+    int32_t price = m.price;
+    uint64_t qty = m.qty;
+
+    //the book ignores orders it does not have
+    if constexpr (operation != ADD_ORDER)
+      if (!book.findOrder(m.order_id, side, price, qty)) [[unlikely]]
+        return;
+
+    uint64_t level_qty = 0;
+    if constexpr (level_events)
+      level_qty = book.getLevelQty(side, price);
+
+    op(&book, m);
+
+    if constexpr (operation == ADD_ORDER)
+      listener.onOrderAdded(orderbook_id, side, m.order_id, price, qty);
+    else if constexpr (operation == REMOVE_ORDER)
+      listener.onOrderRemoved(orderbook_id, side, m.order_id, price, qty);
+    else
+      listener.onOrderExecuted(orderbook_id, side, m.order_id, price, (m.qty < qty) ? m.qty : qty);
+
+    if constexpr (level_events)
+    {
+      const uint64_t new_level_qty = book.getLevelQty(side, price);
+
+      if ((level_qty == 0) & (new_level_qty != 0))
+        listener.onLevelCreated(orderbook_id, side, price);
+      if ((level_qty != 0) & (new_level_qty == 0))
+        listener.onLevelRemoved(orderbook_id, side, price);
+    }
+  }
+  else
+  {
+    op(&book, m);
+
+    if constexpr (operation == SET_EQUILIBRIUM)
+      listener.onEquilibriumUpdated(orderbook_id, book.getEquilibriumPrice(), book.getEquilibriumBidQty(), book.getEquilibriumAskQty());
+  }
+
+  if constexpr (bbo_events)
+  {
+    const bool bbo_changed = (book.getBestBidPrice() != bid_price) | (book.getBestAskPrice() != ask_price)
+      | (book.getBestBidQty() != bid_qty) | (book.getBestAskQty() != ask_qty);
+
+    if (bbo_changed)
+      listener.onBboChanged(orderbook_id, book.getBestBidPrice(), book.getBestBidQty(), book.getBestAskPrice(), book.getBestAskQty());
+  }
+}
+
+template <typename Listener>
+HOT inline typename BasicMessageHandler<Listener>::Book *BasicMessageHandler<Listener>::getOrderBook(const uint32_t orderbook_id) noexcept
+{
+  uint32_t idx = book_index.find(orderbook_id);
+
+  const bool found = (idx != BookIndex::NO_BOOK);
+  idx *= found;
+
+  Book *book = order_books.data() + idx;
+  return reinterpret_cast<Book *>(found * reinterpret_cast<uintptr_t>(book));
+}
\ No newline at end of file
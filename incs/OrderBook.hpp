@@ -5,7 +5,7 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-03-22 14:14:57                                                 
-last edited: 2025-04-30 15:40:07                                                
+last edited: 2025-06-28 10:36:18                                                
 
 ================================================================================*/
 
@@ -13,8 +13,14 @@ last edited: 2025-04-30 15:40:07
 
 #include <cstdint>
 #include <array>
+#include <new>
+#include <span>
 #include <vector>
 
+#include "HotCounters.hpp"
+#include "OrderIndex.hpp"
+#include "OrderPool.hpp"
+#include "Config.hpp"
 #include "macros.hpp"
 
 class OrderBook
@@ -26,6 +32,20 @@ class OrderBook
 
     enum Side : uint8_t { BID = 0, ASK = 1 };
 
+    struct Sweep
+    {
+      uint64_t filled_qty;    //less than asked when the side is thinner
+      double average_price;   //0 when nothing was filled
+    };
+
+    struct BulkOrder
+    {
+      uint64_t id;
+      uint64_t qty;
+      int32_t price;
+      Side side;
+    };
+
     inline int32_t getBestBidPrice(void) const noexcept;
     inline int32_t getBestAskPrice(void) const noexcept;
     inline uint64_t getBestBidQty(void) const noexcept;
@@ -33,46 +53,111 @@ class OrderBook
     inline int32_t getEquilibriumPrice(void) const noexcept;
     inline uint64_t getEquilibriumBidQty(void) const noexcept;
     inline uint64_t getEquilibriumAskQty(void) const noexcept;
+    inline uint64_t getStamp(void) const noexcept;
+    uint32_t copyTopLevels(const Side side, int32_t *restrict prices, uint64_t *restrict qtys, const uint32_t depth) const noexcept;
+    uint64_t getQtyWithin(const Side side, const uint32_t distance) const noexcept;
+    Sweep getSweep(const Side side, const uint64_t qty) const noexcept;
+    bool findOrder(const uint64_t id, const Side side, int32_t &price, uint64_t &qty) noexcept;
+    uint64_t getLevelQty(const Side side, const int32_t price) const noexcept;
 
     void addOrder(const uint64_t id, const Side side, const int32_t price, const uint64_t qty);
     void removeOrder(const uint64_t id, const Side side);
-    void removeOrder(const uint64_t id, const Side side, const int32_t price, const uint64_t qty);
     void executeOrder(const uint64_t id, const Side side, const uint64_t qty);
+    void bulkLoad(std::span<BulkOrder> orders);
 
     inline void setEquilibrium(const int32_t price, const uint64_t bid_qty, const uint64_t ask_qty) noexcept;
+    inline void setCounters(HotCounters::Slot &slot) noexcept;
+
+    OrderPool::Stats getPoolStats(void) const noexcept;
+
+    void save(CheckpointWriter &writer) const;
+    void load(CheckpointReader &reader);
 
   private:
 
-    struct PriceLevels
+    static_assert(HOT_LEVELS >= 4 && HOT_LEVELS % 4 == 0, "HOT_LEVELS must be a multiple of 4");
+
+    //a full hot block spills its worse half to the cold levels, and takes them back when down to a quarter
+    static constexpr uint32_t HOT_SPILL = HOT_LEVELS / 2;
+    static constexpr uint32_t HOT_REFILL = HOT_LEVELS / 4;
+
+    static constexpr std::array<int32_t, 2> SENTINEL_PRICES = { INT32_MIN, INT32_MAX };
+
+    //everything a top of book read needs, in one line. Sides without levels read as the cold sentinels
+    struct alignas(CACHELINE_SIZE) Touch
+    {
+      std::array<uint64_t, 2> best_qtys;
+      std::array<int32_t, 2> best_prices;
+      int32_t equilibrium_price;
+      uint64_t equilibrium_bid_qty;
+      uint64_t equilibrium_ask_qty;
+      uint64_t stamp; //changes applied to the book
+    };
+
+    //the best levels of a side, inline in the book and sorted best last. A side only has cold levels behind a
+    //hot one, and they are all worse
+    struct alignas(CACHELINE_SIZE) HotLevels
+    {
+      std::array<uint64_t, HOT_LEVELS> cumulative_qtys;
+      std::array<int32_t, HOT_LEVELS> prices;
+      uint32_t count;
+      uint32_t cold_count; //levels behind the hot ones
+      std::array<OrderQueue, HOT_LEVELS> queues;
+    };
+
+    struct ColdLevels
     {
-      //sorted with best price last. prices[i] and cumulative_qtys[i] are the same price level
+      //sorted with best price last after the sentinel. prices[i], cumulative_qtys[i] and queues[i] are the same price level
       std::vector<int32_t> prices;
       std::vector<uint64_t> cumulative_qtys;
 
-      //unsorted, order_ids[i][j] and order_qtys[i][j] are the same order
-      std::vector<std::vector<uint64_t>> order_ids;
-      std::vector<std::vector<uint64_t>> order_qtys;
+      //unsorted, the orders of each level live in the book's order pool
+      std::vector<OrderQueue> queues;
     };
 
-    std::array<PriceLevels, 2> book_sides;
+    Touch touch;
+    std::array<HotLevels, 2> hot_sides;
+    std::array<ColdLevels, 2> cold_sides;
 
-    int32_t equilibrium_price;
-    uint64_t equilibrium_bid_qty;
-    uint64_t equilibrium_ask_qty;
+    //order ids are only unique per book and side
+    std::array<OrderIndex, 2> order_indexes;
+    OrderPool order_pool;
+
+    HotCounters::Slot *counters;
+
+    inline void refreshTouch(const Side side) noexcept;
+    inline void pushOrder(OrderQueue &queue, const Side side, const uint64_t id, const int32_t price, const uint64_t qty);
 
     inline void addOrderBid(const uint64_t id, const int32_t price, const uint64_t qty);
     inline void addOrderAsk(const uint64_t id, const int32_t price, const uint64_t qty);
     template<typename Comparator>
-    void addOrder(PriceLevels &levels, const uint64_t id, const int32_t price, const uint64_t qty);
-    void addOrderToExistingPriceLevel(PriceLevels &levels, const size_t price_idx, UNUSED const int32_t price, const uint64_t id, const uint64_t qty);
-    void addOrderToNewPriceLevel(PriceLevels &levels, const size_t price_idx, const int32_t price, const uint64_t id, const uint64_t qty);
+    void addOrder(const Side side, const uint64_t id, const int32_t price, const uint64_t qty);
+    template<typename Comparator>
+    void addHotOrder(const Side side, const uint64_t id, const int32_t price, const uint64_t qty);
+    template<typename Comparator>
+    void addColdOrder(const Side side, const uint64_t id, const int32_t price, const uint64_t qty);
+
+    inline void removeOrderBid(const uint64_t id);
+    inline void removeOrderAsk(const uint64_t id);
+    inline void executeOrderBid(const uint64_t id, const uint64_t qty);
+    inline void executeOrderAsk(const uint64_t id, const uint64_t qty);
+    template<typename Comparator>
+    void executeOrder(const Side side, const uint64_t id, const uint64_t qty);
 
-    inline void removeOrderBid(const uint64_t id, const int32_t price, const uint64_t qty);
-    inline void removeOrderAsk(const uint64_t id, const int32_t price, const uint64_t qty);
     template<typename Comparator>
-    void removeOrder(PriceLevels &levels, const uint64_t id, const int32_t price, const uint64_t qty);
-    void removeOrderFromPriceLevel(PriceLevels &levels, const size_t price_idx, const uint64_t id);
-    void removePriceLevel(PriceLevels &levels, const size_t price_idx, const uint64_t id);
+    size_t findPriceLevel(const ColdLevels &cold, const int32_t price) const noexcept;
+    size_t findPriceLevel(const Side side, const int32_t price) const noexcept;
+    const OrderQueue &getQueue(const Side side, const int32_t price) const noexcept;
+    template<typename Comparator>
+    uint64_t getQtyWithin(const Side side, const int32_t limit) const noexcept;
+
+    bool reduceOrder(uint64_t &cumulative_qty, OrderQueue &queue, const Side side, OrderIndex::Entry *order, const uint64_t qty);
+    void removeOrderFromPriceLevel(OrderQueue &queue, const Side side, OrderIndex::Entry *order);
+    void removeHotLevel(const Side side, const uint32_t price_idx);
+    void removeColdLevel(const Side side, const size_t price_idx);
+
+    void spillHotLevels(const Side side);
+    void refillHotLevels(const Side side);
 };
 
 #include "OrderBook.inl"
\ No newline at end of file
@@ -5,7 +5,7 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-03-23 17:58:46                                                 
-last edited: 2025-04-30 15:40:07                                                
+last edited: 2025-06-28 10:36:18                                                
 
 ================================================================================*/
 
@@ -17,64 +17,107 @@ last edited: 2025-04-30 15:40:07
 
 extern volatile bool error;
 
+//top of book reads only touch the touch line
 HOT ALWAYS_INLINE inline int32_t OrderBook::getBestBidPrice(void) const noexcept
 {
-  return book_sides[BID].prices.back();
+  return touch.best_prices[BID];
 }
 
 HOT ALWAYS_INLINE inline int32_t OrderBook::getBestAskPrice(void) const noexcept
 {
-  return book_sides[ASK].prices.back();
+  return touch.best_prices[ASK];
 }
 
 HOT ALWAYS_INLINE inline uint64_t OrderBook::getBestBidQty(void) const noexcept
 {
-  return book_sides[BID].cumulative_qtys.back();
+  return touch.best_qtys[BID];
 }
 
 HOT ALWAYS_INLINE inline uint64_t OrderBook::getBestAskQty(void) const noexcept
 {
-  return book_sides[ASK].cumulative_qtys.back();
+  return touch.best_qtys[ASK];
 }
 
 HOT ALWAYS_INLINE inline int32_t OrderBook::getEquilibriumPrice(void) const noexcept
 {
-  return equilibrium_price;
+  return touch.equilibrium_price;
 }
 
 HOT ALWAYS_INLINE inline uint64_t OrderBook::getEquilibriumBidQty(void) const noexcept
 {
-  return equilibrium_bid_qty;
+  return touch.equilibrium_bid_qty;
 }
 
 HOT ALWAYS_INLINE inline uint64_t OrderBook::getEquilibriumAskQty(void) const noexcept
 {
-  return equilibrium_ask_qty;
+  return touch.equilibrium_ask_qty;
+}
+
+HOT ALWAYS_INLINE inline uint64_t OrderBook::getStamp(void) const noexcept
+{
+  return touch.stamp;
 }
 
 inline void OrderBook::setEquilibrium(const int32_t price, const uint64_t bid_qty, const uint64_t ask_qty) noexcept
 {
-  equilibrium_price = price;
-  equilibrium_bid_qty = bid_qty;
-  equilibrium_ask_qty = ask_qty;
+  touch.equilibrium_price = price;
+  touch.equilibrium_bid_qty = bid_qty;
+  touch.equilibrium_ask_qty = ask_qty;
+  touch.stamp++;
+}
+
+inline void OrderBook::setCounters(HotCounters::Slot &slot) noexcept
+{
+  counters = &slot;
+}
+
+//after every change of a side, the best hot level or the sentinel of the side
+HOT ALWAYS_INLINE inline void OrderBook::refreshTouch(const Side side) noexcept
+{
+  const HotLevels &hot = hot_sides[side];
+  const bool empty = (hot.count == 0);
+
+  touch.best_prices[side] = empty ? SENTINEL_PRICES[side] : hot.prices[hot.count - 1];
+  touch.best_qtys[side] = empty ? 0 : hot.cumulative_qtys[hot.count - 1];
+  touch.stamp++;
+}
+
+//indexes the order and appends it to the queue of its level
+HOT ALWAYS_INLINE inline void OrderBook::pushOrder(OrderQueue &queue, const Side side, const uint64_t id, const int32_t price, const uint64_t qty)
+{
+  OrderIndex &order_index = order_indexes[side];
+  OrderIndex::Entry *order = order_index.insert(id, price);
+
+  order->position = order_pool.push(queue, order_index.getKey(order), qty);
 }
 
 HOT ALWAYS_INLINE inline void OrderBook::addOrderBid(const uint64_t id, const int32_t price, const uint64_t qty)
 {
-  addOrder<std::less_equal<int32_t>>(book_sides[BID], id, price, qty);
+  addOrder<std::less_equal<int32_t>>(BID, id, price, qty);
 }
 
 HOT ALWAYS_INLINE inline void OrderBook::addOrderAsk(const uint64_t id, const int32_t price, const uint64_t qty)
 {
-  addOrder<std::greater_equal<int32_t>>(book_sides[ASK], id, price, qty);
+  addOrder<std::greater_equal<int32_t>>(ASK, id, price, qty);
+}
+
+//a removal executes the whole order
+HOT ALWAYS_INLINE inline void OrderBook::removeOrderBid(const uint64_t id)
+{
+  executeOrder<std::less<int32_t>>(BID, id, UINT64_MAX);
+}
+
+HOT ALWAYS_INLINE inline void OrderBook::removeOrderAsk(const uint64_t id)
+{
+  executeOrder<std::greater<int32_t>>(ASK, id, UINT64_MAX);
 }
 
-HOT ALWAYS_INLINE inline void OrderBook::removeOrderBid(const uint64_t id, const int32_t price, const uint64_t qty)
+HOT ALWAYS_INLINE inline void OrderBook::executeOrderBid(const uint64_t id, const uint64_t qty)
 {
-  removeOrder<std::less_equal<int32_t>>(book_sides[BID], id, price, qty);
+  executeOrder<std::less<int32_t>>(BID, id, qty);
 }
 
-HOT ALWAYS_INLINE inline void OrderBook::removeOrderAsk(const uint64_t id, const int32_t price, const uint64_t qty)
+HOT ALWAYS_INLINE inline void OrderBook::executeOrderAsk(const uint64_t id, const uint64_t qty)
 {
-  removeOrder<std::greater_equal<int32_t>>(book_sides[ASK], id, price, qty);
+  executeOrder<std::greater<int32_t>>(ASK, id, qty);
 }
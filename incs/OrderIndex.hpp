@@ -0,0 +1,81 @@
+/*================================================================================
+
+File: OrderIndex.hpp                                                            
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-05 18:12:40                                                 
+last edited: 2025-06-29 14:40:52                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "Checkpoint.hpp"
+#include "macros.hpp"
+
+//open addressing hash of order id -> (price level, position in the level queue).
+//linear probing with backward shift deletion, so there are no tombstones to clean up.
+//exchange order ids are never 0, which is used to mark empty slots.
+//with COMPACT_ORDERS the slots only hold 24 bit handles of entries kept densely in a separate array, tagged
+//with 8 more bits of the hash so that probes skip most other entries without loading them. That keeps long
+//chains cheap and the slots are filled up to 3/4. Order queues store the handle of each order instead of its id
+class OrderIndex
+{
+  public:
+    OrderIndex(void) noexcept;
+    OrderIndex(OrderIndex &&) noexcept;
+    ~OrderIndex();
+
+    struct Entry
+    {
+      uint64_t id;
+      int32_t price;
+      uint32_t position;
+    };
+
+    //what order queues store to get back to the entry of an order
+#ifdef COMPACT_ORDERS
+    using Key = uint32_t;
+#else
+    using Key = uint64_t;
+#endif
+
+    inline Entry *insert(const uint64_t id, const int32_t price);
+    inline Entry *find(const uint64_t id) noexcept;
+    inline void erase(Entry *entry) noexcept;
+
+    inline Key getKey(const Entry *entry) const noexcept;
+    inline Entry *resolve(const Key key) noexcept;
+
+    void save(CheckpointWriter &writer) const;
+    void load(CheckpointReader &reader);
+
+  private:
+    inline size_t getSlot(const uint64_t id) const noexcept;
+    void grow(void);
+
+#ifdef COMPACT_ORDERS
+    static constexpr uint32_t HANDLE_BITS = 24;
+    static constexpr uint32_t HANDLE_MASK = (1u << HANDLE_BITS) - 1;
+    static constexpr uint32_t EMPTY_SLOT = UINT32_MAX; //handle HANDLE_MASK is never given out
+
+    inline uint32_t getTag(const uint64_t id) const noexcept;
+
+    //erased entries are chained through their position
+    std::vector<uint32_t> slots;
+    std::vector<Entry> entries;
+    uint32_t free_handle;
+#else
+    std::vector<Entry> entries;
+#endif
+    size_t mask;
+    uint8_t shift;
+    size_t size;
+};
+
+#include "OrderIndex.inl"
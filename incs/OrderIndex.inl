@@ -0,0 +1,192 @@
+/*================================================================================
+
+File: OrderIndex.inl                                                            
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-05 18:12:40                                                 
+last edited: 2025-06-29 14:40:52                                                
+
+================================================================================*/
+
+#pragma once
+
+#include "OrderIndex.hpp"
+#include "macros.hpp"
+
+HOT ALWAYS_INLINE inline size_t OrderIndex::getSlot(const uint64_t id) const noexcept
+{
+  //fibonacci hashing, exchange ids are mostly sequential
+  static constexpr uint64_t golden_ratio = 0x9E3779B97F4A7C15;
+  return (id * golden_ratio) >> shift;
+}
+
+#ifdef COMPACT_ORDERS
+
+//the 8 hash bits right below the ones of the slot, in the top byte
+HOT ALWAYS_INLINE inline uint32_t OrderIndex::getTag(const uint64_t id) const noexcept
+{
+  static constexpr uint64_t golden_ratio = 0x9E3779B97F4A7C15;
+  return static_cast<uint32_t>((id * golden_ratio) >> (shift - 8)) << HANDLE_BITS;
+}
+
+//the caller sets the position. Entries are reserved with the slots, the pointer stays valid until the next insert
+HOT ALWAYS_INLINE inline OrderIndex::Entry *OrderIndex::insert(const uint64_t id, const int32_t price)
+{
+  if ((size + 1) * 4 > slots.size() * 3) [[unlikely]]
+    grow();
+
+  uint32_t handle = free_handle;
+  if (handle != EMPTY_SLOT)
+    free_handle = entries[handle].position;
+  else
+  {
+    handle = entries.size();
+    entries.emplace_back();
+  }
+
+  size_t slot = getSlot(id);
+  while (slots[slot] != EMPTY_SLOT)
+    slot = (slot + 1) & mask;
+
+  slots[slot] = getTag(id) | handle;
+  size++;
+
+  Entry *entry = &entries[handle];
+  entry->id = id;
+  entry->price = price;
+  return entry;
+}
+
+HOT ALWAYS_INLINE inline OrderIndex::Entry *OrderIndex::find(const uint64_t id) noexcept
+{
+  const uint32_t tag = getTag(id);
+  size_t slot = getSlot(id);
+
+  while (true)
+  {
+    const uint32_t tagged_handle = slots[slot];
+    if (tagged_handle == EMPTY_SLOT)
+      return nullptr;
+
+    if ((tagged_handle & ~HANDLE_MASK) == tag)
+    {
+      Entry *entry = &entries[tagged_handle & HANDLE_MASK];
+      if (entry->id == id) [[likely]]
+        return entry;
+    }
+    slot = (slot + 1) & mask;
+  }
+}
+
+HOT ALWAYS_INLINE inline void OrderIndex::erase(Entry *entry) noexcept
+{
+  const uint32_t handle = entry - entries.data();
+
+  size_t hole = getSlot(entry->id);
+  while ((slots[hole] & HANDLE_MASK) != handle)
+    hole = (hole + 1) & mask;
+
+  size_t slot = (hole + 1) & mask;
+
+  //pull back every handle of the probe chain that would become unreachable through the hole
+  while (slots[slot] != EMPTY_SLOT)
+  {
+    const size_t home = getSlot(entries[slots[slot] & HANDLE_MASK].id);
+    const bool movable = ((slot - home) & mask) >= ((slot - hole) & mask);
+
+    if (movable)
+    {
+      slots[hole] = slots[slot];
+      hole = slot;
+    }
+
+    slot = (slot + 1) & mask;
+  }
+
+  slots[hole] = EMPTY_SLOT;
+
+  entry->id = 0;
+  entry->position = free_handle;
+  free_handle = handle;
+  size--;
+}
+
+HOT ALWAYS_INLINE inline OrderIndex::Key OrderIndex::getKey(const Entry *entry) const noexcept
+{
+  return entry - entries.data();
+}
+
+HOT ALWAYS_INLINE inline OrderIndex::Entry *OrderIndex::resolve(const Key key) noexcept
+{
+  return &entries[key];
+}
+
+#else
+
+//the caller sets the position, the pointer stays valid until the next insert
+HOT ALWAYS_INLINE inline OrderIndex::Entry *OrderIndex::insert(const uint64_t id, const int32_t price)
+{
+  if ((size + 1) * 2 > entries.size()) [[unlikely]]
+    grow();
+
+  size_t slot = getSlot(id);
+  while (entries[slot].id != 0)
+    slot = (slot + 1) & mask;
+
+  entries[slot] = { id, price, 0 };
+  size++;
+
+  return &entries[slot];
+}
+
+HOT ALWAYS_INLINE inline OrderIndex::Entry *OrderIndex::find(const uint64_t id) noexcept
+{
+  size_t slot = getSlot(id);
+
+  while (true)
+  {
+    Entry *entry = &entries[slot];
+    if (entry->id == id) [[likely]]
+      return entry;
+    if (entry->id == 0)
+      return nullptr;
+    slot = (slot + 1) & mask;
+  }
+}
+
+HOT ALWAYS_INLINE inline void OrderIndex::erase(Entry *entry) noexcept
+{
+  size_t hole = entry - entries.data();
+  size_t slot = (hole + 1) & mask;
+
+  //pull back every entry of the probe chain that would become unreachable through the hole
+  while (entries[slot].id != 0)
+  {
+    const size_t home = getSlot(entries[slot].id);
+    const bool movable = ((slot - home) & mask) >= ((slot - hole) & mask);
+
+    if (movable)
+    {
+      entries[hole] = entries[slot];
+      hole = slot;
+    }
+
+    slot = (slot + 1) & mask;
+  }
+
+  entries[hole].id = 0;
+  size--;
+}
+
+HOT ALWAYS_INLINE inline OrderIndex::Key OrderIndex::getKey(const Entry *entry) const noexcept
+{
+  return entry->id;
+}
+
+HOT ALWAYS_INLINE inline OrderIndex::Entry *OrderIndex::resolve(const Key key) noexcept
+{
+  return find(key);
+}
+
+#endif
@@ -0,0 +1,103 @@
+/*================================================================================
+
+File: OrderPool.hpp                                                             
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-12 09:34:18                                                 
+last edited: 2025-06-28 10:36:18                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <vector>
+
+#include "Checkpoint.hpp"
+#include "OrderIndex.hpp"
+#include "Config.hpp"
+#include "macros.hpp"
+
+//per level order queue, a block of the pool holding ORDER_QUEUE_MIN_CAPACITY << size_class orders
+struct OrderQueue
+{
+  uint32_t offset;
+  uint32_t size;
+  uint8_t size_class;
+};
+
+//preallocated storage for the order queues of a book. Blocks are carved out of two flat arrays (order index
+//keys and quantities) and recycled through one intrusive free list per size class, so once warmed up adding
+//and removing orders and levels never touches the allocator.
+//with COMPACT_ORDERS quantities are 32 bit, the rare one that needs the top bit is kept aside and the slot
+//holds its index with the top bit set
+class OrderPool
+{
+  public:
+    OrderPool(void) noexcept;
+    OrderPool(OrderPool &&) noexcept;
+    ~OrderPool();
+
+    struct Stats
+    {
+      size_t capacity;  //order slots preallocated
+      size_t reserved;  //order slots ever carved out of the arrays
+      size_t allocated; //order slots in blocks currently owned by a queue
+      size_t orders;    //order slots in use
+      size_t grows;     //times the arrays outgrew the preallocation
+    };
+
+    inline OrderQueue allocate(void);
+    inline void release(const OrderQueue &queue) noexcept;
+
+    inline uint32_t push(OrderQueue &queue, const OrderIndex::Key key, const uint64_t qty);
+    inline OrderIndex::Key remove(OrderQueue &queue, const uint32_t position) noexcept;
+
+    inline const OrderIndex::Key *getKeys(const OrderQueue &queue) const noexcept;
+    inline uint64_t getQty(const OrderQueue &queue, const uint32_t position) const noexcept;
+    inline void setQty(const OrderQueue &queue, const uint32_t position, const uint64_t qty);
+
+    Stats getStats(void) const noexcept;
+
+    void save(CheckpointWriter &writer) const;
+    void load(CheckpointReader &reader);
+
+  private:
+    static constexpr uint8_t SIZE_CLASSES = 24;
+    static constexpr uint32_t FREE_LIST_END = UINT32_MAX;
+
+#ifdef COMPACT_ORDERS
+    using Qty = uint32_t;
+    static constexpr Qty QTY_ESCAPE = 1u << 31;
+#else
+    using Qty = uint64_t;
+#endif
+
+    inline uint32_t allocateBlock(const uint8_t size_class);
+    inline void releaseBlock(const uint32_t offset, const uint8_t size_class) noexcept;
+    void grow(const uint32_t min_capacity);
+
+#ifdef COMPACT_ORDERS
+    Qty setLargeQty(const Qty stored, const uint64_t qty);
+    void dropLargeQtys(const OrderQueue &queue);
+#endif
+
+    //the first key of a free block is the offset of the next free block of the same class
+    std::vector<OrderIndex::Key> keys;
+    std::vector<Qty> qtys;
+#ifdef COMPACT_ORDERS
+    std::vector<uint64_t> large_qtys;
+    std::vector<uint32_t> free_large_qtys;
+#endif
+    std::array<uint32_t, SIZE_CLASSES> free_lists;
+    uint32_t top;
+
+    size_t allocated;
+    size_t orders;
+    size_t grows;
+};
+
+#include "OrderPool.inl"
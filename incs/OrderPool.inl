@@ -0,0 +1,136 @@
+/*================================================================================
+
+File: OrderPool.inl                                                             
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-12 09:34:18                                                 
+last edited: 2025-06-28 10:36:18                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstring>
+
+#include "OrderPool.hpp"
+#include "macros.hpp"
+
+HOT ALWAYS_INLINE inline OrderQueue OrderPool::allocate(void)
+{
+  return { allocateBlock(0), 0, 0 };
+}
+
+HOT ALWAYS_INLINE inline void OrderPool::release(const OrderQueue &queue) noexcept
+{
+#ifdef COMPACT_ORDERS
+  //orders can leave with their whole queue still resting, like when a ladder moves its window
+  if (large_qtys.size() != free_large_qtys.size()) [[unlikely]]
+    dropLargeQtys(queue);
+#endif
+  orders -= queue.size;
+  releaseBlock(queue.offset, queue.size_class);
+}
+
+HOT ALWAYS_INLINE inline uint32_t OrderPool::push(OrderQueue &queue, const OrderIndex::Key key, const uint64_t qty)
+{
+  const uint32_t capacity = ORDER_QUEUE_MIN_CAPACITY << queue.size_class;
+
+  //a full queue moves to a block of the next size class
+  if (queue.size == capacity) [[unlikely]]
+  {
+    const uint32_t offset = allocateBlock(queue.size_class + 1);
+
+    std::memcpy(&keys[offset], &keys[queue.offset], capacity * sizeof(OrderIndex::Key));
+    std::memcpy(&qtys[offset], &qtys[queue.offset], capacity * sizeof(Qty));
+    releaseBlock(queue.offset, queue.size_class);
+
+    queue.offset = offset;
+    queue.size_class++;
+  }
+
+  const uint32_t position = queue.size++;
+  keys[queue.offset + position] = key;
+  qtys[queue.offset + position] = 0;
+  orders++;
+
+  setQty(queue, position, qty);
+  return position;
+}
+
+//the last order of the queue takes the place of the removed one, left at 0 before so any large qty is freed.
+//the key of the moved order is returned to update its position
+HOT ALWAYS_INLINE inline OrderIndex::Key OrderPool::remove(OrderQueue &queue, const uint32_t position) noexcept
+{
+  const uint32_t last = queue.offset + queue.size - 1;
+  const OrderIndex::Key last_key = keys[last];
+
+  keys[queue.offset + position] = last_key;
+  qtys[queue.offset + position] = qtys[last];
+  queue.size--;
+  orders--;
+
+  return last_key;
+}
+
+HOT ALWAYS_INLINE inline const OrderIndex::Key *OrderPool::getKeys(const OrderQueue &queue) const noexcept
+{
+  return &keys[queue.offset];
+}
+
+HOT ALWAYS_INLINE inline uint64_t OrderPool::getQty(const OrderQueue &queue, const uint32_t position) const noexcept
+{
+  const Qty qty = qtys[queue.offset + position];
+
+#ifdef COMPACT_ORDERS
+  if (qty & QTY_ESCAPE) [[unlikely]]
+    return large_qtys[qty & ~QTY_ESCAPE];
+#endif
+  return qty;
+}
+
+//an order left at 0 is about to be removed
+HOT ALWAYS_INLINE inline void OrderPool::setQty(const OrderQueue &queue, const uint32_t position, const uint64_t qty)
+{
+  Qty &stored = qtys[queue.offset + position];
+
+#ifdef COMPACT_ORDERS
+  if ((stored & QTY_ESCAPE) | (qty >= QTY_ESCAPE)) [[unlikely]]
+  {
+    stored = setLargeQty(stored, qty);
+    return;
+  }
+#endif
+  stored = qty;
+}
+
+HOT ALWAYS_INLINE inline uint32_t OrderPool::allocateBlock(const uint8_t size_class)
+{
+  const uint32_t block_size = ORDER_QUEUE_MIN_CAPACITY << size_class;
+  uint32_t &head = free_lists[size_class];
+  uint32_t offset = head;
+
+  allocated += block_size;
+
+  if (offset != FREE_LIST_END) [[likely]]
+  {
+    head = keys[offset];
+    return offset;
+  }
+
+  if (top + block_size > keys.size()) [[unlikely]]
+    grow(top + block_size);
+
+  offset = top;
+  top += block_size;
+  return offset;
+}
+
+HOT ALWAYS_INLINE inline void OrderPool::releaseBlock(const uint32_t offset, const uint8_t size_class) noexcept
+{
+  uint32_t &head = free_lists[size_class];
+
+  allocated -= ORDER_QUEUE_MIN_CAPACITY << size_class;
+  keys[offset] = head;
+  head = offset;
+}
@@ -0,0 +1,53 @@
+/*================================================================================
+
+File: PacketRing.hpp                                                            
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-08 16:42:13                                                 
+last edited: 2025-06-14 10:03:37                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <netinet/in.h>
+
+#include "Packets.hpp"
+#include "Config.hpp"
+#include "macros.hpp"
+
+//receives the multicast feed from a TPACKET_V3 (PACKET_MMAP) ring bound to the feed interface instead of a udp socket.
+//a classic BPF filter keeps only udp datagrams to the group and port, the kernel fills blocks of the shared ring
+//and MoldUDP64 packets are read in place, a whole block at a time, with no syscall or copy per packet.
+//a block is handed to userspace once full or PACKET_RING_BLOCK_TIMEOUT_MS after its first packet, which bounds the
+//added latency on a quiet feed. the group must still be joined from a regular socket for the switch to forward it
+class PacketRing
+{
+  public:
+    PacketRing(const std::string &interface, const sockaddr_in &group_address) noexcept;
+    ~PacketRing();
+
+    void open(void);
+
+    template <typename Callback>
+    void receive(Callback &&callback);
+
+  private:
+    static constexpr size_t RING_SIZE = static_cast<size_t>(PACKET_RING_BLOCK_SIZE) * PACKET_RING_BLOCKS_COUNT;
+
+    void attachFilter(void) const;
+    void setupRing(void);
+    void bindInterface(void) const;
+
+    const std::string interface;
+    const sockaddr_in group_address;
+    int sock_fd;
+    char *ring;
+    uint32_t block_index;
+};
+
+#include "PacketRing.tpp"
@@ -0,0 +1,65 @@
+/*================================================================================
+
+File: PacketRing.tpp                                                            
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-08 16:42:13                                                 
+last edited: 2025-06-17 10:12:48                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <linux/if_packet.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+
+#include "PacketRing.hpp"
+#include "error.hpp"
+#include "macros.hpp"
+
+//waits for the next block, calls callback(packet, size, nic_ns) for each MoldUDP64 packet in it and gives the block back.
+//packets are only size bytes long, never read past their message blocks. nic_ns is the kernel receive time, CLOCK_REALTIME
+template <typename Callback>
+HOT void PacketRing::receive(Callback &&callback)
+{
+  tpacket_block_desc &block = *reinterpret_cast<tpacket_block_desc *>(ring + static_cast<size_t>(block_index) * PACKET_RING_BLOCK_SIZE);
+  std::atomic_ref<uint32_t> status(block.hdr.bh1.block_status);
+
+  if (!(status.load(std::memory_order_acquire) & TP_STATUS_USER)) [[unlikely]]
+  {
+    pollfd fd = { sock_fd, POLLIN | POLLERR, 0 };
+    while (!(status.load(std::memory_order_acquire) & TP_STATUS_USER))
+    {
+      error |= (poll(&fd, 1, -1) == -1 && errno != EINTR);
+      CHECK_ERROR;
+    }
+  }
+
+  const char *frame = reinterpret_cast<const char *>(&block) + block.hdr.bh1.offset_to_first_pkt;
+  uint32_t packets_count = block.hdr.bh1.num_pkts;
+
+  while (packets_count--)
+  {
+    const tpacket3_hdr &header = *reinterpret_cast<const tpacket3_hdr *>(frame);
+    const char *const datagram = frame + header.tp_net;
+    const iphdr &ip = *reinterpret_cast<const iphdr *>(datagram);
+    const udphdr &udp = *reinterpret_cast<const udphdr *>(datagram + ip.ihl * 4);
+    const char *const payload = reinterpret_cast<const char *>(&udp) + sizeof(udphdr);
+
+    PREFETCH_R(frame + header.tp_next_offset, 1);
+
+    const uint64_t nic_ns = header.tp_sec * 1'000'000'000ull + header.tp_nsec;
+
+    callback(*reinterpret_cast<const MoldUDP64Packet *>(payload), static_cast<uint16_t>(ntohs(udp.len) - sizeof(udphdr)), nic_ns);
+    frame += header.tp_next_offset;
+  }
+
+  status.store(TP_STATUS_KERNEL, std::memory_order_release);
+  block_index = (block_index + 1) % PACKET_RING_BLOCKS_COUNT;
+}
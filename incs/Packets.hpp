@@ -5,7 +5,7 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-03-23 22:29:52                                                 
-last edited: 2025-04-17 16:57:31                                                
+last edited: 2025-05-24 11:12:47                                                
 
 ================================================================================*/
 
@@ -13,6 +13,8 @@ last edited: 2025-04-17 16:57:31
 
 #include <boost/endian/arithmetic.hpp>
 
+#include "Config.hpp"
+
 using namespace boost::endian;
 
 #pragma pack(push, 1)
@@ -202,5 +204,11 @@ struct MessageBlock
   MessageData data;
 };
 
+struct MoldUDP64Packet
+{
+  MoldUDP64Header header;
+  char payload[MTU - sizeof(MoldUDP64Header)];
+};
+
 #pragma pack(pop)
 
@@ -0,0 +1,92 @@
+/*================================================================================
+
+File: Replayer.hpp                                                              
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-14 20:05:33                                                 
+last edited: 2025-06-22 10:41:05                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Checkpointer.hpp"
+#include "GapRecovery.hpp"
+#include "MessageHandler.hpp"
+#include "Workers.hpp"
+#include "Packets.hpp"
+
+//feeds a capture of the multicast feed through MessageHandler at full speed, no network involved.
+//accepted captures are pcap files (ethernet, linux cooked or raw ip) or length prefixed dumps,
+//where every MoldUDP64 packet is preceded by its length as a big endian uint16.
+//without explicit orderbook ids every book found in the capture is tracked.
+//with workers the throughput pass goes through the sharded path, books are then only created by their 'R' messages.
+//dropping packets opens gaps, which are filled from a Rewind server when one is given.
+//the latency pass times every message as the live feed does with latency_stats, every packet received right when it is handled.
+//the burst pass compares handling message by message with batch_bursts, packets grouped as recvmmsg bursts
+class Replayer
+{
+  public:
+    struct Options
+    {
+      uint16_t port;                  //udp port of the feed in pcap captures, any when 0
+      uint8_t workers_count;          //0 runs the throughput pass on this thread
+      uint32_t drop_every;            //drops every nth packet when not 0
+      std::string rewind;             //ip:port of the Rewind server, gaps are skipped when empty
+      std::string checkpoint;         //checkpoints the books after the throughput pass and restores them
+      std::vector<uint32_t> book_ids; //every book in the capture when empty
+    };
+
+    Replayer(const std::string_view path, const Options &options) noexcept;
+    ~Replayer() noexcept;
+
+    void run(void);
+
+  private:
+
+    void loadPcap(void);
+    void loadDump(void);
+    void addPacket(const char *data, const size_t length);
+    void collectBookIds(void);
+    void setupBooks(MessageHandler &handler) const;
+
+    void runThroughput(void);
+    void runShardedThroughput(void);
+    void runCheckpoint(const MessageHandler &handler);
+    void runProfile(void);
+    void runLatency(void);
+    void runBursts(void);
+
+    template <typename Callback>
+    uint64_t forEachPacket(Callback &&callback);
+
+    const char *capture;
+    size_t capture_size;
+    const uint16_t port;
+    const uint8_t workers_count;
+    const uint32_t drop_every;
+    const std::string checkpoint_path;
+    std::vector<uint32_t> book_ids;
+    std::unique_ptr<GapRecovery> recovery;
+    std::vector<std::span<const char>> packets;
+
+    struct Counters
+    {
+      uint64_t packets;
+      uint64_t messages;
+      uint64_t gaps;
+      uint64_t duplicates;
+      uint64_t next_sequence;
+      std::array<uint64_t, 'Z' + 1> counts;
+      std::array<uint64_t, 'Z' + 1> cycles;
+    } counters;
+};
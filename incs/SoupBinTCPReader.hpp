@@ -0,0 +1,48 @@
+/*================================================================================
+
+File: SoupBinTCPReader.hpp                                                      
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-26 11:07:42                                                 
+last edited: 2025-06-26 11:07:42                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+#include "Packets.hpp"
+#include "Config.hpp"
+#include "macros.hpp"
+
+//the SoupBinTCP stream of the snapshot session. The socket is read up to SNAPSHOT_READ_SIZE bytes at a time and
+//every complete packet of a read is handed out in place. A packet cut by the end of a read is moved to the front
+//of the buffer and completed by the next one, there is always room for a whole read after it
+class SoupBinTCPReader
+{
+  public:
+    SoupBinTCPReader(void);
+    ~SoupBinTCPReader();
+
+    inline char *claim(uint32_t &count) noexcept;
+    inline void commit(const uint32_t count) noexcept;
+    void read(const int fd);
+
+    template <typename Callback>
+    void forEachPacket(Callback &&callback);
+
+    void release(void);
+
+  private:
+    static constexpr uint32_t MAX_PACKET_SIZE = sizeof(SoupBinTCPPacket::body_length) + UINT16_MAX;
+    static constexpr uint32_t CAPACITY = MAX_PACKET_SIZE + SNAPSHOT_READ_SIZE;
+
+    std::unique_ptr<char[]> buffer;
+    uint32_t size; //bytes read and not handed out yet, from the start of the buffer
+};
+
+#include "SoupBinTCPReader.tpp"
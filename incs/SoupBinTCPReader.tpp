@@ -0,0 +1,56 @@
+/*================================================================================
+
+File: SoupBinTCPReader.tpp                                                      
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-26 11:07:42                                                 
+last edited: 2025-06-26 11:07:42                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstring>
+
+#include "SoupBinTCPReader.hpp"
+#include "macros.hpp"
+
+//free bytes past the unparsed ones, at least SNAPSHOT_READ_SIZE. count is how many
+HOT inline char *SoupBinTCPReader::claim(uint32_t &count) noexcept
+{
+  count = CAPACITY - size;
+  return buffer.get() + size;
+}
+
+HOT inline void SoupBinTCPReader::commit(const uint32_t count) noexcept
+{
+  size += count;
+}
+
+//the callback returns false to leave the packets after the current one for a later call
+template <typename Callback>
+COLD void SoupBinTCPReader::forEachPacket(Callback &&callback)
+{
+  static constexpr uint32_t length_size = sizeof(SoupBinTCPPacket::body_length);
+
+  char *const data = buffer.get();
+  uint32_t offset = 0;
+
+  while (size - offset >= length_size)
+  {
+    const SoupBinTCPPacket &packet = *reinterpret_cast<const SoupBinTCPPacket *>(data + offset);
+    const uint32_t packet_size = length_size + packet.body_length;
+
+    if (size - offset < packet_size)
+      break;
+
+    offset += packet_size;
+    if (!callback(packet))
+      break;
+  }
+
+  //at most one packet, cut by the end of the read
+  size -= offset;
+  std::memmove(data, data + offset, size);
+}
@@ -0,0 +1,70 @@
+/*================================================================================
+
+File: SpscRing.hpp                                                              
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-18 16:30:02                                                 
+last edited: 2025-05-18 16:30:02                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+
+#include "Config.hpp"
+#include "macros.hpp"
+
+//lock free single producer single consumer ring.
+//the producer claims contiguous runs of up to MaxClaim slots and makes everything claimed so far visible with commit(),
+//the consumer walks what was committed and hands the slots back with release(). head and tail only ever grow,
+//the MaxClaim - 1 slots past the end let a run that wraps stay contiguous in memory
+template <typename T, size_t Capacity, size_t MaxClaim = 1>
+class SpscRing
+{
+  static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+  static_assert(MaxClaim <= Capacity, "MaxClaim must fit in the ring");
+
+  public:
+    SpscRing(void) noexcept;
+    ~SpscRing();
+
+    //producer side
+    inline T *claim(const size_t count) noexcept;
+    inline void commit(void) noexcept;
+
+    //consumer side
+    inline size_t poll(void) noexcept;
+    inline const T *front(void) const noexcept;
+    inline void consume(const size_t count) noexcept;
+    inline void release(void) noexcept;
+    inline bool drained(void) const noexcept;
+
+  private:
+    static constexpr size_t mask = Capacity - 1;
+
+    void waitForSpace(const size_t count) noexcept;
+
+    alignas(CACHELINE_SIZE) std::atomic<size_t> head;
+    alignas(CACHELINE_SIZE) std::atomic<size_t> tail;
+
+    alignas(CACHELINE_SIZE) struct
+    {
+      size_t head;
+      size_t cached_tail;
+    } producer;
+
+    alignas(CACHELINE_SIZE) struct
+    {
+      size_t tail;
+      size_t cached_head;
+    } consumer;
+
+    std::unique_ptr<T[]> slots;
+};
+
+#include "SpscRing.tpp"
@@ -0,0 +1,95 @@
+/*================================================================================
+
+File: SpscRing.tpp                                                              
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-18 16:30:02                                                 
+last edited: 2025-05-18 16:30:02                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <immintrin.h>
+
+#include "SpscRing.hpp"
+#include "macros.hpp"
+
+template <typename T, size_t Capacity, size_t MaxClaim>
+COLD SpscRing<T, Capacity, MaxClaim>::SpscRing(void) noexcept :
+  head(0),
+  tail(0),
+  producer{0, 0},
+  consumer{0, 0},
+  slots(new T[Capacity + MaxClaim - 1])
+{
+}
+
+template <typename T, size_t Capacity, size_t MaxClaim>
+COLD SpscRing<T, Capacity, MaxClaim>::~SpscRing()
+{
+}
+
+template <typename T, size_t Capacity, size_t MaxClaim>
+HOT ALWAYS_INLINE inline T *SpscRing<T, Capacity, MaxClaim>::claim(const size_t count) noexcept
+{
+  if (producer.head + count - producer.cached_tail > Capacity) [[unlikely]]
+    waitForSpace(count);
+
+  T *slot = &slots[producer.head & mask];
+  producer.head += count;
+  return slot;
+}
+
+template <typename T, size_t Capacity, size_t MaxClaim>
+HOT ALWAYS_INLINE inline void SpscRing<T, Capacity, MaxClaim>::commit(void) noexcept
+{
+  head.store(producer.head, std::memory_order_release);
+}
+
+template <typename T, size_t Capacity, size_t MaxClaim>
+COLD NEVER_INLINE void SpscRing<T, Capacity, MaxClaim>::waitForSpace(const size_t count) noexcept
+{
+  //the consumer can only free what it can see
+  commit();
+
+  while (true)
+  {
+    producer.cached_tail = tail.load(std::memory_order_acquire);
+    if (producer.head + count - producer.cached_tail <= Capacity)
+      return;
+    _mm_pause();
+  }
+}
+
+template <typename T, size_t Capacity, size_t MaxClaim>
+HOT ALWAYS_INLINE inline size_t SpscRing<T, Capacity, MaxClaim>::poll(void) noexcept
+{
+  consumer.cached_head = head.load(std::memory_order_acquire);
+  return consumer.cached_head - consumer.tail;
+}
+
+template <typename T, size_t Capacity, size_t MaxClaim>
+HOT ALWAYS_INLINE inline const T *SpscRing<T, Capacity, MaxClaim>::front(void) const noexcept
+{
+  return &slots[consumer.tail & mask];
+}
+
+template <typename T, size_t Capacity, size_t MaxClaim>
+HOT ALWAYS_INLINE inline void SpscRing<T, Capacity, MaxClaim>::consume(const size_t count) noexcept
+{
+  consumer.tail += count;
+}
+
+template <typename T, size_t Capacity, size_t MaxClaim>
+HOT ALWAYS_INLINE inline void SpscRing<T, Capacity, MaxClaim>::release(void) noexcept
+{
+  tail.store(consumer.tail, std::memory_order_release);
+}
+
+template <typename T, size_t Capacity, size_t MaxClaim>
+COLD inline bool SpscRing<T, Capacity, MaxClaim>::drained(void) const noexcept
+{
+  return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+}
@@ -0,0 +1,82 @@
+/*================================================================================
+
+File: Workers.hpp                                                               
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-18 16:30:02                                                 
+last edited: 2025-06-19 10:27:14                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "BookIndex.hpp"
+#include "BookPublisher.hpp"
+#include "HotCounters.hpp"
+#include "MessageHandler.hpp"
+#include "Packets.hpp"
+#include "SpscRing.hpp"
+#include "Config.hpp"
+#include "macros.hpp"
+
+//shards order book processing over pinned worker threads.
+//the receiving thread splits packets and routes each message by orderbook id to the ring of the worker owning the book,
+//every worker runs its own MessageHandler over a disjoint set of books, counting into slot worker + 1 of the counters
+//and publishing its books after every batch it takes from its ring. a book is owned by exactly one worker
+//and rings are FIFO, so each book sees its messages in feed order. messages without a book are sent to every worker
+class Workers
+{
+  public:
+    Workers(const Config &config, HotCounters &counters, BookPublisher &publisher);
+    ~Workers();
+
+    inline size_t size(void) const noexcept;
+
+    void handleMessage(const MessageData &data, const uint16_t length);
+    void handleMessageBlocks(const char *restrict buffer, uint16_t blocks_count);
+    void flush(void) noexcept;
+
+    OrderPool::Stats getPoolStats(void) const noexcept;
+
+    static void pinThread(const int16_t core);
+
+  private:
+
+    struct alignas(CACHELINE_SIZE) Cell
+    {
+      char bytes[CACHELINE_SIZE];
+    };
+
+    static constexpr size_t MAX_RECORD_CELLS = (MTU + CACHELINE_SIZE - 1) / CACHELINE_SIZE;
+    using Ring = SpscRing<Cell, WORKER_RING_CAPACITY, MAX_RECORD_CELLS>;
+
+    struct Worker
+    {
+      Ring ring;
+      std::vector<uint32_t> book_ids;
+      std::atomic<const MessageHandler *> handler;
+      HotCounters::Slot *counters;
+      BookPublisher *publisher;
+      int16_t core;
+      std::jthread thread;
+    };
+
+    static void run(std::stop_token stop, Worker &worker);
+
+    inline void route(const uint32_t worker_idx, const MessageData &data, const uint16_t length) noexcept;
+    inline void dispatch(const MessageData &data, const uint16_t length) noexcept;
+    inline void commit(void) noexcept;
+
+    BookIndex routes;
+    std::vector<std::unique_ptr<Worker>> workers;
+    uint64_t dirty;
+};
+
+#include "Workers.inl"
@@ -0,0 +1,79 @@
+/*================================================================================
+
+File: Workers.inl                                                               
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-18 16:30:02                                                 
+last edited: 2025-05-18 16:30:02                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+#include "Workers.hpp"
+#include "macros.hpp"
+
+COLD inline size_t Workers::size(void) const noexcept
+{
+  return workers.size();
+}
+
+//records keep the wire layout of a message block, starting on a fresh cell
+HOT ALWAYS_INLINE inline void Workers::route(const uint32_t worker_idx, const MessageData &data, const uint16_t length) noexcept
+{
+  const size_t cells = (sizeof(MessageBlock::length) + length + sizeof(Cell) - 1) / sizeof(Cell);
+
+  MessageBlock &record = *reinterpret_cast<MessageBlock *>(workers[worker_idx]->ring.claim(cells));
+  record.length = length;
+  memcpy(&record.data, &data, length);
+  dirty |= (1ULL << worker_idx);
+}
+
+HOT ALWAYS_INLINE inline void Workers::dispatch(const MessageData &data, const uint16_t length) noexcept
+{
+  //offset of the orderbook id inside each message type, 0 for messages which are not tied to a book
+  static constexpr std::array<uint8_t, 'Z' + 1> id_offsets = []()
+  {
+    std::array<uint8_t, 'Z' + 1> id_offsets{};
+    id_offsets['A'] = offsetof(MessageData, new_order.orderbook_id);
+    id_offsets['D'] = offsetof(MessageData, deleted_order.orderbook_id);
+    id_offsets['E'] = offsetof(MessageData, execution_notice.orderbook_id);
+    id_offsets['C'] = offsetof(MessageData, execution_notice_with_trade_info.orderbook_id);
+    id_offsets['Z'] = offsetof(MessageData, ep.orderbook_id);
+    id_offsets['R'] = offsetof(MessageData, series_info_basic.orderbook_id);
+    id_offsets['M'] = offsetof(MessageData, series_info_basic_combination.combination_orderbook_id);
+    id_offsets['L'] = offsetof(MessageData, tick_size_data.orderbook_id);
+    id_offsets['O'] = offsetof(MessageData, trading_status.orderbook_id);
+    return id_offsets;
+  }();
+
+  const uint8_t id_offset = id_offsets[data.type];
+
+  if (id_offset == 0) [[unlikely]]
+  {
+    for (uint32_t worker_idx = 0; worker_idx < workers.size(); ++worker_idx)
+      route(worker_idx, data, length);
+    return;
+  }
+
+  const big_uint32_t &orderbook_id = *reinterpret_cast<const big_uint32_t *>(reinterpret_cast<const char *>(&data) + id_offset);
+  const uint32_t worker_idx = routes.find(orderbook_id);
+
+  if (worker_idx != BookIndex::NO_BOOK)
+    route(worker_idx, data, length);
+}
+
+HOT ALWAYS_INLINE inline void Workers::commit(void) noexcept
+{
+  while (dirty)
+  {
+    const uint32_t worker_idx = __builtin_ctzll(dirty);
+    workers[worker_idx]->ring.commit();
+    dirty &= dirty - 1;
+  }
+}
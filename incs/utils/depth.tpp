@@ -0,0 +1,138 @@
+/*================================================================================
+
+File: depth.tpp                                                                 
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-21 09:58:20                                                 
+last edited: 2025-06-21 09:58:20                                                
+
+================================================================================*/
+
+
+//no include guard, utils.tpp includes this once per instruction set.
+//depth queries only look a few levels deep, 256 bit vectors are used at every level above baseline
+
+//dst[i] = src[src.size() - 1 - i], for the book sides stored best last
+template <typename T>
+HOT void reverse_copy(std::span<const T> src, T *restrict dst) noexcept
+{
+  static_assert(sizeof(T) == sizeof(int32_t) || sizeof(T) == sizeof(int64_t), "T must be 32 or 64 bit");
+
+  const T *begin = src.data();
+  //one past the next element to copy
+  const T *it = begin + src.size();
+
+#if SIMD_ISA >= ISA_AVX2
+  static constexpr ptrdiff_t chunk_size = sizeof(__m256i) / sizeof(T);
+
+  while (it - begin >= chunk_size)
+  {
+    it -= chunk_size;
+    const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(it));
+
+    __m256i reversed;
+    if constexpr (sizeof(T) == sizeof(int32_t))
+      reversed = _mm256_permutevar8x32_epi32(chunk, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    else
+      reversed = _mm256_permute4x64_epi64(chunk, 0x1B);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), reversed);
+    dst += chunk_size;
+  }
+#endif
+
+  while (it > begin)
+    *dst++ = *--it;
+}
+
+template <typename T>
+HOT T sum(std::span<const T> data) noexcept
+{
+  static_assert(std::is_integral_v<T> && sizeof(T) == sizeof(int64_t), "T must be a 64 bit integer");
+
+  const T *it = data.data();
+  const T *end = it + data.size();
+  T total = 0;
+
+#if SIMD_ISA >= ISA_AVX2
+  static constexpr ptrdiff_t chunk_size = sizeof(__m256i) / sizeof(T);
+
+  //two accumulators, so consecutive adds do not wait on each other
+  __m256i totals[2] = { _mm256_setzero_si256(), _mm256_setzero_si256() };
+
+  for (; end - it >= 2 * chunk_size; it += 2 * chunk_size)
+  {
+    totals[0] = _mm256_add_epi64(totals[0], _mm256_loadu_si256(reinterpret_cast<const __m256i *>(it)));
+    totals[1] = _mm256_add_epi64(totals[1], _mm256_loadu_si256(reinterpret_cast<const __m256i *>(it + chunk_size)));
+  }
+
+  if (end - it >= chunk_size)
+  {
+    totals[0] = _mm256_add_epi64(totals[0], _mm256_loadu_si256(reinterpret_cast<const __m256i *>(it)));
+    it += chunk_size;
+  }
+
+  const __m256i both = _mm256_add_epi64(totals[0], totals[1]);
+  const __m128i half = _mm_add_epi64(_mm256_castsi256_si128(both), _mm256_extracti128_si256(both, 1));
+  total = _mm_cvtsi128_si64(half) + _mm_extract_epi64(half, 1);
+#endif
+
+  for (; it < end; ++it)
+    total += *it;
+
+  return total;
+}
+
+//takes qty from the levels at the end backwards, the best ones for a book side. Returns the qty it found and sets
+//the notional paid for it. Whole chunks of levels are summed as vectors until the one the qty runs out in, which
+//is finished one level at a time. Level qtys are converted to doubles exactly up to 2^52
+HOT inline uint64_t backward_sweep(std::span<const int32_t> prices, std::span<const uint64_t> qtys, const uint64_t qty, double &notional) noexcept
+{
+  //one past the next level to take
+  size_t idx = qtys.size();
+  uint64_t filled = 0;
+  double total = 0;
+
+#if SIMD_ISA >= ISA_AVX2
+  static constexpr size_t chunk_size = sizeof(__m256i) / sizeof(uint64_t);
+
+  //2^52 as the bits of a double, or-ing a qty below it in the mantissa and subtracting it back leaves the qty
+  const __m256i exponent = _mm256_set1_epi64x(0x4330000000000000);
+  const __m256d magic = _mm256_set1_pd(4503599627370496.0);
+  __m256d notionals = _mm256_setzero_pd();
+
+  while (idx >= chunk_size)
+  {
+    const __m256i chunk_qtys = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(qtys.data() + idx - chunk_size));
+    const __m128i pair = _mm_add_epi64(_mm256_castsi256_si128(chunk_qtys), _mm256_extracti128_si256(chunk_qtys, 1));
+    const uint64_t chunk_total = _mm_cvtsi128_si64(pair) + _mm_extract_epi64(pair, 1);
+
+    if (filled + chunk_total >= qty)
+      break;
+
+    const __m128i chunk_prices = _mm_loadu_si128(reinterpret_cast<const __m128i *>(prices.data() + idx - chunk_size));
+    const __m256d qtys_pd = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(chunk_qtys, exponent)), magic);
+    notionals = _mm256_add_pd(notionals, _mm256_mul_pd(_mm256_cvtepi32_pd(chunk_prices), qtys_pd));
+
+    filled += chunk_total;
+    idx -= chunk_size;
+  }
+
+  const __m128d halves = _mm_add_pd(_mm256_castpd256_pd128(notionals), _mm256_extractf128_pd(notionals, 1));
+  total = _mm_cvtsd_f64(_mm_add_sd(halves, _mm_unpackhi_pd(halves, halves)));
+#endif
+
+  while (idx > 0 && filled < qty)
+  {
+    --idx;
+    const uint64_t left = qty - filled;
+    const uint64_t taken = (qtys[idx] < left) ? qtys[idx] : left;
+
+    total += static_cast<double>(prices[idx]) * taken;
+    filled += taken;
+  }
+
+  notional = total;
+  return filled;
+}
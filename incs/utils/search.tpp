@@ -0,0 +1,168 @@
+/*================================================================================
+
+File: search.tpp                                                                
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-16 10:41:12                                                 
+last edited: 2025-05-16 10:41:12                                                
+
+================================================================================*/
+
+//no include guard, utils.tpp includes this once per instruction set.
+//the widest vectors allowed by SIMD_ISA are used, scalar otherwise
+
+#if SIMD_ISA >= ISA_AVX512
+# define SEARCH_VECTOR_TYPE __m512i
+#elif SIMD_ISA >= ISA_AVX2
+# define SEARCH_VECTOR_TYPE __m256i
+#endif
+
+//returns the index of the first element for which comp(data[i], elem) is true, -1 if there is none
+template <typename T, typename Comparator>
+HOT ssize_t forward_lower_bound(std::span<const T> data, const T elem, const Comparator &comp) noexcept
+{
+  static_assert(std::is_integral<T>::value, "T must be an integral type");
+
+  const T *begin = data.data();
+  const T *end = begin + data.size();
+  const T *it = begin;
+
+  PREFETCH_R(it, 0);
+
+#ifdef SEARCH_VECTOR_TYPE
+  using VectorType = SEARCH_VECTOR_TYPE;
+  static constexpr uint8_t UNROLL_FACTOR = 4;
+  static constexpr ptrdiff_t chunk_size = sizeof(VectorType) / sizeof(T);
+  static constexpr ptrdiff_t combined_chunks_size = UNROLL_FACTOR * chunk_size;
+
+  const VectorType elem_vec = simd::create_vector<VectorType, T>(elem);
+  constexpr int opcode = simd::get_opcode<T, Comparator>();
+  std::array<__mmask64, UNROLL_FACTOR> masks;
+
+  //scalar up to the first vector boundary, misalignment is in bytes
+  const ptrdiff_t misalignment = simd::misalignment_forwards(it, sizeof(VectorType)) / sizeof(T);
+  const T *aligned = begin + std::min(misalignment, end - begin);
+
+  for (; it < aligned; ++it)
+    if (comp(*it, elem)) [[unlikely]]
+      return it - begin;
+
+  while (end - it >= combined_chunks_size)
+  {
+    it = std::assume_aligned<sizeof(VectorType)>(it);
+    PREFETCH_R(it + 2 * combined_chunks_size, 0);
+
+    __mmask64 found = 0;
+    #pragma GCC unroll UNROLL_FACTOR
+    for (uint8_t i = 0; i < UNROLL_FACTOR; ++i)
+    {
+      masks[i] = simd::compare<VectorType, T>(simd::load<VectorType>(it + i * chunk_size), elem_vec, opcode);
+      found |= masks[i];
+    }
+
+    if (found) [[unlikely]]
+    {
+      uint8_t i = 0;
+      while (masks[i] == 0)
+        ++i;
+      return it - begin + i * chunk_size + __builtin_ctzll(masks[i]);
+    }
+
+    it += combined_chunks_size;
+  }
+
+  while (end - it >= chunk_size)
+  {
+    const __mmask64 mask = simd::compare<VectorType, T>(simd::load<VectorType>(it), elem_vec, opcode);
+    if (mask) [[unlikely]]
+      return it - begin + __builtin_ctzll(mask);
+
+    it += chunk_size;
+  }
+#endif
+
+  for (; it < end; ++it)
+    if (comp(*it, elem)) [[unlikely]]
+      return it - begin;
+
+  return -1;
+}
+
+//returns the index of the last element for which comp(data[i], elem) is true, -1 if there is none
+template <typename T, typename Comparator>
+HOT ssize_t backward_lower_bound(std::span<const T> data, const T elem, const Comparator &comp) noexcept
+{
+  static_assert(std::is_integral<T>::value, "T must be an integral type");
+
+  const T *begin = data.data();
+  const T *end = begin + data.size();
+  //one past the next element to look at
+  const T *it = end;
+
+  PREFETCH_R(it - 1, 0);
+
+#ifdef SEARCH_VECTOR_TYPE
+  using VectorType = SEARCH_VECTOR_TYPE;
+  static constexpr uint8_t UNROLL_FACTOR = 4;
+  static constexpr ptrdiff_t chunk_size = sizeof(VectorType) / sizeof(T);
+  static constexpr ptrdiff_t combined_chunks_size = UNROLL_FACTOR * chunk_size;
+
+  const VectorType elem_vec = simd::create_vector<VectorType, T>(elem);
+  constexpr int opcode = simd::get_opcode<T, Comparator>();
+  std::array<__mmask64, UNROLL_FACTOR> masks;
+
+  //scalar down to the last vector boundary, misalignment is in bytes
+  const ptrdiff_t misalignment = simd::misalignment_backwards(it, sizeof(VectorType)) / sizeof(T);
+  const T *aligned = end - std::min(misalignment, end - begin);
+
+  while (it > aligned)
+  {
+    --it;
+    if (comp(*it, elem)) [[unlikely]]
+      return it - begin;
+  }
+
+  //chunk 0 is the highest one
+  while (it - begin >= combined_chunks_size)
+  {
+    it = std::assume_aligned<sizeof(VectorType)>(it - combined_chunks_size);
+    PREFETCH_R(it - combined_chunks_size, 0);
+
+    __mmask64 found = 0;
+    #pragma GCC unroll UNROLL_FACTOR
+    for (uint8_t i = 0; i < UNROLL_FACTOR; ++i)
+    {
+      masks[i] = simd::compare<VectorType, T>(simd::load<VectorType>(it + (UNROLL_FACTOR - 1 - i) * chunk_size), elem_vec, opcode);
+      found |= masks[i];
+    }
+
+    if (found) [[unlikely]]
+    {
+      uint8_t i = 0;
+      while (masks[i] == 0)
+        ++i;
+      return it - begin + (UNROLL_FACTOR - 1 - i) * chunk_size + 63 - __builtin_clzll(masks[i]);
+    }
+  }
+
+  while (it - begin >= chunk_size)
+  {
+    it -= chunk_size;
+    const __mmask64 mask = simd::compare<VectorType, T>(simd::load<VectorType>(it), elem_vec, opcode);
+    if (mask) [[unlikely]]
+      return it - begin + 63 - __builtin_clzll(mask);
+  }
+#endif
+
+  while (it > begin)
+  {
+    --it;
+    if (comp(*it, elem)) [[unlikely]]
+      return it - begin;
+  }
+
+  return -1;
+}
+
+#undef SEARCH_VECTOR_TYPE
@@ -0,0 +1,53 @@
+/*================================================================================
+
+File: isa.hpp                                                                   
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-16 10:41:12                                                 
+last edited: 2025-05-16 10:41:12                                                
+
+================================================================================*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "macros.hpp"
+
+#define ISA_BASELINE  0
+#define ISA_AVX2      1
+#define ISA_AVX512    2
+
+//what the global -march already guarantees
+#if defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512VL__) && defined(__AVX512DQ__)
+# define ISA_NATIVE ISA_AVX512
+#elif defined(__AVX2__) && defined(__BMI2__)
+# define ISA_NATIVE ISA_AVX2
+#else
+# define ISA_NATIVE ISA_BASELINE
+#endif
+
+//g++ does not update the __AVX*__ macros under #pragma GCC target, code compiled for a runtime
+//selected isa checks the SIMD_ISA level defined by its includer instead
+#define PUSH_TARGET_AVX2    _Pragma("GCC push_options") _Pragma("GCC target(\"avx2,bmi,bmi2,lzcnt,popcnt\")")
+#define PUSH_TARGET_AVX512  _Pragma("GCC push_options") _Pragma("GCC target(\"avx512f,avx512bw,avx512vl,avx512dq,avx2,bmi,bmi2,lzcnt,popcnt\")")
+#define POP_TARGET          _Pragma("GCC pop_options")
+
+namespace utils::simd
+{
+  enum Isa : uint8_t
+  {
+    BASELINE = ISA_BASELINE,
+    AVX2 = ISA_AVX2,
+    AVX512 = ISA_AVX512,
+    ISA_COUNT
+  };
+
+  inline Isa detect_isa(void) noexcept;
+
+  //best instruction set of the running cpu, resolved once before main
+  inline const Isa isa = detect_isa();
+}
+
+#include "isa.inl"
@@ -0,0 +1,30 @@
+/*================================================================================
+
+File: isa.inl                                                                   
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-16 10:41:12                                                 
+last edited: 2025-05-16 10:41:12                                                
+
+================================================================================*/
+
+#pragma once
+
+#include "isa.hpp"
+
+COLD inline utils::simd::Isa utils::simd::detect_isa(void) noexcept
+{
+  //static initializers may run before the libgcc one that fills the cpu model
+  __builtin_cpu_init();
+
+  const bool has_avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512dq");
+  const bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2");
+
+  static constexpr Isa levels[2][2] = {
+    { BASELINE, AVX512 },
+    { AVX2, AVX512 }
+  };
+
+  return levels[has_avx2][has_avx512];
+}
@@ -5,31 +5,63 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-04-04 21:21:27                                                 
-last edited: 2025-04-06 11:56:06                                                
+last edited: 2025-06-15 14:02:09                                                
 
 ================================================================================*/
 
 #pragma once
 
 #include <immintrin.h>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
 
+#include "isa.hpp"
 #include "macros.hpp"
 
-namespace utils::simd
+namespace utils
 {
-  template <typename VectorType, typename ScalarType>
-  inline VectorType create_vector(const ScalarType &elem);
+  //the intrinsic vector types carry attributes that g++ drops (and warns about) when they are spelled as
+  //template arguments, so the helpers below dispatch on register width and lane type instead of std::is_same
+  template <typename VectorType>
+  using vector_lane_t = std::remove_cvref_t<decltype(std::declval<VectorType>()[0])>;
 
-  template <typename ScalarType, typename Comparator>
-  inline constexpr int get_opcode(void);
+  template <typename VectorType, size_t Width>
+  inline constexpr bool is_integer_vector_v = (sizeof(VectorType) == Width) && std::is_integral_v<vector_lane_t<VectorType>>;
 
-  template <typename VectorType, typename ScalarType>
-  inline __mmask64 compare(const VectorType &chunk, const VectorType &elem_vec, const int opcode);
+  template <typename VectorType, size_t Width, typename LaneType>
+  inline constexpr bool is_float_vector_v = (sizeof(VectorType) == Width) && std::is_same_v<vector_lane_t<VectorType>, LaneType>;
+}
 
-  inline uint8_t misalignment_forwards(const void *ptr, const uint8_t alignment);
+//create_vector, load, get_opcode, compare and misalignment_forwards/backwards.
+//utils::simd follows the global -march, the utils::<isa>::simd copies are compiled for the
+//instruction sets picked at runtime, so kernels built for one isa only inline helpers of the same isa
 
-  inline uint8_t misalignment_backwards(const void *ptr, const uint8_t alignment);
+#define SIMD_ISA ISA_NATIVE
+namespace utils::simd
+{
+  #include "simd_utils.tpp"
+  #include "simd_utils.inl"
 }
+#undef SIMD_ISA
 
-#include "simd_utils.tpp"
-#include "simd_utils.inl"
\ No newline at end of file
+#define SIMD_ISA ISA_AVX2
+namespace utils::avx2::simd
+{
+  PUSH_TARGET_AVX2
+  #include "simd_utils.tpp"
+  #include "simd_utils.inl"
+  POP_TARGET
+}
+#undef SIMD_ISA
+
+#define SIMD_ISA ISA_AVX512
+namespace utils::avx512::simd
+{
+  PUSH_TARGET_AVX512
+  #include "simd_utils.tpp"
+  #include "simd_utils.inl"
+  POP_TARGET
+}
+#undef SIMD_ISA
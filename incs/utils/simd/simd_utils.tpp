@@ -5,26 +5,20 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-04-04 21:21:27                                                 
-last edited: 2025-04-08 20:09:05                                                
+last edited: 2025-06-15 14:02:09                                                
 
 ================================================================================*/
 
 //TODO add compile time errors
 
-#pragma once
-
-#include <immintrin.h>
-#include <cstdint>
-#include <type_traits>
-
-#include "simd_utils.hpp"
-#include "macros.hpp"
+//no include guard, simd_utils.hpp includes this once per instruction set.
+//the vector paths follow the SIMD_ISA level of the includer
 
 template <typename VectorType, typename ScalarType>
-HOT PURE ALWAYS_INLINE inline VectorType utils::simd::create_vector(const ScalarType &elem)
+HOT PURE ALWAYS_INLINE inline VectorType create_vector(const ScalarType &elem)
 {
-#ifdef __AVX512F__
-  if constexpr (std::is_same_v<VectorType, __m512i>)
+#if SIMD_ISA >= ISA_AVX512
+  if constexpr (is_integer_vector_v<VectorType, 64>)
   {
     if constexpr (sizeof(ScalarType) == sizeof(int8_t))
       return _mm512_set1_epi8(elem);
@@ -35,20 +29,20 @@ HOT PURE ALWAYS_INLINE inline VectorType utils::simd::create_vector(const Scalar
     if constexpr (sizeof(ScalarType) == sizeof(int64_t))
       return _mm512_set1_epi64(elem);
   }
-  if constexpr (std::is_same_v<VectorType, __m512>)
+  if constexpr (is_float_vector_v<VectorType, 64, float>)
   {
     if constexpr (sizeof(ScalarType) == sizeof(float))
       return _mm512_set1_ps(elem);
   }
-  if constexpr (std::is_same_v<VectorType, __m512d>)
+  if constexpr (is_float_vector_v<VectorType, 64, double>)
   {
     if constexpr (sizeof(ScalarType) == sizeof(double))
       return _mm512_set1_pd(elem);
   }
 #endif
 
-#ifdef __AVX__
-  if constexpr (std::is_same_v<VectorType, __m256i>)
+#if SIMD_ISA >= ISA_AVX2
+  if constexpr (is_integer_vector_v<VectorType, 32>)
   {
     if constexpr (sizeof(ScalarType) == sizeof(int8_t))
       return _mm256_set1_epi8(elem);
@@ -59,12 +53,12 @@ HOT PURE ALWAYS_INLINE inline VectorType utils::simd::create_vector(const Scalar
     if constexpr (sizeof(ScalarType) == sizeof(int64_t))
       return _mm256_set1_epi64x(elem);
   }
-  if constexpr (std::is_same_v<VectorType, __m256>)
+  if constexpr (is_float_vector_v<VectorType, 32, float>)
   {
     if constexpr (sizeof(ScalarType) == sizeof(float))
       return _mm256_set1_ps(elem);
   }
-  if constexpr (std::is_same_v<VectorType, __m256d>)
+  if constexpr (is_float_vector_v<VectorType, 32, double>)
   {
     if constexpr (sizeof(ScalarType) == sizeof(double))
       return _mm256_set1_pd(elem);
@@ -72,7 +66,7 @@ HOT PURE ALWAYS_INLINE inline VectorType utils::simd::create_vector(const Scalar
 #endif
 
 #ifdef __SSE2__
-  if constexpr (std::is_same_v<VectorType, __m128i>)
+  if constexpr (is_integer_vector_v<VectorType, 16>)
   {
     if constexpr (sizeof(ScalarType) == sizeof(int8_t))
       return _mm_set1_epi8(elem);
@@ -83,12 +77,12 @@ HOT PURE ALWAYS_INLINE inline VectorType utils::simd::create_vector(const Scalar
     if constexpr (sizeof(ScalarType) == sizeof(int64_t))
       return _mm_set1_epi64x(elem);
   }
-  if constexpr (std::is_same_v<VectorType, __m128>)
+  if constexpr (is_float_vector_v<VectorType, 16, float>)
   {
     if constexpr (sizeof(ScalarType) == sizeof(float))
       return _mm_set1_ps(elem);
   }
-  if constexpr (std::is_same_v<VectorType, __m128d>)
+  if constexpr (is_float_vector_v<VectorType, 16, double>)
   {
     if constexpr (sizeof(ScalarType) == sizeof(double))
       return _mm_set1_pd(elem);
@@ -98,8 +92,29 @@ HOT PURE ALWAYS_INLINE inline VectorType utils::simd::create_vector(const Scalar
   return VectorType{};
 }
 
+template <typename VectorType>
+HOT PURE ALWAYS_INLINE inline VectorType load(const void *ptr)
+{
+#if SIMD_ISA >= ISA_AVX512
+  if constexpr (is_integer_vector_v<VectorType, 64>)
+    return _mm512_load_si512(ptr);
+#endif
+
+#if SIMD_ISA >= ISA_AVX2
+  if constexpr (is_integer_vector_v<VectorType, 32>)
+    return _mm256_load_si256(static_cast<const __m256i *>(ptr));
+#endif
+
+#ifdef __SSE2__
+  if constexpr (is_integer_vector_v<VectorType, 16>)
+    return _mm_load_si128(static_cast<const __m128i *>(ptr));
+#endif
+
+  return VectorType{};
+}
+
 template <typename ScalarType, typename Comparator>
-HOT PURE ALWAYS_INLINE inline constexpr int utils::simd::get_opcode(void)
+HOT PURE ALWAYS_INLINE inline constexpr int get_opcode(void)
 {
   if constexpr (std::is_integral_v<ScalarType>)
   {
@@ -135,11 +150,87 @@ HOT PURE ALWAYS_INLINE inline constexpr int utils::simd::get_opcode(void)
   return -1;
 }
 
+#if SIMD_ISA >= ISA_AVX2
+template <typename ScalarType>
+HOT PURE ALWAYS_INLINE inline __m256i cmpeq_avx2(const __m256i a, const __m256i b)
+{
+  if constexpr (sizeof(ScalarType) == sizeof(int8_t))
+    return _mm256_cmpeq_epi8(a, b);
+  if constexpr (sizeof(ScalarType) == sizeof(int16_t))
+    return _mm256_cmpeq_epi16(a, b);
+  if constexpr (sizeof(ScalarType) == sizeof(int32_t))
+    return _mm256_cmpeq_epi32(a, b);
+  if constexpr (sizeof(ScalarType) == sizeof(int64_t))
+    return _mm256_cmpeq_epi64(a, b);
+}
+
+template <typename ScalarType>
+HOT PURE ALWAYS_INLINE inline __m256i cmpgt_avx2(const __m256i a, const __m256i b)
+{
+  if constexpr (sizeof(ScalarType) == sizeof(int8_t))
+    return _mm256_cmpgt_epi8(a, b);
+  if constexpr (sizeof(ScalarType) == sizeof(int16_t))
+    return _mm256_cmpgt_epi16(a, b);
+  if constexpr (sizeof(ScalarType) == sizeof(int32_t))
+    return _mm256_cmpgt_epi32(a, b);
+  if constexpr (sizeof(ScalarType) == sizeof(int64_t))
+    return _mm256_cmpgt_epi64(a, b);
+}
+
+//one bit per element, like the avx512 mask registers
+template <typename ScalarType>
+HOT PURE ALWAYS_INLINE inline __mmask64 movemask_avx2(const __m256i vec)
+{
+  if constexpr (sizeof(ScalarType) == sizeof(int8_t))
+    return static_cast<uint32_t>(_mm256_movemask_epi8(vec));
+  if constexpr (sizeof(ScalarType) == sizeof(int16_t))
+    return _pext_u32(_mm256_movemask_epi8(vec), 0xAAAAAAAA);
+  if constexpr (sizeof(ScalarType) == sizeof(int32_t))
+    return _mm256_movemask_ps(_mm256_castsi256_ps(vec));
+  if constexpr (sizeof(ScalarType) == sizeof(int64_t))
+    return _mm256_movemask_pd(_mm256_castsi256_pd(vec));
+}
+
+//avx2 only has signed == and >, every other predicate is derived from those.
+//unsigned elements are moved into the signed range by flipping their top bit
+template <typename ScalarType>
+HOT PURE ALWAYS_INLINE inline __mmask64 compare_avx2(__m256i chunk, __m256i elem_vec, const int opcode)
+{
+  static constexpr __mmask64 lanes_mask = (1ull << (sizeof(__m256i) / sizeof(ScalarType))) - 1;
+
+  if constexpr (std::is_unsigned_v<ScalarType>)
+  {
+    static constexpr ScalarType top_bit = static_cast<ScalarType>(ScalarType{1} << (sizeof(ScalarType) * 8 - 1));
+    const __m256i bias = create_vector<__m256i, ScalarType>(top_bit);
+    chunk = _mm256_xor_si256(chunk, bias);
+    elem_vec = _mm256_xor_si256(elem_vec, bias);
+  }
+
+  switch (opcode)
+  {
+    case _MM_CMPINT_EQ:
+      return movemask_avx2<ScalarType>(cmpeq_avx2<ScalarType>(chunk, elem_vec));
+    case _MM_CMPINT_NE:
+      return ~movemask_avx2<ScalarType>(cmpeq_avx2<ScalarType>(chunk, elem_vec)) & lanes_mask;
+    case _MM_CMPINT_LT:
+      return movemask_avx2<ScalarType>(cmpgt_avx2<ScalarType>(elem_vec, chunk));
+    case _MM_CMPINT_LE:
+      return ~movemask_avx2<ScalarType>(cmpgt_avx2<ScalarType>(chunk, elem_vec)) & lanes_mask;
+    case _MM_CMPINT_GT:
+      return movemask_avx2<ScalarType>(cmpgt_avx2<ScalarType>(chunk, elem_vec));
+    case _MM_CMPINT_GE:
+      return ~movemask_avx2<ScalarType>(cmpgt_avx2<ScalarType>(elem_vec, chunk)) & lanes_mask;
+    default:
+      return 0;
+  }
+}
+#endif
+
 template <typename VectorType, typename ScalarType>
-HOT PURE ALWAYS_INLINE inline __mmask64 utils::simd::compare(const VectorType &chunk, const VectorType &elem_vec, const int opcode)
+HOT PURE ALWAYS_INLINE inline __mmask64 compare(const VectorType &chunk, const VectorType &elem_vec, const int opcode)
 {
-#ifdef __AVX512F__
-  if constexpr (std::is_same<VectorType, __m512i>::value)
+#if SIMD_ISA >= ISA_AVX512
+  if constexpr (is_integer_vector_v<VectorType, 64>)
   {
     if constexpr (std::is_integral_v<ScalarType>)
     {
@@ -176,8 +267,8 @@ HOT PURE ALWAYS_INLINE inline __mmask64 utils::simd::compare(const VectorType &c
   }
 #endif
 
-#ifdef __AVX__
-  if constexpr (std::is_same<VectorType, __m256i>::value)
+#if SIMD_ISA >= ISA_AVX512
+  if constexpr (is_integer_vector_v<VectorType, 32>)
   {
     if constexpr (std::is_integral_v<ScalarType>)
     {
@@ -212,10 +303,16 @@ HOT PURE ALWAYS_INLINE inline __mmask64 utils::simd::compare(const VectorType &c
         return _mm256_cmp_pd_mask(chunk, elem_vec, opcode);
     }
   }
+#elif SIMD_ISA >= ISA_AVX2
+  if constexpr (is_integer_vector_v<VectorType, 32>)
+  {
+    static_assert(std::is_integral_v<ScalarType>, "avx2 compares are integral only");
+    return compare_avx2<ScalarType>(chunk, elem_vec, opcode);
+  }
 #endif
 
-#ifdef __SSE2__
-  if constexpr (std::is_same<VectorType, __m128i>::value)
+#if SIMD_ISA >= ISA_AVX512
+  if constexpr (is_integer_vector_v<VectorType, 16>)
   {
     if constexpr (std::is_integral_v<ScalarType>)
     {
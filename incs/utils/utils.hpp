@@ -5,7 +5,7 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-04-03 20:16:29                                                 
-last edited: 2025-04-17 16:57:31                                                
+last edited: 2025-06-21 09:58:20                                                
 
 ================================================================================*/
 
@@ -23,6 +23,17 @@ namespace utils
 
   template <typename T, typename Comparator>
   ssize_t backward_lower_bound(std::span<const T> data, const T elem, const Comparator &comp) noexcept;
+
+  template <typename T, typename Comparator>
+  size_t binary_lower_bound(std::span<const T> data, const T elem, const Comparator &comp) noexcept;
+
+  template <typename T>
+  void reverse_copy(std::span<const T> src, T *restrict dst) noexcept;
+
+  template <typename T>
+  T sum(std::span<const T> data) noexcept;
+
+  uint64_t backward_sweep(std::span<const int32_t> prices, std::span<const uint64_t> qtys, const uint64_t qty, double &notional) noexcept;
 }
 
 #include "utils.tpp"
\ No newline at end of file
@@ -5,7 +5,7 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-04-03 20:16:29                                                 
-last edited: 2025-04-24 13:13:44                                                
+last edited: 2025-06-21 09:58:20                                                
 
 ================================================================================*/
 
@@ -15,229 +15,135 @@ last edited: 2025-04-24 13:13:44
 #include <span>
 #include <ranges>
 #include <array>
+#include <memory>
+#include <new>
 #include <immintrin.h>
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
 
 #include "utils.hpp"
 #include "macros.hpp"
 
-namespace utils
+//the linear search and depth kernels, once per instruction set
+#define SIMD_ISA ISA_NATIVE
+namespace utils::baseline
 {
+  #include "search.tpp"
+  #include "depth.tpp"
+}
+#undef SIMD_ISA
 
-template <typename T, typename Comparator>
-HOT ssize_t forward_lower_bound(std::span<const T> data, const T elem, const Comparator &comp) noexcept
+#define SIMD_ISA ISA_AVX2
+namespace utils::avx2
 {
-  static_assert(std::is_integral<T>::value, "T must be an integral type");
-  static_assert(std::hardware_constructive_interference_size == 64, "Cache line size must be 64 bytes");
-
-  static constexpr uint8_t chunk_size = sizeof(__m512i) / sizeof(T);
-  const T *begin = data.data();
-  const size_t size = data.size();
-  size_t remaining = size;
-  const T *it = begin;
-  bool keep_looking;
-  bool found = false;
-
-  PREFETCH_R(it, 0);
-  const bool safe = (remaining >= chunk_size);
-  PREFETCH_R(it + chunk_size * safe, 0);
-
-  uint8_t misalignment = utils::simd::misalignment_forwards(it, 64);
-  misalignment = (misalignment > remaining) ? remaining : misalignment;
-
-  keep_looking = (misalignment > 0);
-
-  while (keep_looking)
-  {
-    found = comp(*it, elem);
-
-    --misalignment;
-    --remaining;
-
-    keep_looking = (misalignment > 0);
-    keep_looking &= !found;
-
-    it += keep_looking;
-  }
-
-#ifdef __AVX512F__
-  static constexpr uint8_t UNROLL_FACTOR = 8;
-  static constexpr uint16_t combined_chunks_size = UNROLL_FACTOR * chunk_size;
-
-  const __m512i elem_vec = utils::simd::create_vector<__m512i, T>(elem);
-  constexpr int opcode = utils::simd::get_opcode<T, Comparator>();
-  std::array<__m512i, UNROLL_FACTOR> chunks;
-  std::array<__mmask64, UNROLL_FACTOR> masks;
-
-  keep_looking = (remaining >= combined_chunks_size);
-  keep_looking &= !found;
-
-  while (keep_looking)
-  {
-    it = std::assume_aligned<64>(it);
-
-    #pragma GCC unroll UNROLL_FACTOR
-    for (uint8_t i = 0; i < UNROLL_FACTOR; ++i)
-      chunks[i] = _mm512_load_si512(it + i * chunk_size);
-
-    it += combined_chunks_size;
-    remaining -= combined_chunks_size;
-    keep_looking = (remaining >= combined_chunks_size);
-
-    const uint8_t safe_chunk_size = chunk_size * keep_looking; 
-    #pragma GCC unroll UNROLL_FACTOR
-    for (uint8_t i = 0; i < UNROLL_FACTOR; ++i)
-      PREFETCH_R(it + i * safe_chunk_size, 0);
-
-    #pragma GCC unroll UNROLL_FACTOR
-    for (uint8_t i = 0; i < UNROLL_FACTOR; ++i)
-      masks[i] = utils::simd::compare<__m512i, T>(chunks[i], elem_vec, opcode);
-
-    #pragma GCC unroll UNROLL_FACTOR
-    for (uint8_t i = 0; i < UNROLL_FACTOR; ++i)
-      found |= masks[i];
-
-    keep_looking &= !found;
-  }
+  PUSH_TARGET_AVX2
+  #include "search.tpp"
+  #include "depth.tpp"
+  POP_TARGET
+}
+#undef SIMD_ISA
 
-  if (found) [[likely]]
-  {
-    uint8_t i = UNROLL_FACTOR;
-    for (const auto &mask : masks)
-    {
-      i++;
-      if (mask) [[likely]]
-      {
-        const uint8_t bit = __builtin_ctzll(mask);
-        const uint16_t matched_idx = i * chunk_size + bit;
-        return it - begin - combined_chunks_size + matched_idx;
-      }
-    }
-  }
-#endif
+#define SIMD_ISA ISA_AVX512
+namespace utils::avx512
+{
+  PUSH_TARGET_AVX512
+  #include "search.tpp"
+  #include "depth.tpp"
+  POP_TARGET
+}
+#undef SIMD_ISA
 
-  keep_looking = (remaining > 0);
-  keep_looking &= !found;
+namespace utils
+{
 
-  while (keep_looking)
-  {
-    found = comp(*it, elem);
+//returns the index of the first element for which comp(data[i], elem) is true, -1 if there is none
+template <typename T, typename Comparator>
+HOT ALWAYS_INLINE inline ssize_t forward_lower_bound(std::span<const T> data, const T elem, const Comparator &comp) noexcept
+{
+  using Kernel = ssize_t (*)(std::span<const T>, const T, const Comparator &) noexcept;
+  static constexpr std::array<Kernel, simd::ISA_COUNT> kernels = {
+    &baseline::forward_lower_bound<T, Comparator>,
+    &avx2::forward_lower_bound<T, Comparator>,
+    &avx512::forward_lower_bound<T, Comparator>
+  };
+
+  return kernels[simd::isa](data, elem, comp);
+}
 
-    --remaining;
+//returns the index of the last element for which comp(data[i], elem) is true, -1 if there is none
+template <typename T, typename Comparator>
+HOT ALWAYS_INLINE inline ssize_t backward_lower_bound(std::span<const T> data, const T elem, const Comparator &comp) noexcept
+{
+  using Kernel = ssize_t (*)(std::span<const T>, const T, const Comparator &) noexcept;
+  static constexpr std::array<Kernel, simd::ISA_COUNT> kernels = {
+    &baseline::backward_lower_bound<T, Comparator>,
+    &avx2::backward_lower_bound<T, Comparator>,
+    &avx512::backward_lower_bound<T, Comparator>
+  };
+
+  return kernels[simd::isa](data, elem, comp);
+}
 
-    keep_looking = (remaining > 0);
-    keep_looking &= !found;
+//dst[i] = src[src.size() - 1 - i]
+template <typename T>
+HOT ALWAYS_INLINE inline void reverse_copy(std::span<const T> src, T *restrict dst) noexcept
+{
+  using Kernel = void (*)(std::span<const T>, T *restrict) noexcept;
+  static constexpr std::array<Kernel, simd::ISA_COUNT> kernels = {
+    &baseline::reverse_copy<T>,
+    &avx2::reverse_copy<T>,
+    &avx512::reverse_copy<T>
+  };
+
+  kernels[simd::isa](src, dst);
+}
 
-    it += keep_looking;
-  }
+template <typename T>
+HOT ALWAYS_INLINE inline T sum(std::span<const T> data) noexcept
+{
+  using Kernel = T (*)(std::span<const T>) noexcept;
+  static constexpr std::array<Kernel, simd::ISA_COUNT> kernels = {
+    &baseline::sum<T>,
+    &avx2::sum<T>,
+    &avx512::sum<T>
+  };
+
+  return kernels[simd::isa](data);
+}
 
-  return found ? it - begin : -1;
+//takes qty from the end of the levels backwards, returns the qty found and sets the notional paid for it
+HOT ALWAYS_INLINE inline uint64_t backward_sweep(std::span<const int32_t> prices, std::span<const uint64_t> qtys, const uint64_t qty, double &notional) noexcept
+{
+  using Kernel = uint64_t (*)(std::span<const int32_t>, std::span<const uint64_t>, const uint64_t, double &) noexcept;
+  static constexpr std::array<Kernel, simd::ISA_COUNT> kernels = {
+    &baseline::backward_sweep,
+    &avx2::backward_sweep,
+    &avx512::backward_sweep
+  };
+
+  return kernels[simd::isa](prices, qtys, qty, notional);
 }
 
+//data must be sorted according to comp. returns the first index for which comp(data[i], elem) is false
 template <typename T, typename Comparator>
-HOT ssize_t backward_lower_bound(std::span<const T> data, const T elem, const Comparator &comp) noexcept
+HOT size_t binary_lower_bound(std::span<const T> data, const T elem, const Comparator &comp) noexcept
 {
-  static_assert(std::is_integral<T>::value, "T must be an integral type");
-  static_assert(std::hardware_constructive_interference_size == 64, "Cache line size must be 64 bytes");
-
-  static constexpr uint8_t chunk_size = sizeof(__m512i) / sizeof(T);
   const T *begin = data.data();
-  size_t remaining = data.size();
-  const T *it = begin + remaining - 1;
-  bool keep_looking;
-  bool found = false;
-
-  PREFETCH_R(it, 0);
-  const bool safe = (remaining >= chunk_size);
-  PREFETCH_R(it - chunk_size * safe, 0);
-
-  uint8_t misalignment = utils::simd::misalignment_backwards(it, 64);
-  misalignment = (misalignment > remaining) ? remaining : misalignment;
-
-  keep_looking = (misalignment > 0);
-
-  while (keep_looking)
-  {
-    found = comp(*it, elem);
-
-    --misalignment;
-    --remaining;
-
-    keep_looking = (misalignment > 0);
-    keep_looking &= !found;
-
-    it -= keep_looking;
-  }
-
-#ifdef __AVX512F__
-  static constexpr uint8_t UNROLL_FACTOR = 8;
-  static constexpr uint16_t combined_chunks_size = UNROLL_FACTOR * chunk_size;
-
-  const __m512i elem_vec = utils::simd::create_vector<__m512i, T>(elem);
-  constexpr int opcode = utils::simd::get_opcode<T, Comparator>();
-  std::array<__m512i, UNROLL_FACTOR> chunks;
-  std::array<__mmask64, UNROLL_FACTOR> masks;
-
-  keep_looking = (remaining >= combined_chunks_size);
-  keep_looking &= !found;
-
-  while (keep_looking)
-  {
-    #pragma GCC unroll UNROLL_FACTOR
-    for (uint8_t i = 0; i < UNROLL_FACTOR; ++i)
-      chunks[i] = _mm512_load_si512(it - i * chunk_size);
-
-    it -= combined_chunks_size;
-    remaining -= combined_chunks_size;
-    keep_looking = (remaining >= combined_chunks_size);
-
-    const uint8_t safe_chunk_size = chunk_size * keep_looking;
-    #pragma GCC unroll UNROLL_FACTOR
-    for (uint8_t i = 0; i < UNROLL_FACTOR; ++i)
-      PREFETCH_R(it - i * safe_chunk_size, 0);
-
-    #pragma GCC unroll UNROLL_FACTOR
-    for (uint8_t i = 0; i < UNROLL_FACTOR; ++i)
-      masks[i] = utils::simd::compare<__m512i, T>(chunks[i], elem_vec, opcode);
+  const T *base = begin;
+  size_t length = data.size();
 
-    #pragma GCC unroll UNROLL_FACTOR
-    for (uint8_t i = 0; i < UNROLL_FACTOR; ++i)
-      found |= masks[i];
+  if (length == 0) [[unlikely]]
+    return 0;
 
-    keep_looking &= !found;
-  }
-
-  if (found) [[likely]]
+  while (length > 1)
   {
-    uint8_t i = UNROLL_FACTOR;
-    for (const auto &mask : masks | std::views::reverse)
-    {
-      i--;
-      if (mask) [[likely]]
-      {
-        const uint8_t bit = 63 - __builtin_ctzll(mask);
-        const uint16_t matched_idx = i * chunk_size + bit;
-        return it - begin + matched_idx;
-      }
-    }
-  }
-#endif
-
-  keep_looking = (remaining > 0);
-  keep_looking &= !found;
-
-  while (keep_looking)
-  {
-    found = comp(*it, elem);
-
-    --remaining;
-
-    keep_looking = (remaining > 0);
-    keep_looking &= !found;
-
-    it -= keep_looking;
+    const size_t half = length / 2;
+    base += comp(base[half], elem) * half;
+    length -= half;
   }
 
-  return found ? it - begin : -1;
+  return base - begin + comp(*base, elem);
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,118 @@
+/*================================================================================
+
+File: BookIndex.cpp                                                             
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-17 09:12:26                                                 
+last edited: 2025-05-17 09:12:26                                                
+
+================================================================================*/
+
+#include <algorithm>
+#include <bit>
+
+#include "BookIndex.hpp"
+#include "macros.hpp"
+
+static constexpr uint8_t MAX_BUILD_ATTEMPTS = 32;
+
+COLD BookIndex::BookIndex(void) noexcept :
+  buckets(2),
+  slots(2),
+  multiplier(0x9E3779B97F4A7C15),
+  shift(63),
+  size(0)
+{
+  for (Slots &bucket_slots : slots)
+    std::fill_n(bucket_slots.books, BUCKET_SIZE, NO_BOOK);
+}
+
+COLD BookIndex::~BookIndex()
+{
+}
+
+COLD void BookIndex::insert(const uint32_t id)
+{
+  if (id == 0 || contains(id))
+    return;
+
+  std::vector<uint32_t> ids;
+  std::vector<uint32_t> books;
+  ids.reserve(size + 1);
+  books.reserve(size + 1);
+
+  for (size_t bucket_idx = 0; bucket_idx < buckets.size(); ++bucket_idx)
+  {
+    for (uint8_t i = 0; i < BUCKET_SIZE; ++i)
+    {
+      if (buckets[bucket_idx].ids[i] == 0)
+        continue;
+
+      ids.push_back(buckets[bucket_idx].ids[i]);
+      books.push_back(slots[bucket_idx].books[i]);
+    }
+  }
+
+  ids.push_back(id);
+  books.push_back(NO_BOOK);
+  rebuild(ids, books);
+}
+
+COLD void BookIndex::rebuild(std::vector<uint32_t> &ids, std::vector<uint32_t> &books)
+{
+  //at most half full on average, the multiplier search takes care of the unlucky buckets
+  size_t buckets_count = std::bit_ceil((ids.size() * 2 + BUCKET_SIZE - 1) / BUCKET_SIZE);
+  buckets_count = std::max<size_t>(buckets_count, 2);
+
+  uint64_t seed = 0x9E3779B97F4A7C15;
+
+  while (true)
+  {
+    buckets.assign(buckets_count, Bucket{});
+    slots.assign(buckets_count, Slots{});
+    shift = 64 - std::countr_zero(buckets_count);
+
+    for (uint8_t attempt = 0; attempt < MAX_BUILD_ATTEMPTS; ++attempt)
+    {
+      //splitmix64, forced odd
+      seed += 0x9E3779B97F4A7C15;
+      uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+      multiplier = (z ^ (z >> 31)) | 1;
+
+      if (tryBuild(ids, books))
+      {
+        size = ids.size();
+        return;
+      }
+    }
+
+    buckets_count *= 2;
+  }
+}
+
+COLD bool BookIndex::tryBuild(const std::vector<uint32_t> &ids, const std::vector<uint32_t> &books)
+{
+  std::vector<uint8_t> fill(buckets.size(), 0);
+
+  std::fill(buckets.begin(), buckets.end(), Bucket{});
+  for (Slots &bucket_slots : slots)
+    std::fill_n(bucket_slots.books, BUCKET_SIZE, NO_BOOK);
+
+  for (size_t i = 0; i < ids.size(); ++i)
+  {
+    const size_t bucket_idx = getBucket(ids[i]);
+    uint8_t &position = fill[bucket_idx];
+
+    if (position == BUCKET_SIZE)
+      return false;
+
+    buckets[bucket_idx].ids[position] = ids[i];
+    slots[bucket_idx].books[position] = books[i];
+    position++;
+  }
+
+  return true;
+}
@@ -0,0 +1,84 @@
+/*================================================================================
+
+File: BookPublisher.cpp                                                         
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-19 10:27:14                                                 
+last edited: 2025-06-19 10:27:14                                                
+
+================================================================================*/
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <new>
+
+#include "BookPublisher.hpp"
+#include "macros.hpp"
+#include "error.hpp"
+
+//an empty name disables publishing
+COLD BookPublisher::BookPublisher(const std::string &name, const uint32_t slots_count) :
+  name(name),
+  slots_count(slots_count),
+  mapping(nullptr),
+  books_count(0)
+{
+  if (name.empty())
+    return;
+
+  const size_t size = getSize(slots_count);
+
+  //a segment left by an earlier run is emptied first
+  const int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+  error |= fd == -1;
+  CHECK_ERROR;
+
+  error |= ftruncate(fd, size) == -1;
+  void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  error |= memory == MAP_FAILED;
+  close(fd);
+  CHECK_ERROR;
+
+  mapping = static_cast<char *>(memory);
+
+  Header &header = *new (mapping) Header{};
+  header.version = VERSION;
+  header.slots_count = slots_count;
+  header.depth = BOOK_PUBLISH_DEPTH;
+
+  //readers only trust a segment with its magic, written last
+  __atomic_store_n(&header.magic, MAGIC, __ATOMIC_RELEASE);
+}
+
+COLD BookPublisher::~BookPublisher()
+{
+  if (mapping == nullptr)
+    return;
+
+  munmap(mapping, getSize(slots_count));
+  shm_unlink(name.c_str());
+}
+
+//called by the thread owning the book, slots are handed out in order across threads
+COLD BookPublisher::Slot *BookPublisher::claimSlot(const uint32_t orderbook_id)
+{
+  const uint32_t idx = books_count.fetch_add(1, std::memory_order_relaxed);
+
+  if (idx >= slots_count) [[unlikely]]
+  {
+    std::fprintf(stderr, "book %u has no slot to be published in, %u slots\n", orderbook_id, slots_count);
+    panic();
+  }
+
+  Slot *slot = new (mapping + sizeof(Header) + idx * sizeof(Slot)) Slot{};
+  slot->snapshot.orderbook_id = orderbook_id;
+
+  //the slot is empty until its book is first published, the count only tells readers how far to look
+  Header &header = *reinterpret_cast<Header *>(mapping);
+  __atomic_fetch_add(&header.books_count, 1, __ATOMIC_RELEASE);
+
+  return slot;
+}
@@ -0,0 +1,205 @@
+/*================================================================================
+
+File: Checkpointer.cpp                                                          
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-03 09:27:51                                                 
+last edited: 2025-06-16 09:48:15                                                
+
+================================================================================*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Checkpointer.hpp"
+#include "error.hpp"
+#include "macros.hpp"
+
+static constexpr char CHECKPOINT_MAGIC[8] = { 'O', 'B', 'C', 'K', 'P', 'T', '\0', '\0' };
+
+COLD Checkpointer::Checkpointer(const std::string &path, const uint32_t interval_s) :
+  path(path),
+  interval_s(interval_s),
+  staging(),
+  state(IDLE),
+  failures(0),
+  serialize_ns(0),
+  mutex(),
+  condition(),
+  mapping(nullptr),
+  mapping_size(0),
+  thread()
+{
+  if (path.empty() || interval_s == 0)
+    return;
+
+  thread = std::jthread([this](std::stop_token stop) { run(stop); });
+}
+
+COLD Checkpointer::~Checkpointer()
+{
+  thread.request_stop();
+  if (thread.joinable())
+    thread.join();
+  close();
+}
+
+//called by the processing thread between packets once isDue()
+COLD void Checkpointer::capture(const MessageHandler &handler, const uint64_t sequence_number, const char *session)
+{
+  if (state.load(std::memory_order_acquire) != DUE)
+    return;
+
+  serialize(handler, sequence_number, session);
+
+  {
+    std::lock_guard lock(mutex);
+    state.store(CAPTURED, std::memory_order_release);
+  }
+  condition.notify_one();
+}
+
+COLD void Checkpointer::save(const MessageHandler &handler, const uint64_t sequence_number, const char *session)
+{
+  serialize(handler, sequence_number, session);
+  failures.fetch_add(!writeFile(), std::memory_order_relaxed);
+}
+
+COLD void Checkpointer::serialize(const MessageHandler &handler, const uint64_t sequence_number, const char *session)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  //the staging buffer keeps its capacity, only the first checkpoint faults its pages in
+  staging.clear();
+  staging.resize(sizeof(CheckpointHeader));
+
+  CheckpointWriter writer(staging);
+  handler.saveCheckpoint(writer);
+
+  CheckpointHeader &header = *reinterpret_cast<CheckpointHeader *>(staging.data());
+  std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+  header.version = CHECKPOINT_VERSION;
+  header.book_kind = MessageHandler::getBookKind();
+  header.size = staging.size();
+  header.sequence_number = sequence_number;
+  std::memcpy(header.session, session, sizeof(header.session));
+
+  const auto end = std::chrono::steady_clock::now();
+  serialize_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(), std::memory_order_relaxed);
+}
+
+//a failed write keeps the previous checkpoint, it is not worth stopping the feed for
+COLD bool Checkpointer::writeFile(void) const
+{
+  const std::string tmp_path = path + ".tmp";
+
+  const int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1)
+    return false;
+
+  size_t written = 0;
+  while (written < staging.size())
+  {
+    const ssize_t size = ::write(fd, staging.data() + written, staging.size() - written);
+    if (size <= 0)
+      break;
+    written += size;
+  }
+
+  const bool ok = (written == staging.size()) && (fsync(fd) == 0);
+  ::close(fd);
+
+  if (!ok || std::rename(tmp_path.c_str(), path.c_str()) != 0)
+  {
+    unlink(tmp_path.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+COLD void Checkpointer::run(std::stop_token stop)
+{
+  std::unique_lock lock(mutex);
+
+  while (!stop.stop_requested())
+  {
+    condition.wait_for(lock, stop, std::chrono::seconds(interval_s), [] { return false; });
+    if (stop.stop_requested())
+      break;
+
+    state.store(DUE, std::memory_order_release);
+    condition.wait(lock, stop, [this] { return state.load(std::memory_order_acquire) == CAPTURED; });
+    if (stop.stop_requested())
+      break;
+
+    lock.unlock();
+    failures.fetch_add(!writeFile(), std::memory_order_relaxed);
+    lock.lock();
+
+    state.store(IDLE, std::memory_order_release);
+  }
+}
+
+//maps the checkpoint, nullptr when there is none or it was written by another build
+COLD const CheckpointHeader *Checkpointer::open(void)
+{
+  close();
+
+  if (path.empty())
+    return nullptr;
+
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+    return nullptr;
+
+  struct stat st{};
+  const bool has_header = (fstat(fd, &st) == 0) && (static_cast<size_t>(st.st_size) >= sizeof(CheckpointHeader));
+
+  void *data = has_header ? mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0) : MAP_FAILED;
+  ::close(fd);
+
+  if (data == MAP_FAILED)
+    return nullptr;
+
+  mapping = static_cast<const char *>(data);
+  mapping_size = st.st_size;
+
+  const CheckpointHeader &header = *reinterpret_cast<const CheckpointHeader *>(mapping);
+  const bool valid = std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) == 0
+    && header.version == CHECKPOINT_VERSION
+    && header.book_kind == MessageHandler::getBookKind()
+    && header.size == mapping_size;
+
+  if (!valid)
+  {
+    close();
+    return nullptr;
+  }
+
+  return &header;
+}
+
+COLD void Checkpointer::restore(MessageHandler &handler) const
+{
+  CheckpointReader reader(mapping, mapping_size);
+
+  CheckpointHeader header;
+  reader.read(header);
+  handler.loadCheckpoint(reader);
+}
+
+COLD void Checkpointer::close(void) noexcept
+{
+  if (mapping != nullptr)
+    munmap(const_cast<char *>(mapping), mapping_size);
+
+  mapping = nullptr;
+  mapping_size = 0;
+}
@@ -5,13 +5,17 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-03-08 15:48:16                                                 
-last edited: 2025-05-03 19:03:11                                                
+last edited: 2025-06-26 11:07:42                                                
 
 ================================================================================*/
 
 #include <arpa/inet.h>
 #include <netinet/tcp.h>
+#include <poll.h>
+#include <algorithm>
 #include <array>
+#include <cerrno>
+#include <cstdio>
 #include <endian.h>
 #include <unistd.h>
 #include <cstring>
@@ -20,11 +24,16 @@ last edited: 2025-05-03 19:03:11
 
 #include "Client.hpp"
 #include "Config.hpp"
+#include "MessageDecoder.hpp"
 #include "utils/utils.hpp"
 #include "macros.hpp"
 #include "error.hpp"
 
 COLD Client::Client(const Config &config) noexcept :
+  counters(config.counters_name, config.workers_count + 1),
+  publisher(config.books_name, config.book_ids.size()),
+  workers(config, counters, publisher),
+  dispatcher_core(config.dispatcher_core),
   username(config.username),
   password(config.password),
   glimpse_address(createAddress(config.glimpse_ip, config.glimpse_port)),
@@ -34,11 +43,37 @@ COLD Client::Client(const Config &config) noexcept :
   bind_address_udp(createAddress(config.bind_ip, config.multicast_port)),
   tcp_sock_fd(createTcpSocket()),
   udp_sock_fd(createUdpSocket()),
+  feed_backend(config.feed_backend),
+  batch_bursts(config.batch_bursts && config.workers_count == 0 && !config.latency_stats),
+  packet_ring(config.feed_interface, multicast_address),
+  uring(config.feed_backend == FeedBackend::IO_URING_SQPOLL),
+  feed_msg(),
+  recovery(rewind_address, bind_address_tcp, udp_sock_fd),
+  live_queue(),
+  snapshot_reader(),
+  latency(config.latency_stats),
+  packet_stamps(),
+  checkpointer(config.checkpoint_path, config.checkpoint_interval_s),
   sequence_number(0),
   status(CONNECTING)
 {
-  for (const auto &id : config.book_ids)
-    message_handler.addBookId(id);
+  //the worker books live on the worker stacks and are not consistent with the dispatcher sequence number
+  if (!config.checkpoint_path.empty() && config.workers_count != 0) [[unlikely]]
+  {
+    std::fprintf(stderr, "checkpoints are not supported with book workers, clear checkpoint_path or set workers_count to 0\n");
+    panic();
+  }
+
+  message_handler.setCounters(counters.getSlot(0));
+  if (publisher.isEnabled())
+    message_handler.setPublisher(publisher);
+
+  if (config.workers_count == 0)
+    for (const auto &id : config.book_ids)
+      message_handler.addBookId(id);
+
+  if (batch_bursts)
+    message_handler.enableBursts();
 
   error |= bind(tcp_sock_fd, reinterpret_cast<const sockaddr *>(&bind_address_tcp), sizeof(bind_address_tcp)) == -1;
   error |= bind(udp_sock_fd, reinterpret_cast<const sockaddr *>(&bind_address_udp), sizeof(bind_address_udp)) == -1;
@@ -48,6 +83,15 @@ COLD Client::Client(const Config &config) noexcept :
   mreq.imr_multiaddr.s_addr = multicast_address.sin_addr.s_addr;
 
   error |= setsockopt(udp_sock_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) == -1;
+
+  //the io_uring receives get the timestamp in the control area of their buffers
+  if (latency.isEnabled())
+  {
+    constexpr int enable = 1;
+    error |= setsockopt(udp_sock_fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) == -1;
+    feed_msg.msg_controllen = CMSG_SPACE(sizeof(timespec));
+  }
+
   error |= connect(tcp_sock_fd, reinterpret_cast<const sockaddr *>(&glimpse_address), sizeof(glimpse_address)) == -1;
 
   CHECK_ERROR;
@@ -122,89 +166,452 @@ COLD Client::~Client() noexcept
 
 COLD void Client::run(void)
 {
-  fetchOrderbooks();
-  syncSequences();
-  updateOrderbooks();
+  const bool uring_backend = (feed_backend == FeedBackend::IO_URING) || (feed_backend == FeedBackend::IO_URING_SQPOLL);
+
+  Workers::pinThread(dispatcher_core);
+
+  if (!restoreCheckpoint())
+  {
+    if (uring_backend)
+      fetchOrderbooksUring();
+    else
+      fetchOrderbooks();
+  }
+
+  switch (feed_backend)
+  {
+    case FeedBackend::RECVMMSG:
+      return updateOrderbooks();
+    case FeedBackend::PACKET_RING:
+      return updateOrderbooksRing();
+    case FeedBackend::IO_URING:
+    case FeedBackend::IO_URING_SQPOLL:
+      return updateOrderbooksUring();
+  }
+}
+
+//books come back from the last checkpoint and only the range after it is recovered, through the gap
+//that the first live packet opens. a checkpoint of another session would see every live sequence as old
+COLD bool Client::restoreCheckpoint(void)
+{
+  const CheckpointHeader *header = checkpointer.open();
+  if (header == nullptr)
+    return false;
+
+  MoldUDP64Header live{};
+  error |= recv(udp_sock_fd, &live, sizeof(live), MSG_PEEK) == -1;
+  CHECK_ERROR;
+
+  const bool same_session = (std::memcmp(live.session, header->session, sizeof(live.session)) == 0);
+  if (same_session)
+  {
+    checkpointer.restore(message_handler);
+    sequence_number = header->sequence_number;
+  }
+
+  checkpointer.close();
+  return same_session;
 }
 
+//the feed is queued while the snapshot downloads, to be replayed from the snapshot sequence right after
 COLD void Client::fetchOrderbooks(void)
 {
   sendLogin();
   recvLogin();
+
+  //the first snapshot packets can come in the read of the login acceptance
+  handleSnapshotPackets();
+
+  pollfd fds[2] = {
+    { tcp_sock_fd, POLLIN, 0 },
+    { udp_sock_fd, POLLIN, 0 }
+  };
+
   while (status == FETCHING)
-    recvSnapshot();
+  {
+    error |= poll(fds, 2, -1) == -1;
+    CHECK_ERROR;
+
+    if (fds[1].revents & POLLIN)
+      bufferLive();
+    if (fds[0].revents & POLLIN)
+      recvSnapshot();
+  }
+
   sendLogout();
+  snapshot_reader.release();
 }
 
-COLD void Client::syncSequences(void)
+//same as fetchOrderbooks, the feed comes in through the multishot receive and the snapshot stream through
+//receives into the free room of the reader, both waited on in the same completion loop
+COLD void Client::fetchOrderbooksUring(void)
 {
-  static constexpr uint16_t MAX_MSG_SIZE = MTU - sizeof(MoldUDP64Header);
+  sendLogin();
+  recvLogin();
 
-  msghdr msg{};
-  iovec iov[2];
-  struct Packet {
-    MoldUDP64Header header;
-    char payload[MAX_MSG_SIZE];
-  } packet{};
-
-  iov[0] = { &packet.header, sizeof(MoldUDP64Header) };
-  iov[1] = { packet.payload, MAX_MSG_SIZE };
-  msg.msg_iov = iov;
-  msg.msg_iovlen = 2;
-
-  uint64_t sequence_number = 0;
-  while (sequence_number < this->sequence_number - 1)
+  handleSnapshotPackets();
+
+  const auto recvSnapshotUring = [this](void)
   {
-    recvmsg(udp_sock_fd, &msg, MSG_WAITFORONE);
-    sequence_number = packet.header.sequence_number;
+    uint32_t count;
+    char *const free_bytes = snapshot_reader.claim(count);
+    uring.recv(tcp_sock_fd, free_bytes, count, 0, SNAPSHOT);
+    uring.submit();
+  };
+
+  openUring();
+  if (status == FETCHING)
+    recvSnapshotUring();
+
+  while (status == FETCHING)
+  {
+    uring.wait(0);
+    uring.forEachCompletion([this, &recvSnapshotUring](const io_uring_cqe &cqe)
+    {
+      if (cqe.user_data == FEED)
+      {
+        if (cqe.flags & IORING_CQE_F_BUFFER)
+        {
+          uint16_t size;
+          const MoldUDP64Packet &live = getFeedPacket(cqe, size);
+          uint16_t slots_count = 1;
+          std::memcpy(live_queue.claim(slots_count), &live, size);
+          live_queue.commit(1);
+          uring.recycleBuffer(FEED, cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        }
+        if (!(cqe.flags & IORING_CQE_F_MORE))
+          rearmFeed(cqe);
+        return;
+      }
+
+      error |= cqe.res <= 0;
+      CHECK_ERROR;
+
+      snapshot_reader.commit(cqe.res);
+      handleSnapshotPackets();
+
+      if (status == FETCHING)
+        recvSnapshotUring();
+    });
+  }
+
+  sendLogout();
+  snapshot_reader.release();
+}
+
+COLD void Client::bufferLive(void)
+{
+  mmsghdr mmsgs[MAX_BURST_PACKETS]{};
+  iovec iov[MAX_BURST_PACKETS];
+  uint16_t slots_count;
+  int packets_count;
+
+  for (int i = 0; i < MAX_BURST_PACKETS; ++i)
+  {
+    mmsgs[i].msg_hdr.msg_iov = &iov[i];
+    mmsgs[i].msg_hdr.msg_iovlen = 1;
   }
+
+  //packets are received straight into the queue, a burst stops early at the end of a chunk
+  do
+  {
+    slots_count = MAX_BURST_PACKETS;
+    MoldUDP64Packet *slots = live_queue.claim(slots_count);
+
+    for (uint16_t i = 0; i < slots_count; ++i)
+      iov[i] = { &slots[i], sizeof(MoldUDP64Packet) };
+
+    packets_count = recvmmsg(udp_sock_fd, mmsgs, slots_count, MSG_DONTWAIT, nullptr);
+    error |= (packets_count == -1 && errno != EAGAIN && errno != EWOULDBLOCK);
+    CHECK_ERROR;
+
+    packets_count = std::max(packets_count, 0);
+    live_queue.commit(packets_count);
+  }
+  while (packets_count == slots_count);
+}
+
+//queued packets older than the snapshot are trimmed, gaps inside the queue are filled from Rewind
+COLD void Client::replayBuffered(void)
+{
+  const BlocksHandler handleBlocks = getBlocksHandler(workers.size() != 0, false);
+  const auto apply = [this, handleBlocks](const char *restrict buffer, const uint16_t blocks_count)
+  {
+    handleBlocks(*this, buffer, blocks_count);
+  };
+
+  live_queue.forEach([this, &apply](const MoldUDP64Packet &packet)
+  {
+    if (!GapRecovery::applyFrom(packet, sequence_number, apply))
+      recovery.recover(std::span(&packet, 1), sequence_number, apply, false);
+  });
+
+  live_queue.release();
 }
 
 HOT void Client::updateOrderbooks(void)
 {
   static constexpr uint16_t MAX_MSG_SIZE = MTU - sizeof(MoldUDP64Header);
 
+  replayBuffered();
+
   //+1 added for safe prefetching past the last packet 
-  alignas(CACHELINE_SIZE) mmsghdr mmsgs[MAX_BURST_PACKETS+1];
-  alignas(CACHELINE_SIZE) iovec iov[2][MAX_BURST_PACKETS+1];
-  alignas(CACHELINE_SIZE) struct Packet {
-    MoldUDP64Header header;
-    char payload[MAX_MSG_SIZE];
-  } packets[MAX_BURST_PACKETS+1]{};
+  alignas(CACHELINE_SIZE) mmsghdr mmsgs[MAX_BURST_PACKETS+1]{};
+  alignas(CACHELINE_SIZE) iovec iov[MAX_BURST_PACKETS+1][2];
+  alignas(CACHELINE_SIZE) MoldUDP64Packet packets[MAX_BURST_PACKETS+1]{};
+  alignas(CACHELINE_SIZE) char controls[MAX_BURST_PACKETS][CMSG_SPACE(sizeof(timespec))];
 
   for (int i = 0; i < MAX_BURST_PACKETS; ++i)
   {
-    iov[0][i] = { &packets[i].header, sizeof(MoldUDP64Header) };
-    iov[1][i] = { packets[i].payload, MAX_MSG_SIZE };
+    iov[i][0] = { &packets[i].header, sizeof(MoldUDP64Header) };
+    iov[i][1] = { packets[i].payload, MAX_MSG_SIZE };
 
-    mmsgs[i].msg_hdr.msg_iov = &iov[0][i];
+    mmsgs[i].msg_hdr.msg_iov = iov[i];
     mmsgs[i].msg_hdr.msg_iovlen = 2;
   }
 
+  const bool timed = latency.isEnabled();
+  const BlocksHandler handleBlocks = getBlocksHandler(workers.size() != 0, timed);
+  const auto apply = [this, handleBlocks](const char *restrict buffer, const uint16_t blocks_count)
+  {
+    handleBlocks(*this, buffer, blocks_count);
+  };
+
   while (true)
   {
+    //the kernel shrinks msg_controllen to what it wrote
+    if (timed) [[unlikely]]
+      for (int i = 0; i < MAX_BURST_PACKETS; ++i)
+        mmsgs[i].msg_hdr.msg_control = controls[i], mmsgs[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+
     int8_t packets_count = recvmmsg(udp_sock_fd, mmsgs, MAX_BURST_PACKETS, MSG_WAITFORONE, nullptr);
     error |= packets_count == -1;
-    const Packet *packet = std::assume_aligned<CACHELINE_SIZE>(packets);
+    CHECK_ERROR;
+    const MoldUDP64Packet *packet = std::assume_aligned<CACHELINE_SIZE>(packets);
+
+    if (timed) [[unlikely]]
+      latency.stampReceive(packet_stamps);
 
     while(packets_count--)
     {
       PREFETCH_R(packet + 1, 1);
       const uint16_t message_count = packet->header.message_count;
 
-      error |= (packet->header.sequence_number != sequence_number);
-      CHECK_ERROR;
-
-      processMessageBlocks(packet->payload, message_count);
+      if (timed) [[unlikely]]
+        stampPacket(LatencyStats::getKernelTimestamp(mmsgs[packet - packets].msg_hdr));
+
+      //duplicates and overlaps are trimmed, gaps park the rest of the burst until Rewind fills them
+      if (packet->header.sequence_number != sequence_number) [[unlikely]]
+      {
+        //what was decoded of the burst goes first
+        if (batch_bursts)
+          message_handler.applyBurst();
+
+        if (!GapRecovery::applyFrom(*packet, sequence_number, apply))
+        {
+          recovery.recover(std::span(packet, packets_count + 1), sequence_number, apply, true);
+          break;
+        }
+        packet++;
+        continue;
+      }
+
+      if (batch_bursts)
+        message_handler.decodeMessageBlocks(packet->payload, message_count);
+      else
+        handleBlocks(*this, packet->payload, message_count);
 
       sequence_number += message_count;
       packet++;
     }
+
+    if (batch_bursts)
+      message_handler.applyBurst();
+
+    if (checkpointer.isDue()) [[unlikely]]
+      checkpointer.capture(message_handler, sequence_number, packets[0].header.session);
+  }
+
+  std::unreachable();
+}
+
+//same as updateOrderbooks, packets are read in place from the ring. whatever the socket queued until it was open
+//is replayed first. recovery leaves the rest of the feed in the ring
+HOT void Client::updateOrderbooksRing(void)
+{
+  packet_ring.open();
+
+  //the ring has every packet from here on, the socket only keeps the group joined. The kernel clamps the buffer
+  //to its minimum, a couple of packets, and drops the rest of its copy of the feed. What it queued before is kept
+  //for bufferLive. shutdown(SHUT_RD) would not stop an unconnected udp socket queueing
+  constexpr int min_bufsize = 0;
+  error |= setsockopt(udp_sock_fd, SOL_SOCKET, SO_RCVBUF, &min_bufsize, sizeof(min_bufsize)) == -1;
+  CHECK_ERROR;
+
+  bufferLive();
+  replayBuffered();
+
+  const bool timed = latency.isEnabled();
+  const BlocksHandler handleBlocks = getBlocksHandler(workers.size() != 0, timed);
+
+  while (true)
+  {
+    packet_ring.receive([this, handleBlocks, timed](const MoldUDP64Packet &packet, const uint16_t size, const uint64_t nic_ns)
+    {
+      if (timed) [[unlikely]]
+      {
+        latency.stampReceive(packet_stamps);
+        stampPacket(nic_ns);
+      }
+
+      handleLivePacket(packet, size, handleBlocks);
+
+      if (checkpointer.isDue()) [[unlikely]]
+        checkpointer.capture(message_handler, sequence_number, packet.header.session);
+    });
   }
 
   std::unreachable();
 }
 
+//same as updateOrderbooks, packets are read in place from the provided buffers, which go back to the kernel right after.
+//recovery leaves the rest of the feed in the completion queue and the socket
+HOT void Client::updateOrderbooksUring(void)
+{
+  if (!uring.isOpen())
+    openUring();
+
+  replayBuffered();
+
+  const bool timed = latency.isEnabled();
+  const BlocksHandler handleBlocks = getBlocksHandler(workers.size() != 0, timed);
+
+  while (true)
+  {
+    uring.wait(URING_SPIN_LIMIT);
+
+    if (timed) [[unlikely]]
+      latency.stampReceive(packet_stamps);
+
+    uring.forEachCompletion([this, handleBlocks, timed](const io_uring_cqe &cqe)
+    {
+      if (cqe.flags & IORING_CQE_F_BUFFER) [[likely]]
+      {
+        uint16_t size;
+        const MoldUDP64Packet &packet = getFeedPacket(cqe, size);
+
+        if (timed) [[unlikely]]
+          stampPacket(getFeedTimestamp(cqe));
+        handleLivePacket(packet, size, handleBlocks);
+
+        if (checkpointer.isDue()) [[unlikely]]
+          checkpointer.capture(message_handler, sequence_number, packet.header.session);
+
+        uring.recycleBuffer(FEED, cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+      }
+
+      if (!(cqe.flags & IORING_CQE_F_MORE)) [[unlikely]]
+        rearmFeed(cqe);
+    });
+  }
+
+  std::unreachable();
+}
+
+COLD void Client::openUring(void)
+{
+  static_assert(URING_FEED_BUFFER_SIZE >= sizeof(io_uring_recvmsg_out) + CMSG_SPACE(sizeof(timespec)) + MTU, "URING_FEED_BUFFER_SIZE must fit a full datagram");
+
+  uring.open();
+  uring.setupBuffers(FEED, URING_FEED_BUFFERS, URING_FEED_BUFFER_SIZE);
+  armFeed();
+}
+
+COLD void Client::armFeed(void)
+{
+  uring.recvmsgMultishot(udp_sock_fd, feed_msg, FEED, FEED);
+  uring.submit();
+}
+
+//a multishot receive stops on errors, and when the provided buffers run out or the completion queue overflows
+COLD void Client::rearmFeed(const io_uring_cqe &cqe)
+{
+  error |= (cqe.res < 0 && cqe.res != -ENOBUFS);
+  CHECK_ERROR;
+  armFeed();
+}
+
+//each buffer starts with the recvmsg header, then the name and control areas sized by feed_msg
+HOT ALWAYS_INLINE inline const MoldUDP64Packet &Client::getFeedPacket(const io_uring_cqe &cqe, uint16_t &size) const noexcept
+{
+  const char *const buffer = uring.getBuffer(FEED, cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+  const io_uring_recvmsg_out &out = *reinterpret_cast<const io_uring_recvmsg_out *>(buffer);
+
+  size = out.payloadlen;
+  return *reinterpret_cast<const MoldUDP64Packet *>(buffer + sizeof(out) + feed_msg.msg_namelen + feed_msg.msg_controllen);
+}
+
+COLD uint64_t Client::getFeedTimestamp(const io_uring_cqe &cqe) const noexcept
+{
+  const char *const buffer = uring.getBuffer(FEED, cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+  const io_uring_recvmsg_out &out = *reinterpret_cast<const io_uring_recvmsg_out *>(buffer);
+
+  msghdr msg{};
+  msg.msg_control = const_cast<char *>(buffer + sizeof(out) + feed_msg.msg_namelen);
+  msg.msg_controllen = out.controllen;
+
+  return LatencyStats::getKernelTimestamp(msg);
+}
+
+//the receive side of the packet about to be handled, the receive call was stamped already
+HOT ALWAYS_INLINE inline void Client::stampPacket(const uint64_t nic_ns) noexcept
+{
+  packet_stamps.nic_ns = nic_ns;
+  latency.recordReceive(packet_stamps);
+}
+
+//packets read in place, only as long as their datagram
+HOT ALWAYS_INLINE inline void Client::handleLivePacket(const MoldUDP64Packet &packet, const uint16_t size, const BlocksHandler handleBlocks)
+{
+  const uint16_t message_count = packet.header.message_count;
+
+  if (packet.header.sequence_number != sequence_number) [[unlikely]]
+    return resyncFrom(packet, size, handleBlocks);
+
+  handleBlocks(*this, packet.payload, message_count);
+  sequence_number += message_count;
+}
+
+//duplicates and overlaps are trimmed, a gap is recovered from a copy of the packet
+COLD NEVER_INLINE void Client::resyncFrom(const MoldUDP64Packet &packet, const uint16_t size, const BlocksHandler handleBlocks)
+{
+  const auto apply = [this, handleBlocks](const char *restrict buffer, const uint16_t blocks_count)
+  {
+    handleBlocks(*this, buffer, blocks_count);
+  };
+
+  if (GapRecovery::applyFrom(packet, sequence_number, apply))
+    return;
+
+  alignas(CACHELINE_SIZE) MoldUDP64Packet copy;
+  std::memcpy(&copy, &packet, std::min<size_t>(size, sizeof(copy)));
+  recovery.recover(std::span(&copy, 1), sequence_number, apply, false);
+}
+
+//books are either processed on this thread or sharded over the workers. Timing the books of the
+//workers would need the stamps to travel with the messages, so they only get the receive side timed
+COLD Client::BlocksHandler Client::getBlocksHandler(const bool sharded, const bool timed) noexcept
+{
+  static constexpr BlocksHandler handlers[] = {
+    [](Client &client, const char *restrict buffer, const uint16_t blocks_count) { client.message_handler.handleMessageBlocks(buffer, blocks_count); },
+    [](Client &client, const char *restrict buffer, const uint16_t blocks_count) { client.workers.handleMessageBlocks(buffer, blocks_count); },
+    [](Client &client, const char *restrict buffer, const uint16_t blocks_count) { client.message_handler.handleMessageBlocks(buffer, blocks_count, client.packet_stamps, client.latency); }
+  };
+
+  const uint8_t idx = sharded | ((timed & !sharded) << 1);
+  return handlers[idx];
+}
+
 COLD void Client::sendLogin(void) const
 {
   SoupBinTCPPacket packet;
@@ -224,47 +631,55 @@ COLD void Client::sendLogin(void) const
   CHECK_ERROR;
 }
 
+//heartbeats can come before the acceptance, whatever comes after it is left in the reader for the snapshot
 COLD void Client::recvLogin(void)
 {
-  SoupBinTCPPacket packet;
-
-  error |= recv(tcp_sock_fd, &packet, sizeof(packet.body_length), MSG_WAITALL) == -1;
-  error |= recv(tcp_sock_fd, &packet.body, packet.body_length, MSG_WAITALL) == -1;
-
-  CHECK_ERROR;
-
-  switch (packet.body.type)
+  while (status == CONNECTING)
   {
-    case 'H':
-      recvLogin();
-      break;
-    case 'A':
+    snapshot_reader.read(tcp_sock_fd);
+    snapshot_reader.forEachPacket([this](const SoupBinTCPPacket &packet)
     {
-      const auto &response = packet.body.login_acceptance;
-      std::string sequence_str = std::string(response.sequence, sizeof(response.sequence));
-      sequence_number = std::stoull(sequence_str);
-      status = FETCHING;
-      break;
-    }
-    default:
-      panic();
+      switch (packet.body.type)
+      {
+        case 'H':
+          return true;
+        case 'A':
+        {
+          const auto &response = packet.body.login_acceptance;
+          std::string sequence_str = std::string(response.sequence, sizeof(response.sequence));
+          sequence_number = std::stoull(sequence_str);
+          status = FETCHING;
+          return false;
+        }
+        default:
+          panic();
+      }
+    });
   }
 }
 
+//one read of as much of the stream as the socket has, instead of two blocking receives per packet
 COLD void Client::recvSnapshot(void)
 {
-  thread_local static std::array<char, UINT16_MAX> buffer{};
-  SoupBinTCPPacket &packet = *reinterpret_cast<SoupBinTCPPacket *>(buffer.data());
-
-  error |= recv(tcp_sock_fd, &packet, sizeof(packet.body_length), MSG_WAITALL) == -1;
-  error |= recv(tcp_sock_fd, &packet.body, packet.body_length, MSG_WAITALL) == -1;
+  snapshot_reader.read(tcp_sock_fd);
+  handleSnapshotPackets();
+}
 
-  CHECK_ERROR;
+//the packets after the completion are not part of the snapshot
+COLD void Client::handleSnapshotPackets(void)
+{
+  snapshot_reader.forEachPacket([this](const SoupBinTCPPacket &packet)
+  {
+    handleSnapshotPacket(packet);
+    return status == FETCHING;
+  });
+}
 
+COLD void Client::handleSnapshotPacket(const SoupBinTCPPacket &packet)
+{
   switch (packet.body.type)
   {
     case 'H':
-      recvSnapshot();
       break;
     case 'S':
     {
@@ -290,24 +705,10 @@ COLD void Client::sendLogout(void) const
 
 COLD void Client::processSnapshots(const char *restrict buffer, const uint16_t buffer_size)
 {
-  static constexpr uint8_t size = 'Z' + 1;
-  static constexpr std::array<uint16_t, size> data_lengths = []()
-  {
-    std::array<uint16_t, size> data_lengths{};
-    data_lengths['A'] = sizeof(MessageData::new_order);
-    data_lengths['D'] = sizeof(MessageData::deleted_order);
-    data_lengths['T'] = sizeof(MessageData::seconds);
-    data_lengths['R'] = sizeof(MessageData::series_info_basic);
-    data_lengths['M'] = sizeof(MessageData::series_info_basic_combination);
-    data_lengths['L'] = sizeof(MessageData::tick_size_data);
-    data_lengths['S'] = sizeof(MessageData::system_event);
-    data_lengths['O'] = sizeof(MessageData::trading_status);
-    data_lengths['E'] = sizeof(MessageData::execution_notice);
-    data_lengths['C'] = sizeof(MessageData::execution_notice_with_trade_info);
-    data_lengths['Z'] = sizeof(MessageData::ep);
-    data_lengths['G'] = sizeof(MessageData::snapshot_completion);
-    return data_lengths;
-  }();
+  //from the message schemas of the decoder
+  static constexpr std::array<uint16_t, 'Z' + 1> data_lengths = MessageDecoder::getDataLengths();
+
+  const bool sharded = (workers.size() != 0);
 
   const char *const end = buffer + buffer_size;
 
@@ -320,32 +721,23 @@ COLD void Client::processSnapshots(const char *restrict buffer, const uint16_t b
 
     if (data.type == 'G') [[unlikely]]
       handleSnapshotCompletion(data);
+    else if (sharded)
+      workers.handleMessage(data, length);
     else
-      message_handler.handleMessage(data);
+      message_handler.stageSnapshotMessage(data);
 
     sequence_number++;
     buffer += length;
   }
 }
 
-HOT void Client::processMessageBlocks(const char *restrict buffer, uint16_t blocks_count)
-{
-  while (blocks_count--)
-  {
-    const MessageBlock &block = *reinterpret_cast<const MessageBlock *>(buffer);
-    const uint16_t length = sizeof(block.length) + block.length;
-
-    PREFETCH_R(buffer + length, 1);
-    message_handler.handleMessage(block.data);
-
-    buffer += length;
-  }
-}
-
 COLD void Client::handleSnapshotCompletion(const MessageData &data)
 {
   const auto &snapshot_completion = data.snapshot_completion;
   sequence_number = std::stoull(snapshot_completion.sequence);
+
+  //the live messages buffered meanwhile are applied on top of complete books
+  message_handler.loadSnapshot();
   status = UPDATING;
 }
 
@@ -0,0 +1,110 @@
+/*================================================================================
+
+File: GapRecovery.cpp                                                           
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-24 11:12:47                                                 
+last edited: 2025-06-15 16:37:52                                                
+
+================================================================================*/
+
+#include <algorithm>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "GapRecovery.hpp"
+#include "error.hpp"
+#include "macros.hpp"
+
+COLD GapRecovery::GapRecovery(const sockaddr_in &rewind_address, const sockaddr_in &bind_address, const int live_sock_fd) :
+  rewind_address(rewind_address),
+  rewind_sock_fd(createSocket(bind_address)),
+  live_sock_fd(live_sock_fd),
+  session{},
+  parked(new MoldUDP64Packet[REORDER_BUFFER_PACKETS]),
+  parked_head(0),
+  parked_tail(0),
+  retransmission{},
+  requested_until(0),
+  request_time(),
+  stats{}
+{
+}
+
+COLD GapRecovery::~GapRecovery()
+{
+  close(rewind_sock_fd);
+}
+
+COLD int GapRecovery::createSocket(const sockaddr_in &bind_address) const
+{
+  const int sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  error |= sock_fd == -1;
+
+  constexpr int recv_bufsize = SOCK_BUFSIZE;
+
+  error |= setsockopt(sock_fd, SOL_SOCKET, SO_RCVBUF, &recv_bufsize, sizeof(recv_bufsize)) == -1;
+  error |= bind(sock_fd, reinterpret_cast<const sockaddr *>(&bind_address), sizeof(bind_address)) == -1;
+  error |= connect(sock_fd, reinterpret_cast<const sockaddr *>(&rewind_address), sizeof(rewind_address)) == -1;
+
+  CHECK_ERROR;
+
+  return sock_fd;
+}
+
+COLD const GapRecovery::Stats &GapRecovery::getStats(void) const noexcept
+{
+  return stats;
+}
+
+COLD void GapRecovery::park(const MoldUDP64Packet &packet)
+{
+  //dropping the newest packet is safe, its messages are requested from Rewind once the FIFO drains
+  if (isFull()) [[unlikely]]
+  {
+    stats.overflows++;
+    return;
+  }
+
+  std::memcpy(&parked[parked_tail & PARKED_MASK], &packet, sizeof(packet));
+  parked_tail++;
+}
+
+COLD void GapRecovery::receiveLive(void)
+{
+  if (live_sock_fd == -1)
+    return;
+
+  //the feed waits in the socket buffer, like with park_live == false
+  if (isFull()) [[unlikely]]
+    return;
+
+  const ssize_t size = recv(live_sock_fd, &parked[parked_tail & PARKED_MASK], sizeof(MoldUDP64Packet), MSG_DONTWAIT);
+  parked_tail += (size >= static_cast<ssize_t>(sizeof(MoldUDP64Header)));
+}
+
+COLD bool GapRecovery::receiveRetransmission(void)
+{
+  const ssize_t size = recv(rewind_sock_fd, &retransmission, sizeof(retransmission), MSG_DONTWAIT);
+  return (size >= static_cast<ssize_t>(sizeof(MoldUDP64Header)));
+}
+
+//a MoldUDP64 request is a bare header carrying the first sequence and the number of messages wanted
+COLD void GapRecovery::request(const uint64_t sequence_number, const uint64_t until)
+{
+  const uint16_t message_count = std::min<uint64_t>(until - sequence_number, REWIND_REQUEST_MESSAGES);
+
+  MoldUDP64Header header{};
+  std::memcpy(header.session, session, sizeof(session));
+  header.sequence_number = sequence_number;
+  header.message_count = message_count;
+
+  error |= send(rewind_sock_fd, &header, sizeof(header), 0) == -1;
+  CHECK_ERROR;
+
+  requested_until = sequence_number + message_count;
+  request_time = Clock::now();
+  stats.requests++;
+}
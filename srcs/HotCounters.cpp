@@ -0,0 +1,71 @@
+/*================================================================================
+
+File: HotCounters.cpp                                                           
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-18 09:41:05                                                 
+last edited: 2025-06-18 09:41:05                                                
+
+================================================================================*/
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <new>
+
+#include "HotCounters.hpp"
+#include "macros.hpp"
+#include "error.hpp"
+
+COLD HotCounters::HotCounters(const std::string &name, const uint32_t slots_count) :
+  name(name),
+  slots_count(slots_count),
+  mapping(nullptr)
+{
+  const size_t size = getSize(slots_count);
+
+  if (name.empty())
+  {
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    error |= memory == MAP_FAILED;
+    CHECK_ERROR;
+
+    mapping = static_cast<char *>(memory);
+  }
+  else
+  {
+    //a segment left by an earlier run is emptied first
+    const int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    error |= fd == -1;
+    CHECK_ERROR;
+
+    error |= ftruncate(fd, size) == -1;
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    error |= memory == MAP_FAILED;
+    close(fd);
+    CHECK_ERROR;
+
+    mapping = static_cast<char *>(memory);
+  }
+
+  Header &header = *new (mapping) Header{};
+  header.version = VERSION;
+  header.slots_count = slots_count;
+  header.sample_interval = HOT_COUNTERS_SAMPLE_INTERVAL;
+
+  for (uint32_t i = 0; i < slots_count; ++i)
+    new (&getSlot(i)) Slot{};
+
+  //the reader only trusts a segment with its magic, written last
+  std::atomic_ref<uint32_t>(header.magic).store(MAGIC, std::memory_order_release);
+}
+
+COLD HotCounters::~HotCounters()
+{
+  munmap(mapping, getSize(slots_count));
+
+  if (!name.empty())
+    shm_unlink(name.c_str());
+}
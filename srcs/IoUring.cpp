@@ -0,0 +1,200 @@
+/*================================================================================
+
+File: IoUring.cpp                                                               
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-14 10:03:37                                                 
+last edited: 2025-06-14 10:03:37                                                
+
+================================================================================*/
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "IoUring.hpp"
+#include "error.hpp"
+#include "macros.hpp"
+
+COLD IoUring::IoUring(const bool sqpoll) noexcept :
+  sqpoll(sqpoll),
+  ring_fd(-1),
+  sq_ring(nullptr),
+  cq_ring(nullptr),
+  sq_ring_size(0),
+  cq_ring_size(0),
+  sqes(nullptr),
+  sq_tail(nullptr),
+  sq_flags(nullptr),
+  sq_mask(0),
+  sqe_tail(0),
+  cq_head(nullptr),
+  cq_tail(nullptr),
+  cqes(nullptr),
+  cq_mask(0),
+  enters(0),
+  groups() {}
+
+COLD IoUring::~IoUring()
+{
+  for (const BufferGroup &group : groups)
+  {
+    if (group.ring == nullptr)
+      continue;
+    munmap(group.ring, group.ring_size);
+    munmap(group.buffers, static_cast<size_t>(group.count) * group.buffer_size);
+  }
+
+  if (sqes != nullptr)
+    munmap(sqes, URING_ENTRIES * sizeof(io_uring_sqe));
+  if (cq_ring != nullptr && cq_ring != sq_ring)
+    munmap(cq_ring, cq_ring_size);
+  if (sq_ring != nullptr)
+    munmap(sq_ring, sq_ring_size);
+  if (ring_fd != -1)
+    close(ring_fd);
+}
+
+//without sqpoll the ring is only ever used from the thread opening it, completions are then posted when it waits
+COLD void IoUring::open(void)
+{
+  io_uring_params params{};
+  params.flags = sqpoll ? IORING_SETUP_SQPOLL : (IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN);
+  params.flags |= IORING_SETUP_CQSIZE;
+  params.cq_entries = URING_CQ_ENTRIES;
+  params.sq_thread_idle = URING_SQPOLL_IDLE_MS;
+
+  ring_fd = syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+  error |= ring_fd == -1;
+  error |= !(params.features & IORING_FEAT_SINGLE_MMAP);
+  CHECK_ERROR;
+
+  sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+
+  sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  error |= sq_ring == MAP_FAILED;
+  CHECK_ERROR;
+  cq_ring = sq_ring;
+
+  void *const sqes_address = mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  error |= sqes_address == MAP_FAILED;
+  CHECK_ERROR;
+  sqes = static_cast<io_uring_sqe *>(sqes_address);
+
+  char *const sq = static_cast<char *>(sq_ring);
+  sq_tail = reinterpret_cast<uint32_t *>(sq + params.sq_off.tail);
+  sq_flags = reinterpret_cast<uint32_t *>(sq + params.sq_off.flags);
+  sq_mask = *reinterpret_cast<uint32_t *>(sq + params.sq_off.ring_mask);
+  sqe_tail = *sq_tail;
+
+  uint32_t *const sq_array = reinterpret_cast<uint32_t *>(sq + params.sq_off.array);
+  for (uint32_t i = 0; i < params.sq_entries; ++i)
+    sq_array[i] = i;
+
+  char *const cq = static_cast<char *>(cq_ring);
+  cq_head = reinterpret_cast<uint32_t *>(cq + params.cq_off.head);
+  cq_tail = reinterpret_cast<uint32_t *>(cq + params.cq_off.tail);
+  cq_mask = *reinterpret_cast<uint32_t *>(cq + params.cq_off.ring_mask);
+  cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+}
+
+//count buffers of size bytes, all handed to the kernel up front
+COLD void IoUring::setupBuffers(const uint16_t group, const uint16_t count, const uint32_t size)
+{
+  error |= (group >= URING_BUFFER_GROUPS) || (count & (count - 1)) != 0;
+  CHECK_ERROR;
+
+  BufferGroup &buffer_group = groups[group];
+  buffer_group.ring_size = count * sizeof(io_uring_buf);
+  buffer_group.buffer_size = size;
+  buffer_group.count = count;
+  buffer_group.tail = 0;
+
+  void *const ring = mmap(nullptr, buffer_group.ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+  void *const buffers = mmap(nullptr, static_cast<size_t>(count) * size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+  error |= (ring == MAP_FAILED) || (buffers == MAP_FAILED);
+  CHECK_ERROR;
+
+  buffer_group.ring = static_cast<io_uring_buf_ring *>(ring);
+  buffer_group.buffers = static_cast<char *>(buffers);
+
+  io_uring_buf_reg registration{};
+  registration.ring_addr = reinterpret_cast<uint64_t>(ring);
+  registration.ring_entries = count;
+  registration.bgid = group;
+
+  error |= syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PBUF_RING, &registration, 1) == -1;
+  CHECK_ERROR;
+
+  for (uint16_t id = 0; id < count; ++id)
+    recycleBuffer(group, id);
+}
+
+COLD void IoUring::recv(const int fd, void *buffer, const uint32_t size, const int flags, const uint64_t user_data)
+{
+  io_uring_sqe &sqe = *getSqe();
+  sqe.opcode = IORING_OP_RECV;
+  sqe.fd = fd;
+  sqe.addr = reinterpret_cast<uint64_t>(buffer);
+  sqe.len = size;
+  sqe.msg_flags = flags;
+  sqe.user_data = user_data;
+}
+
+//msg only sizes the name and control areas which precede the payload in each buffer, it must outlive the receive
+COLD void IoUring::recvmsgMultishot(const int fd, const msghdr &msg, const uint16_t group, const uint64_t user_data)
+{
+  io_uring_sqe &sqe = *getSqe();
+  sqe.opcode = IORING_OP_RECVMSG;
+  sqe.fd = fd;
+  sqe.addr = reinterpret_cast<uint64_t>(&msg);
+  sqe.len = 1;
+  sqe.ioprio = IORING_RECV_MULTISHOT;
+  sqe.flags = IOSQE_BUFFER_SELECT;
+  sqe.buf_group = group;
+  sqe.user_data = user_data;
+}
+
+COLD void IoUring::submit(void)
+{
+  const uint32_t to_submit = sqe_tail - *sq_tail;
+  std::atomic_ref<uint32_t>(*sq_tail).store(sqe_tail, std::memory_order_release);
+
+  if (!sqpoll)
+    return enter(to_submit, 0, 0);
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (std::atomic_ref<uint32_t>(*sq_flags).load(std::memory_order_relaxed) & IORING_SQ_NEED_WAKEUP)
+    enter(0, 0, IORING_ENTER_SQ_WAKEUP);
+}
+
+COLD uint64_t IoUring::getEnters(void) const noexcept
+{
+  return enters;
+}
+
+COLD io_uring_sqe *IoUring::getSqe(void)
+{
+  //submissions are rare and consumed as soon as they are submitted, a full queue is flushed first
+  if (sqe_tail - *sq_tail > sq_mask)
+    submit();
+
+  io_uring_sqe *const sqe = &sqes[sqe_tail++ & sq_mask];
+  std::memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+HOT void IoUring::enter(const uint32_t to_submit, const uint32_t min_complete, const uint32_t flags)
+{
+  enters++;
+  const long result = syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0);
+  error |= (result == -1 && errno != EINTR);
+  CHECK_ERROR;
+}
@@ -0,0 +1,567 @@
+/*================================================================================
+
+File: LadderOrderBook.cpp                                                       
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-08 16:21:37                                                 
+last edited: 2025-06-28 10:36:18                                                
+
+================================================================================*/
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+
+#include "LadderOrderBook.hpp"
+#include "macros.hpp"
+#include "error.hpp"
+
+//a new window leaves a quarter of the ladder for the touch to improve into, the rest holds depth
+static constexpr int64_t ANCHOR_OFFSET = LADDER_SIZE * 3 / 4;
+
+COLD LadderOrderBook::LadderOrderBook(void) noexcept :
+  ladders{},
+  tick_tiers{{INT32_MIN, INT32_MAX, 1, 0}},
+  equilibrium_price(INT32_MIN),
+  equilibrium_bid_qty(0),
+  equilibrium_ask_qty(0),
+  counters(&HotCounters::unbound)
+{
+  ladders[BID].prices[0] = INT32_MIN;
+  ladders[ASK].prices[0] = INT32_MAX;
+}
+
+COLD LadderOrderBook::LadderOrderBook(LadderOrderBook &&other) noexcept :
+  ladders{std::move(other.ladders)},
+  tick_tiers{std::move(other.tick_tiers)},
+  order_pool(std::move(other.order_pool)),
+  equilibrium_price(other.equilibrium_price),
+  equilibrium_bid_qty(other.equilibrium_bid_qty),
+  equilibrium_ask_qty(other.equilibrium_ask_qty),
+  counters(other.counters)
+{
+}
+
+COLD LadderOrderBook::~LadderOrderBook()
+{
+}
+
+COLD OrderPool::Stats LadderOrderBook::getPoolStats(void) const noexcept
+{
+  return order_pool.getStats();
+}
+
+COLD void LadderOrderBook::save(CheckpointWriter &writer) const
+{
+  for (const Ladder &ladder : ladders)
+  {
+    writer.write(ladder.anchor);
+    writer.write(ladder.best_slot);
+    writer.write(ladder.summary);
+    writer.write(ladder.bitmap);
+    writer.writeArray(ladder.prices.data(), LADDER_SIZE);
+    writer.writeArray(ladder.cumulative_qtys.data(), LADDER_SIZE);
+    writer.writeArray(ladder.queues.data(), LADDER_SIZE);
+    writer.writeArray(ladder.overflow);
+    ladder.order_index.save(writer);
+  }
+
+  writer.writeArray(tick_tiers);
+  order_pool.save(writer);
+
+  writer.write(equilibrium_price);
+  writer.write(equilibrium_bid_qty);
+  writer.write(equilibrium_ask_qty);
+}
+
+COLD void LadderOrderBook::load(CheckpointReader &reader)
+{
+  for (Ladder &ladder : ladders)
+  {
+    reader.read(ladder.anchor);
+    reader.read(ladder.best_slot);
+    reader.read(ladder.summary);
+    reader.read(ladder.bitmap);
+    reader.readArray(ladder.prices.data(), LADDER_SIZE);
+    reader.readArray(ladder.cumulative_qtys.data(), LADDER_SIZE);
+    reader.readArray(ladder.queues.data(), LADDER_SIZE);
+    reader.readArray(ladder.overflow);
+    ladder.order_index.load(reader);
+
+    ladder.levels_count = 0;
+    for (const uint64_t word : ladder.bitmap)
+      ladder.levels_count += std::popcount(word);
+  }
+
+  reader.readArray(tick_tiers);
+  order_pool.load(reader);
+
+  reader.read(equilibrium_price);
+  reader.read(equilibrium_bid_qty);
+  reader.read(equilibrium_ask_qty);
+}
+
+COLD void LadderOrderBook::addTickSize(const uint64_t tick_size, const int32_t price_from, const int32_t price_to)
+{
+  //the default tier (price_from == INT32_MIN) only serves books without a tick table
+  std::erase_if(tick_tiers, [](const TickTier &tier) { return tier.price_from == INT32_MIN; });
+
+  const int64_t safe_tick_size = std::max<uint64_t>(tick_size, 1);
+  const int32_t safe_price_to = (price_to == 0) ? INT32_MAX : price_to;
+  tick_tiers.push_back({price_from, safe_price_to, safe_tick_size, 0});
+
+  std::ranges::sort(tick_tiers, {}, &TickTier::price_from);
+
+  for (size_t i = 1; i < tick_tiers.size(); ++i)
+  {
+    const TickTier &prev = tick_tiers[i - 1];
+    const int64_t width = static_cast<int64_t>(tick_tiers[i].price_from) - prev.price_from;
+    tick_tiers[i].first_tick = prev.first_tick + (width + prev.tick_size - 1) / prev.tick_size;
+  }
+
+  const bool has_orders = ladders[BID].best_slot | ladders[ASK].best_slot;
+  if (has_orders) [[unlikely]]
+    rebuild();
+}
+
+//best level first, returns how many of the depth levels the side has. The overflow list is only aggregated
+//when the window holds fewer than depth levels
+HOT uint32_t LadderOrderBook::copyTopLevels(const Side side, int32_t *restrict prices, uint64_t *restrict qtys, const uint32_t depth) const noexcept
+{
+  const Ladder &ladder = ladders[side];
+  uint32_t count = 0;
+
+  for (uint32_t slot = ladder.best_slot; slot != 0 && count < depth; slot = getLowerSlot(ladder, slot))
+  {
+    prices[count] = ladder.prices[slot];
+    qtys[count] = ladder.cumulative_qtys[slot];
+    ++count;
+  }
+
+  const bool short_window = (count < depth) & !ladder.overflow.empty();
+  if (short_window) [[unlikely]]
+    count = copyOverflowLevels(ladder, side, prices, qtys, count, depth);
+
+  return count;
+}
+
+//qty resting at most distance price units away from the touch
+HOT uint64_t LadderOrderBook::getQtyWithin(const Side side, const uint32_t distance) const noexcept
+{
+  const Ladder &ladder = ladders[side];
+  const int64_t best_price = ladder.prices[ladder.best_slot];
+
+  uint64_t qty = 0;
+  uint32_t slot = ladder.best_slot;
+
+  for (; slot != 0; slot = getLowerSlot(ladder, slot))
+  {
+    const int64_t price = ladder.prices[slot];
+    if (std::abs(price - best_price) > distance)
+      return qty;
+
+    qty += ladder.cumulative_qtys[slot];
+  }
+
+  //the window ran out before the distance did
+  for (const auto &order : ladder.overflow)
+    qty += (std::abs(order.price - best_price) <= distance) * order.qty;
+
+  return qty;
+}
+
+//average price paid taking qty from the side, best levels first
+HOT LadderOrderBook::Sweep LadderOrderBook::getSweep(const Side side, const uint64_t qty) const noexcept
+{
+  const Ladder &ladder = ladders[side];
+
+  uint64_t filled_qty = 0;
+  double notional = 0;
+
+  for (uint32_t slot = ladder.best_slot; slot != 0 && filled_qty < qty; slot = getLowerSlot(ladder, slot))
+  {
+    const uint64_t taken = std::min(ladder.cumulative_qtys[slot], qty - filled_qty);
+    notional += static_cast<double>(ladder.prices[slot]) * taken;
+    filled_qty += taken;
+  }
+
+  const bool short_window = (filled_qty < qty) & !ladder.overflow.empty();
+  if (short_window) [[unlikely]]
+    sweepOverflow(ladder, side, qty, filled_qty, notional);
+
+  return { filled_qty, (filled_qty != 0) ? notional / filled_qty : 0.0 };
+}
+
+//levels found as in copyOverflowLevels, best first
+COLD void LadderOrderBook::sweepOverflow(const Ladder &ladder, const Side side, const uint64_t qty, uint64_t &filled, double &notional) const noexcept
+{
+  int64_t bound = INT64_MAX;
+
+  while (filled < qty)
+  {
+    int64_t best_key = INT64_MIN;
+    int32_t price = 0;
+    uint64_t level_qty = 0;
+
+    for (const auto &order : ladder.overflow)
+    {
+      const int64_t key = getKey(side, order.price);
+      if (key >= bound || key < best_key)
+        continue;
+
+      level_qty = (key == best_key) ? level_qty + order.qty : order.qty;
+      best_key = key;
+      price = order.price;
+    }
+
+    if (best_key == INT64_MIN)
+      return;
+
+    const uint64_t taken = std::min(level_qty, qty - filled);
+    notional += static_cast<double>(price) * taken;
+    filled += taken;
+    bound = best_key;
+  }
+}
+
+//each level is the best key below the previous one, summed over the unsorted orders
+COLD uint32_t LadderOrderBook::copyOverflowLevels(const Ladder &ladder, const Side side, int32_t *restrict prices, uint64_t *restrict qtys, uint32_t count, const uint32_t depth) const noexcept
+{
+  int64_t bound = INT64_MAX;
+
+  for (; count < depth; ++count)
+  {
+    int64_t best_key = INT64_MIN;
+    uint64_t qty = 0;
+
+    for (const auto &order : ladder.overflow)
+    {
+      const int64_t key = getKey(side, order.price);
+      if (key >= bound || key < best_key)
+        continue;
+
+      qty = (key == best_key) ? qty + order.qty : order.qty;
+      best_key = key;
+      prices[count] = order.price;
+    }
+
+    if (best_key == INT64_MIN)
+      break;
+
+    qtys[count] = qty;
+    bound = best_key;
+  }
+
+  return count;
+}
+
+//price and remaining qty of a resting order, false if the side has no such order
+HOT bool LadderOrderBook::findOrder(const uint64_t id, const Side side, int32_t &price, uint64_t &qty) noexcept
+{
+  Ladder &ladder = ladders[side];
+
+  const OrderIndex::Entry *order = ladder.order_index.find(id);
+  if (order == nullptr)
+    return false;
+
+  price = order->price;
+
+  if (order->position & OVERFLOW_FLAG) [[unlikely]]
+  {
+    qty = ladder.overflow[order->position & ~OVERFLOW_FLAG].qty;
+    return true;
+  }
+
+  const uint32_t slot = getKey(side, order->price) - ladder.anchor;
+  qty = order_pool.getQty(ladder.queues[slot], order->position);
+
+  return true;
+}
+
+//0 when the side has no level at the price. Prices outside the window can only be in the overflow list
+HOT uint64_t LadderOrderBook::getLevelQty(const Side side, const int32_t price) const noexcept
+{
+  const Ladder &ladder = ladders[side];
+  const int64_t slot = getKey(side, price) - ladder.anchor;
+
+  const bool in_window = (slot > 0) & (slot < LADDER_SIZE);
+  if (in_window) [[likely]]
+    return (ladder.queues[slot].size != 0) ? ladder.cumulative_qtys[slot] : 0;
+
+  uint64_t qty = 0;
+  for (const auto &order : ladder.overflow)
+    qty += (order.price == price) * order.qty;
+
+  return qty;
+}
+
+HOT void LadderOrderBook::addOrder(const uint64_t id, const Side side, const int32_t price, const uint64_t qty)
+{
+  Ladder &ladder = ladders[side];
+  const int64_t key = getKey(side, price);
+
+  //an empty side has an empty overflow list too, so the window can jump anywhere
+  if (ladder.best_slot == 0) [[unlikely]]
+    ladder.anchor = key - ANCHOR_OFFSET;
+
+  int64_t slot = key - ladder.anchor;
+
+  if (slot >= LADDER_SIZE) [[unlikely]]
+  {
+    moveWindow(ladder, side, key - ANCHOR_OFFSET);
+    slot = ANCHOR_OFFSET;
+  }
+
+  if (slot <= 0) [[unlikely]]
+  {
+    insertOverflowOrder(ladder, id, price, qty);
+    return;
+  }
+
+  //only counted here, moving the window reinserts levels too
+  const bool new_level = (ladder.queues[slot].size == 0);
+  HotCounters::increment(counters->new_levels, new_level);
+  HotCounters::increment(counters->existing_levels, !new_level);
+
+  insertOrder(ladder, slot, ladder.order_index.insert(id, price), qty);
+
+  HotCounters::raise(counters->max_depth[side], ladder.levels_count);
+}
+
+HOT void LadderOrderBook::removeOrder(const uint64_t id, const Side side)
+{
+  Ladder &ladder = ladders[side];
+
+  OrderIndex::Entry *order = ladder.order_index.find(id);
+  if (order == nullptr) [[unlikely]]
+    return;
+
+  reduceOrder(ladder, order, side, UINT64_MAX);
+}
+
+HOT void LadderOrderBook::executeOrder(const uint64_t id, const Side side, const uint64_t qty)
+{
+  Ladder &ladder = ladders[side];
+
+  OrderIndex::Entry *order = ladder.order_index.find(id);
+  if (order == nullptr) [[unlikely]]
+    return;
+
+  reduceOrder(ladder, order, side, qty);
+}
+
+//snapshot load. Adds are already constant time here, going best first only anchors the window at the touch
+//from the first order instead of moving it as better prices arrive
+COLD void LadderOrderBook::bulkLoad(std::span<BulkOrder> orders)
+{
+  std::ranges::stable_sort(orders, [](const BulkOrder &a, const BulkOrder &b) noexcept
+  {
+    if (a.side != b.side)
+      return a.side < b.side;
+    return (a.side == BID) ? (a.price > b.price) : (a.price < b.price);
+  });
+
+  for (const BulkOrder &order : orders)
+    addOrder(order.id, order.side, order.price, order.qty);
+}
+
+HOT void LadderOrderBook::insertOrder(Ladder &ladder, const uint32_t slot, OrderIndex::Entry *order, const uint64_t qty)
+{
+  OrderQueue &queue = ladder.queues[slot];
+
+  if (queue.size == 0)
+  {
+    queue = order_pool.allocate();
+    ladder.levels_count++;
+  }
+
+  ladder.prices[slot] = order->price;
+  ladder.cumulative_qtys[slot] += qty;
+  order->position = order_pool.push(queue, ladder.order_index.getKey(order), qty);
+
+  setSlot(ladder, slot);
+  ladder.best_slot = std::max(ladder.best_slot, slot);
+}
+
+COLD void LadderOrderBook::insertOverflowOrder(Ladder &ladder, const uint64_t id, const int32_t price, const uint64_t qty)
+{
+  auto &overflow = ladder.overflow;
+
+  overflow.push_back({id, price, qty});
+  ladder.order_index.insert(id, price)->position = OVERFLOW_FLAG | (overflow.size() - 1);
+}
+
+HOT void LadderOrderBook::reduceOrder(Ladder &ladder, OrderIndex::Entry *order, const Side side, const uint64_t qty)
+{
+  if (order->position & OVERFLOW_FLAG) [[unlikely]]
+    return reduceOverflowOrder(ladder, order, side, qty);
+  reduceLadderOrder(ladder, order, side, qty);
+}
+
+HOT void LadderOrderBook::reduceLadderOrder(Ladder &ladder, OrderIndex::Entry *order, const Side side, const uint64_t qty)
+{
+  const uint32_t slot = getKey(side, order->price) - ladder.anchor;
+  const uint32_t position = order->position;
+
+  OrderQueue &queue = ladder.queues[slot];
+  const uint64_t order_qty = order_pool.getQty(queue, position);
+  const uint64_t executed_qty = std::min(qty, order_qty);
+
+  order_pool.setQty(queue, position, order_qty - executed_qty);
+  ladder.cumulative_qtys[slot] -= executed_qty;
+
+  if (order_qty > executed_qty)
+    return;
+
+  //the last order of the queue takes the place of the removed one
+  const OrderIndex::Key last_key = order_pool.remove(queue, position);
+
+  ladder.order_index.resolve(last_key)->position = position;
+  ladder.order_index.erase(order);
+
+  if (queue.size == 0)
+    removePriceLevel(ladder, side, slot);
+}
+
+COLD void LadderOrderBook::reduceOverflowOrder(Ladder &ladder, OrderIndex::Entry *order, UNUSED const Side side, const uint64_t qty)
+{
+  auto &overflow = ladder.overflow;
+  const uint32_t position = order->position & ~OVERFLOW_FLAG;
+  uint64_t &order_qty = overflow[position].qty;
+
+  order_qty -= std::min(qty, order_qty);
+  if (order_qty > 0)
+    return;
+
+  const uint64_t last_id = overflow.back().id;
+
+  overflow[position] = overflow.back();
+  overflow.pop_back();
+
+  ladder.order_index.find(last_id)->position = OVERFLOW_FLAG | position;
+  ladder.order_index.erase(order);
+}
+
+HOT void LadderOrderBook::removePriceLevel(Ladder &ladder, const Side side, const uint32_t slot)
+{
+  order_pool.release(ladder.queues[slot]);
+  clearSlot(ladder, slot);
+  ladder.levels_count--;
+  HotCounters::increment(counters->removed_levels);
+
+  if (slot == ladder.best_slot)
+    ladder.best_slot = getHighestSlot(ladder);
+
+  //keep the best price of the side inside the window
+  if (ladder.best_slot == 0 && !ladder.overflow.empty()) [[unlikely]]
+  {
+    int64_t best_key = INT64_MIN;
+    for (const auto &order : ladder.overflow)
+      best_key = std::max(best_key, getKey(side, order.price));
+
+    moveWindow(ladder, side, best_key - ANCHOR_OFFSET);
+  }
+}
+
+COLD NEVER_INLINE void LadderOrderBook::moveWindow(Ladder &ladder, const Side side, const int64_t anchor)
+{
+  auto &overflow = ladder.overflow;
+
+  //park every level in the overflow list, then pull back whatever fits in the new window
+  for (uint32_t slot = 1; slot < LADDER_SIZE; ++slot)
+  {
+    OrderQueue &queue = ladder.queues[slot];
+    if (queue.size == 0)
+      continue;
+
+    const OrderIndex::Key *order_keys = order_pool.getKeys(queue);
+
+    for (uint32_t i = 0; i < queue.size; ++i)
+    {
+      OrderIndex::Entry *order = ladder.order_index.resolve(order_keys[i]);
+
+      overflow.push_back({order->id, ladder.prices[slot], order_pool.getQty(queue, i)});
+      order->position = OVERFLOW_FLAG | (overflow.size() - 1);
+    }
+
+    order_pool.release(queue);
+    queue.size = 0;
+    ladder.cumulative_qtys[slot] = 0;
+  }
+
+  ladder.anchor = anchor;
+  ladder.best_slot = 0;
+  ladder.levels_count = 0;
+  ladder.summary = 0;
+  ladder.bitmap.fill(0);
+
+  for (size_t i = overflow.size(); i-- > 0;)
+  {
+    const auto order = overflow[i];
+    const int64_t slot = getKey(side, order.price) - anchor;
+
+    if (slot <= 0 || slot >= LADDER_SIZE)
+      continue;
+
+    insertOrder(ladder, slot, ladder.order_index.find(order.id), order.qty);
+
+    overflow[i] = overflow.back();
+    overflow.pop_back();
+    if (i < overflow.size())
+      ladder.order_index.find(overflow[i].id)->position = OVERFLOW_FLAG | i;
+  }
+}
+
+COLD NEVER_INLINE void LadderOrderBook::rebuild(void)
+{
+  struct Order
+  {
+    uint64_t id;
+    Side side;
+    int32_t price;
+    uint64_t qty;
+  };
+
+  //the tick table changed under resting orders, every key is stale
+  std::vector<Order> orders;
+
+  for (const Side side : {BID, ASK})
+  {
+    Ladder &ladder = ladders[side];
+
+    for (uint32_t slot = 1; slot < LADDER_SIZE; ++slot)
+    {
+      OrderQueue &queue = ladder.queues[slot];
+      if (queue.size == 0)
+        continue;
+
+      const OrderIndex::Key *order_keys = order_pool.getKeys(queue);
+
+      for (uint32_t i = 0; i < queue.size; ++i)
+        orders.push_back({ladder.order_index.resolve(order_keys[i])->id, side, ladder.prices[slot], order_pool.getQty(queue, i)});
+
+      order_pool.release(queue);
+      queue.size = 0;
+      ladder.cumulative_qtys[slot] = 0;
+    }
+
+    for (const auto &order : ladder.overflow)
+      orders.push_back({order.id, side, order.price, order.qty});
+
+    ladder.overflow.clear();
+    ladder.best_slot = 0;
+    ladder.levels_count = 0;
+    ladder.summary = 0;
+    ladder.bitmap.fill(0);
+  }
+
+  for (const auto &order : orders)
+  {
+    OrderIndex &order_index = ladders[order.side].order_index;
+    order_index.erase(order_index.find(order.id));
+  }
+
+  for (const auto &order : orders)
+    addOrder(order.id, order.side, order.price, order.qty);
+}
@@ -0,0 +1,65 @@
+/*================================================================================
+
+File: LatencyHistogram.cpp                                                      
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-17 10:12:48                                                 
+last edited: 2025-06-18 15:02:37                                                
+
+================================================================================*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "LatencyHistogram.hpp"
+#include "macros.hpp"
+
+COLD LatencyHistogram::LatencyHistogram(void) noexcept :
+  counts{},
+  max(0)
+{
+}
+
+COLD LatencyHistogram::~LatencyHistogram()
+{
+}
+
+COLD uint64_t LatencyHistogram::getCount(void) const noexcept
+{
+  uint64_t total = 0;
+  for (const uint64_t &count : counts)
+    total += __atomic_load_n(&count, __ATOMIC_RELAXED);
+
+  return total;
+}
+
+//highest value of the bucket holding the percentile, 0 when empty
+COLD uint64_t LatencyHistogram::getPercentile(const double percentile) const noexcept
+{
+  const uint64_t total = getCount();
+  const uint64_t rank = std::max<uint64_t>(std::ceil(total * percentile / 100.0), 1);
+  uint64_t seen = 0;
+
+  for (uint32_t bucket = 0; bucket < BUCKETS; ++bucket)
+  {
+    seen += __atomic_load_n(&counts[bucket], __ATOMIC_RELAXED);
+    if (seen >= rank)
+      return std::min(getBucketHighest(bucket), getMax());
+  }
+
+  return 0;
+}
+
+COLD uint64_t LatencyHistogram::getMax(void) const noexcept
+{
+  return __atomic_load_n(&max, __ATOMIC_RELAXED);
+}
+
+COLD uint64_t LatencyHistogram::getBucketHighest(const uint32_t bucket) noexcept
+{
+  const uint32_t shift = std::max<uint32_t>(bucket >> LATENCY_SUB_BUCKET_BITS, 1) - 1;
+  const uint64_t lowest = static_cast<uint64_t>(bucket - (shift << LATENCY_SUB_BUCKET_BITS)) << shift;
+
+  return lowest + (1ull << shift) - 1;
+}
@@ -0,0 +1,98 @@
+/*================================================================================
+
+File: LatencyStats.cpp                                                          
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-17 10:12:48                                                 
+last edited: 2025-06-17 10:12:48                                                
+
+================================================================================*/
+
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <x86intrin.h>
+
+#include "LatencyStats.hpp"
+#include "Config.hpp"
+#include "macros.hpp"
+
+COLD LatencyStats::LatencyStats(const bool enabled) :
+  enabled(enabled),
+  ns_per_cycle(0),
+  stages(),
+  thread()
+{
+  if (!enabled)
+    return;
+
+  calibrate();
+  thread = std::jthread([this](std::stop_token stop) { run(stop); });
+}
+
+COLD LatencyStats::~LatencyStats()
+{
+}
+
+COLD void LatencyStats::calibrate(void)
+{
+  const auto start = std::chrono::steady_clock::now();
+  const uint64_t start_tsc = __rdtsc();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(LATENCY_CALIBRATION_MS));
+
+  const uint64_t end_tsc = __rdtsc();
+  const auto end = std::chrono::steady_clock::now();
+
+  ns_per_cycle = std::chrono::duration<double, std::nano>(end - start).count() / (end_tsc - start_tsc);
+}
+
+//SO_TIMESTAMPNS control message of a received datagram
+COLD uint64_t LatencyStats::getKernelTimestamp(const msghdr &msg) noexcept
+{
+  for (const cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(const_cast<msghdr *>(&msg), const_cast<cmsghdr *>(cmsg)))
+  {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_TIMESTAMPNS)
+      continue;
+
+    timespec stamp;
+    std::memcpy(&stamp, CMSG_DATA(cmsg), sizeof(stamp));
+    return stamp.tv_sec * 1'000'000'000ull + stamp.tv_nsec;
+  }
+
+  return 0;
+}
+
+COLD void LatencyStats::dump(FILE *file) const
+{
+  static constexpr const char *names[] = { "exchange to nic", "nic to userspace", "userspace to book" };
+
+  std::fprintf(file, "%-20s %12s %10s %10s %10s %10s %10s\n", "latency (ns)", "count", "p50", "p90", "p99", "p99.9", "max");
+
+  for (uint8_t stage = 0; stage < STAGES_COUNT; ++stage)
+  {
+    const LatencyHistogram &histogram = stages[stage];
+    std::fprintf(file, "%-20s %12lu %10lu %10lu %10lu %10lu %10lu\n", names[stage], histogram.getCount(),
+      histogram.getPercentile(50), histogram.getPercentile(90), histogram.getPercentile(99), histogram.getPercentile(99.9), histogram.getMax());
+  }
+
+  std::fflush(file);
+}
+
+//SIGUSR1 stays pending until this thread takes it
+COLD void LatencyStats::run(std::stop_token stop) const
+{
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGUSR1);
+
+  static constexpr timespec poll_interval = { 0, LATENCY_DUMP_POLL_MS * 1'000'000 };
+
+  while (!stop.stop_requested())
+  {
+    if (sigtimedwait(&signals, nullptr, &poll_interval) == SIGUSR1)
+      dump(stdout);
+  }
+}
@@ -0,0 +1,41 @@
+/*================================================================================
+
+File: LiveQueue.cpp                                                             
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-15 18:05:31                                                 
+last edited: 2025-06-15 18:05:31                                                
+
+================================================================================*/
+
+#include "LiveQueue.hpp"
+#include "Config.hpp"
+#include "macros.hpp"
+
+COLD LiveQueue::LiveQueue(void) :
+  chunks(),
+  size(0)
+{
+  static constexpr size_t reserved_chunks = (LIVE_QUEUE_RESERVE + LIVE_QUEUE_CHUNK_PACKETS - 1) / LIVE_QUEUE_CHUNK_PACKETS;
+
+  chunks.reserve(reserved_chunks);
+  for (size_t i = 0; i < reserved_chunks; ++i)
+    grow();
+}
+
+COLD LiveQueue::~LiveQueue()
+{
+}
+
+COLD NEVER_INLINE void LiveQueue::grow(void)
+{
+  chunks.push_back(std::make_unique_for_overwrite<MoldUDP64Packet[]>(LIVE_QUEUE_CHUNK_PACKETS));
+}
+
+//the queue is only needed until the snapshot is replayed
+COLD void LiveQueue::release(void)
+{
+  std::vector<std::unique_ptr<MoldUDP64Packet[]>>().swap(chunks);
+  size = 0;
+}
@@ -5,13 +5,15 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-03-07 21:17:51                                                 
-last edited: 2025-04-24 12:40:43                                                
+last edited: 2025-06-28 10:36:18                                                
 
 ================================================================================*/
 
+#include <algorithm>
 #include <ranges>
 
 #include "OrderBook.hpp"
+#include "Config.hpp"
 #include "utils/utils.hpp"
 #include "macros.hpp"
 #include "error.hpp"
@@ -19,28 +21,36 @@ last edited: 2025-04-24 12:40:43
 extern volatile bool error;
 
 COLD OrderBook::OrderBook(void) noexcept :
-  equilibrium_price(INT32_MIN),
-  equilibrium_bid_qty(0),
-  equilibrium_ask_qty(0)
+  touch{ { 0, 0 }, SENTINEL_PRICES, INT32_MIN, 0, 0, 0 },
+  hot_sides(),
+  cold_sides(),
+  order_indexes(),
+  order_pool(),
+  counters(&HotCounters::unbound)
 {
-  PriceLevels &bids = book_sides[BID];
-  PriceLevels &asks = book_sides[ASK];
+  for (ColdLevels &cold : cold_sides)
+  {
+    cold.prices.reserve(PRICE_LEVELS_CAPACITY);
+    cold.cumulative_qtys.reserve(PRICE_LEVELS_CAPACITY);
+    cold.queues.reserve(PRICE_LEVELS_CAPACITY);
+  }
 
-  bids.prices.push_back(INT32_MIN);
-  asks.prices.push_back(INT32_MAX);
-  bids.cumulative_qtys.push_back(0);
-  asks.cumulative_qtys.push_back(0);
-  bids.order_ids.emplace_back();
-  asks.order_ids.emplace_back();
-  bids.order_qtys.emplace_back();
-  asks.order_qtys.emplace_back();
+  for (const Side side : { BID, ASK })
+  {
+    ColdLevels &cold = cold_sides[side];
+    cold.prices.push_back(SENTINEL_PRICES[side]);
+    cold.cumulative_qtys.push_back(0);
+    cold.queues.push_back(order_pool.allocate());
+  }
 }
 
 COLD OrderBook::OrderBook(OrderBook &&other) noexcept :
-  book_sides{std::move(other.book_sides)},
-  equilibrium_price(other.equilibrium_price),
-  equilibrium_bid_qty(other.equilibrium_bid_qty),
-  equilibrium_ask_qty(other.equilibrium_ask_qty)
+  touch(other.touch),
+  hot_sides(other.hot_sides),
+  cold_sides{std::move(other.cold_sides)},
+  order_indexes{std::move(other.order_indexes)},
+  order_pool(std::move(other.order_pool)),
+  counters(other.counters)
 {
 }
 
@@ -48,165 +58,497 @@ COLD OrderBook::~OrderBook()
 {
 }
 
-HOT void OrderBook::addOrder(const uint64_t id, const Side side, const int32_t price, const uint64_t qty)
+COLD OrderPool::Stats OrderBook::getPoolStats(void) const noexcept
+{
+  return order_pool.getStats();
+}
+
+COLD void OrderBook::save(CheckpointWriter &writer) const
+{
+  writer.write(touch);
+
+  for (const Side side : { BID, ASK })
+  {
+    const ColdLevels &cold = cold_sides[side];
+
+    writer.write(hot_sides[side]);
+    writer.writeArray(cold.prices);
+    writer.writeArray(cold.cumulative_qtys);
+    writer.writeArray(cold.queues);
+    order_indexes[side].save(writer);
+  }
+
+  order_pool.save(writer);
+}
+
+COLD void OrderBook::load(CheckpointReader &reader)
 {
-  using Handler = void (OrderBook::*)(const uint64_t, const int32_t, const uint64_t);
-  static constexpr Handler handlers[] = {
-    &OrderBook::addOrderBid,
-    &OrderBook::addOrderAsk
-  };
+  reader.read(touch);
+
+  for (const Side side : { BID, ASK })
+  {
+    ColdLevels &cold = cold_sides[side];
+
+    reader.read(hot_sides[side]);
+    reader.readArray(cold.prices);
+    reader.readArray(cold.cumulative_qtys);
+    reader.readArray(cold.queues);
+    order_indexes[side].load(reader);
+  }
 
-  (this->*handlers[side])(id, price, qty);
+  order_pool.load(reader);
+}
+
+//best level first, returns how many of the depth levels the side has
+HOT uint32_t OrderBook::copyTopLevels(const Side side, int32_t *restrict prices, uint64_t *restrict qtys, const uint32_t depth) const noexcept
+{
+  const HotLevels &hot = hot_sides[side];
+  const uint32_t hot_count = std::min(hot.count, depth);
+  const uint32_t hot_first = hot.count - hot_count;
+
+  utils::reverse_copy(std::span<const int32_t>{hot.prices}.subspan(hot_first, hot_count), prices);
+  utils::reverse_copy(std::span<const uint64_t>{hot.cumulative_qtys}.subspan(hot_first, hot_count), qtys);
+
+  //the cold levels are only read past the hot ones
+  const uint32_t cold_count = std::min(hot.cold_count, depth - hot_count);
+  if (cold_count == 0)
+    return hot_count;
+
+  const ColdLevels &cold = cold_sides[side];
+  const size_t cold_first = cold.prices.size() - cold_count;
+
+  utils::reverse_copy(std::span<const int32_t>{cold.prices}.subspan(cold_first, cold_count), prices + hot_count);
+  utils::reverse_copy(std::span<const uint64_t>{cold.cumulative_qtys}.subspan(cold_first, cold_count), qtys + hot_count);
+
+  return hot_count + cold_count;
+}
+
+//qty resting at most distance price units away from the touch, the book does not know tick sizes
+HOT uint64_t OrderBook::getQtyWithin(const Side side, const uint32_t distance) const noexcept
+{
+  const HotLevels &hot = hot_sides[side];
+
+  if (hot.count == 0)
+    return 0;
+
+  const int64_t best_price = hot.prices[hot.count - 1];
+
+  if (side == BID)
+    return getQtyWithin<std::less<int32_t>>(side, std::max<int64_t>(best_price - distance, INT32_MIN));
+  return getQtyWithin<std::greater<int32_t>>(side, std::min<int64_t>(best_price + distance, INT32_MAX));
+}
+
+//sorted best last, the levels within the limit are a suffix that ends at the first price outside it. The cold
+//levels are only searched when every hot one is within
+template<typename Comparator>
+HOT uint64_t OrderBook::getQtyWithin(const Side side, const int32_t limit) const noexcept
+{
+  const HotLevels &hot = hot_sides[side];
+  static constexpr Comparator outside;
+
+  const std::span<const int32_t> hot_prices{hot.prices.data(), hot.count};
+  const std::span<const uint64_t> hot_qtys{hot.cumulative_qtys.data(), hot.count};
+
+  ssize_t outside_idx = utils::backward_lower_bound(hot_prices, limit, outside);
+  if (outside_idx >= 0 || hot.cold_count == 0)
+    return utils::sum(hot_qtys.subspan(outside_idx + 1));
+
+  //without the sentinel
+  const ColdLevels &cold = cold_sides[side];
+  const std::span<const int32_t> cold_prices = std::span<const int32_t>{cold.prices}.subspan(1);
+  const std::span<const uint64_t> cold_qtys = std::span<const uint64_t>{cold.cumulative_qtys}.subspan(1);
+
+  outside_idx = utils::backward_lower_bound(cold_prices, limit, outside);
+  return utils::sum(hot_qtys) + utils::sum(cold_qtys.subspan(outside_idx + 1));
+}
+
+//average price paid taking qty from the side, best levels first
+HOT OrderBook::Sweep OrderBook::getSweep(const Side side, const uint64_t qty) const noexcept
+{
+  const HotLevels &hot = hot_sides[side];
+
+  double notional;
+  uint64_t filled_qty = utils::backward_sweep({hot.prices.data(), hot.count}, {hot.cumulative_qtys.data(), hot.count}, qty, notional);
+
+  //the cold levels only when the hot ones are not enough, without the sentinel
+  if (filled_qty < qty && hot.cold_count != 0)
+  {
+    const ColdLevels &cold = cold_sides[side];
+    const std::span<const int32_t> prices = std::span<const int32_t>{cold.prices}.subspan(1);
+    const std::span<const uint64_t> qtys = std::span<const uint64_t>{cold.cumulative_qtys}.subspan(1);
+
+    double cold_notional;
+    filled_qty += utils::backward_sweep(prices, qtys, qty - filled_qty, cold_notional);
+    notional += cold_notional;
+  }
+
+  return { filled_qty, (filled_qty != 0) ? notional / filled_qty : 0.0 };
+}
+
+//price and remaining qty of a resting order, false if the side has no such order
+HOT bool OrderBook::findOrder(const uint64_t id, const Side side, int32_t &price, uint64_t &qty) noexcept
+{
+  const OrderIndex::Entry *order = order_indexes[side].find(id);
+  if (order == nullptr)
+    return false;
+
+  price = order->price;
+  qty = order_pool.getQty(getQueue(side, order->price), order->position);
+
+  return true;
+}
+
+//0 when the side has no level at the price
+HOT uint64_t OrderBook::getLevelQty(const Side side, const int32_t price) const noexcept
+{
+  const HotLevels &hot = hot_sides[side];
+
+  for (uint32_t i = hot.count; i-- > 0;)
+    if (hot.prices[i] == price)
+      return hot.cumulative_qtys[i];
+
+  const ColdLevels &cold = cold_sides[side];
+  const size_t price_idx = findPriceLevel(side, price);
+
+  const bool found = (price_idx < cold.prices.size()) && (cold.prices[price_idx] == price);
+  return found ? cold.cumulative_qtys[price_idx] : 0;
+}
+
+//direct branches on the side, both sides inline into the caller
+HOT void OrderBook::addOrder(const uint64_t id, const Side side, const int32_t price, const uint64_t qty)
+{
+  if (side == BID)
+    return addOrderBid(id, price, qty);
+  addOrderAsk(id, price, qty);
 }
 
 HOT void OrderBook::removeOrder(const uint64_t id, const Side side)
 {
-  PriceLevels &levels = book_sides[side];
+  if (side == BID)
+    return removeOrderBid(id);
+  removeOrderAsk(id);
+}
 
-  for (auto order_ids_it = levels.order_ids.rbegin(); order_ids_it != levels.order_ids.rend(); ++order_ids_it)
+HOT void OrderBook::executeOrder(const uint64_t id, const Side side, const uint64_t qty)
+{
+  if (side == BID)
+    return executeOrderBid(id, qty);
+  executeOrderAsk(id, qty);
+}
+
+//snapshot load: the orders are sorted worst price first and each level is appended once, instead of a search
+//and a mid vector insert per order. A side that already has levels falls back to adding order by order
+COLD void OrderBook::bulkLoad(std::span<BulkOrder> orders)
+{
+  //stable, orders keep their arrival order within a level
+  std::ranges::stable_sort(orders, [](const BulkOrder &a, const BulkOrder &b) noexcept
   {
-    auto &order_ids = *order_ids_it;
+    if (a.side != b.side)
+      return a.side < b.side;
+    return (a.side == BID) ? (a.price < b.price) : (a.price > b.price);
+  });
+
+  const std::array<bool, 2> empty_sides = { hot_sides[BID].count == 0, hot_sides[ASK].count == 0 };
+  uint64_t new_levels = 0;
+  uint64_t appended = 0;
 
-    static constexpr std::equal_to<uint64_t> order_ids_cmp;
-    const ssize_t order_idx = utils::forward_lower_bound(std::span<const uint64_t>{order_ids}, id, order_ids_cmp);
-    if (order_idx == -1) [[likely]]
+  //empty sides are built in the cold levels, their best ones move to the hot block after
+  for (const BulkOrder &order : orders)
+  {
+    if (!empty_sides[order.side]) [[unlikely]]
+    {
+      addOrder(order.id, order.side, order.price, order.qty);
       continue;
+    }
+
+    ColdLevels &cold = cold_sides[order.side];
 
-    const size_t price_idx = std::distance(levels.order_ids.begin(), order_ids_it.base()) - 1;
+    if (cold.prices.back() != order.price)
+    {
+      cold.prices.push_back(order.price);
+      cold.cumulative_qtys.push_back(0);
+      cold.queues.push_back(order_pool.allocate());
+      new_levels++;
+    }
 
-    auto &cumulative_qty = levels.cumulative_qtys[price_idx];
-    auto &order_qtys = levels.order_qtys[price_idx];
+    cold.cumulative_qtys.back() += order.qty;
+    pushOrder(cold.queues.back(), order.side, order.id, order.price, order.qty);
+    appended++;
+  }
 
-    const uint64_t qty = order_qtys[order_idx];
+  for (const Side side : { BID, ASK })
+  {
+    HotLevels &hot = hot_sides[side];
 
-    cumulative_qty -= qty;
-    if (cumulative_qty > 0) [[likely]]
+    if (empty_sides[side])
     {
-      order_ids[order_idx] = order_ids.back();
-      order_qtys[order_idx] = order_qtys.back();
-      order_ids.pop_back();
-      order_qtys.pop_back();
+      hot.cold_count = cold_sides[side].prices.size() - 1;
+      refillHotLevels(side);
+      refreshTouch(side);
     }
-    else
-      removePriceLevel(levels, price_idx, 0);
+
+    HotCounters::raise(counters->max_depth[side], hot.count + hot.cold_count);
   }
+
+  HotCounters::increment(counters->new_levels, new_levels);
+  HotCounters::increment(counters->existing_levels, appended - new_levels);
 }
 
-HOT void OrderBook::removeOrder(const uint64_t id, const Side side, const int32_t price, const uint64_t qty)
+//a price worse than every hot level is cold, unless the hot block has room and nothing is behind it
+template<typename Comparator>
+HOT void OrderBook::addOrder(const Side side, const uint64_t id, const int32_t price, const uint64_t qty)
 {
-  using Handler = void (OrderBook::*)(const uint64_t, const int32_t, const uint64_t);
-  static constexpr Handler handlers[] = {
-    &OrderBook::removeOrderBid,
-    &OrderBook::removeOrderAsk
-  };
+  const HotLevels &hot = hot_sides[side];
+  static constexpr Comparator cmp;
 
-  (this->*handlers[side])(id, price, qty);
+  const bool worse_than_hot = (hot.count != 0) && !cmp(hot.prices[0], price);
+
+  if (worse_than_hot && (hot.cold_count != 0 || hot.count == HOT_LEVELS)) [[unlikely]]
+    return addColdOrder<Comparator>(side, id, price, qty);
+  addHotOrder<Comparator>(side, id, price, qty);
 }
 
-HOT void OrderBook::executeOrder(const uint64_t id, const Side side, const uint64_t qty)
+template<typename Comparator>
+HOT void OrderBook::addHotOrder(const Side side, const uint64_t id, const int32_t price, const uint64_t qty)
 {
-  PriceLevels &levels = book_sides[side];
-  const size_t price_idx = levels.prices.size() - 1;
+  HotLevels &hot = hot_sides[side];
+
+  static constexpr Comparator cmp;
+  const ssize_t price_idx = utils::backward_lower_bound(std::span<const int32_t>{hot.prices.data(), hot.count}, price, cmp);
+
+  if (price_idx >= 0 && hot.prices[price_idx] == price)
+  {
+    HotCounters::increment(counters->existing_levels);
 
-  auto &cumulative_qty = levels.cumulative_qtys.back();
-  cumulative_qty -= qty;
+    hot.cumulative_qtys[price_idx] += qty;
+    pushOrder(hot.queues[price_idx], side, id, price, qty);
+
+    return refreshTouch(side);
+  }
+
+  //a full block makes room first, the price can then be worse than all of what is left
+  if (hot.count == HOT_LEVELS) [[unlikely]]
+  {
+    spillHotLevels(side);
+    return addOrder<Comparator>(side, id, price, qty);
+  }
 
-  using Handler = void (OrderBook::*)(PriceLevels &, const size_t, const uint64_t);
-  static constexpr Handler handlers[] = {
-    &OrderBook::removeOrderFromPriceLevel,
-    &OrderBook::removePriceLevel
-  };
+  const uint32_t new_price_idx = price_idx + 1;
 
-  const uint8_t idx = (cumulative_qty == 0);
-  (this->*handlers[idx])(levels, price_idx, id);
+  OrderQueue queue = order_pool.allocate();
+  pushOrder(queue, side, id, price, qty);
+
+  std::copy_backward(hot.prices.cbegin() + new_price_idx, hot.prices.cbegin() + hot.count, hot.prices.begin() + hot.count + 1);
+  std::copy_backward(hot.cumulative_qtys.cbegin() + new_price_idx, hot.cumulative_qtys.cbegin() + hot.count, hot.cumulative_qtys.begin() + hot.count + 1);
+  std::copy_backward(hot.queues.cbegin() + new_price_idx, hot.queues.cbegin() + hot.count, hot.queues.begin() + hot.count + 1);
+
+  hot.prices[new_price_idx] = price;
+  hot.cumulative_qtys[new_price_idx] = qty;
+  hot.queues[new_price_idx] = queue;
+  hot.count++;
+
+  HotCounters::increment(counters->new_levels);
+  HotCounters::raise(counters->max_depth[side], hot.count + hot.cold_count);
+
+  refreshTouch(side);
 }
 
 template<typename Comparator>
-HOT void OrderBook::addOrder(PriceLevels &levels, const uint64_t id, const int32_t price, const uint64_t qty)
+HOT void OrderBook::addColdOrder(const Side side, const uint64_t id, const int32_t price, const uint64_t qty)
 {
-  const auto &prices = levels.prices;
+  HotLevels &hot = hot_sides[side];
+  ColdLevels &cold = cold_sides[side];
 
   static constexpr Comparator cmp;
-  const size_t price_idx = utils::backward_lower_bound(std::span<const int32_t>{prices}, price, cmp);
+  const size_t price_idx = utils::backward_lower_bound(std::span<const int32_t>{cold.prices}, price, cmp);
 
-  using Handler = void (OrderBook::*)(PriceLevels &, const size_t, const int32_t, const uint64_t, const uint64_t);
-  static constexpr Handler handlers[] = {
-    &OrderBook::addOrderToExistingPriceLevel,
-    &OrderBook::addOrderToNewPriceLevel
-  };
+  touch.stamp++;
 
-  const uint8_t handler_idx = (prices[price_idx] != price);
-  (this->*handlers[handler_idx])(levels, price_idx, price, id, qty);
-}
+  if (cold.prices[price_idx] == price)
+  {
+    HotCounters::increment(counters->existing_levels);
 
-HOT void OrderBook::addOrderToExistingPriceLevel(PriceLevels &levels, const size_t price_idx, UNUSED const int32_t price, const uint64_t id, const uint64_t qty)
-{
-  auto &cumulative_qtys = levels.cumulative_qtys;
-  auto &order_ids = levels.order_ids;
-  auto &order_qtys = levels.order_qtys;
+    cold.cumulative_qtys[price_idx] += qty;
+    pushOrder(cold.queues[price_idx], side, id, price, qty);
 
-  cumulative_qtys[price_idx] += qty;
-  order_ids[price_idx].push_back(id);
-  order_qtys[price_idx].push_back(qty);
+    return;
+  }
+
+  const size_t new_price_idx = price_idx + 1;
+
+  OrderQueue queue = order_pool.allocate();
+  pushOrder(queue, side, id, price, qty);
+
+  cold.prices.insert(cold.prices.cbegin() + new_price_idx, price);
+  cold.cumulative_qtys.insert(cold.cumulative_qtys.cbegin() + new_price_idx, qty);
+  cold.queues.insert(cold.queues.cbegin() + new_price_idx, queue);
+  hot.cold_count++;
+
+  HotCounters::increment(counters->new_levels);
+  HotCounters::raise(counters->max_depth[side], hot.count + hot.cold_count);
 }
 
-HOT void OrderBook::addOrderToNewPriceLevel(PriceLevels &levels, const size_t price_idx, const int32_t price, const uint64_t id, const uint64_t qty)
+//an order is only cold when its price is worse than every hot level
+template<typename Comparator>
+HOT void OrderBook::executeOrder(const Side side, const uint64_t id, const uint64_t qty)
 {
-  auto &prices = levels.prices;
-  auto &cumulative_qtys = levels.cumulative_qtys;
-  auto &order_ids = levels.order_ids;
-  auto &order_qtys = levels.order_qtys;
+  OrderIndex::Entry *order = order_indexes[side].find(id);
+  if (order == nullptr) [[unlikely]]
+    return;
 
-  const size_t new_price_idx = price_idx + 1;
+  HotLevels &hot = hot_sides[side];
+  const int32_t price = order->price;
 
-  prices.insert(prices.cbegin() + new_price_idx, price);
-  cumulative_qtys.insert(cumulative_qtys.cbegin() + new_price_idx, qty);
-  order_ids.emplace(order_ids.cbegin() + new_price_idx, std::vector<uint64_t>{id});
-  order_qtys.emplace(order_qtys.cbegin() + new_price_idx, std::vector<uint64_t>{qty});
+  static constexpr Comparator worse;
+  if (!worse(price, hot.prices[0])) [[likely]]
+  {
+    uint32_t price_idx = hot.count - 1;
+    while (hot.prices[price_idx] != price)
+      --price_idx;
+
+    if (reduceOrder(hot.cumulative_qtys[price_idx], hot.queues[price_idx], side, order, qty))
+      removeHotLevel(side, price_idx);
+
+    return refreshTouch(side);
+  }
+
+  ColdLevels &cold = cold_sides[side];
+  const size_t price_idx = findPriceLevel<Comparator>(cold, price);
+
+  if (reduceOrder(cold.cumulative_qtys[price_idx], cold.queues[price_idx], side, order, qty))
+    removeColdLevel(side, price_idx);
+
+  touch.stamp++;
 }
 
 template<typename Comparator>
-HOT void OrderBook::removeOrder(PriceLevels &levels, const uint64_t id, const int32_t price, const uint64_t qty)
+HOT inline size_t OrderBook::findPriceLevel(const ColdLevels &cold, const int32_t price) const noexcept
 {
   static constexpr Comparator prices_cmp;
-  const size_t price_idx = utils::backward_lower_bound(std::span<const int32_t>{levels.prices}, price, prices_cmp);
+  return utils::binary_lower_bound(std::span<const int32_t>{cold.prices}, price, prices_cmp);
+}
+
+//in the cold levels
+HOT size_t OrderBook::findPriceLevel(const Side side, const int32_t price) const noexcept
+{
+  const ColdLevels &cold = cold_sides[side];
+
+  if (side == BID)
+    return findPriceLevel<std::less<int32_t>>(cold, price);
+  return findPriceLevel<std::greater<int32_t>>(cold, price);
+}
+
+//the queue of a level the side has
+HOT const OrderQueue &OrderBook::getQueue(const Side side, const int32_t price) const noexcept
+{
+  const HotLevels &hot = hot_sides[side];
+
+  for (uint32_t i = hot.count; i-- > 0;)
+    if (hot.prices[i] == price)
+      return hot.queues[i];
+
+  return cold_sides[side].queues[findPriceLevel(side, price)];
+}
+
+//true when the level is left empty, its queue is released and the caller removes the level
+HOT bool OrderBook::reduceOrder(uint64_t &cumulative_qty, OrderQueue &queue, const Side side, OrderIndex::Entry *order, const uint64_t qty)
+{
+  const uint64_t order_qty = order_pool.getQty(queue, order->position);
+  const uint64_t executed_qty = std::min(qty, order_qty);
+
+  order_pool.setQty(queue, order->position, order_qty - executed_qty);
+  cumulative_qty -= executed_qty;
+
+  //the level only empties with its last order, partial executions keep the order
+  if (cumulative_qty == 0)
+  {
+    order_pool.release(queue);
+    order_indexes[side].erase(order);
+    return true;
+  }
 
-  auto &cumulative_qty = levels.cumulative_qtys[price_idx];
-  cumulative_qty -= qty;
+  if (order_qty == executed_qty)
+    removeOrderFromPriceLevel(queue, side, order);
+  return false;
+}
+
+HOT void OrderBook::removeOrderFromPriceLevel(OrderQueue &queue, const Side side, OrderIndex::Entry *order)
+{
+  //the last order of the queue takes the place of the removed one
+  const uint32_t order_idx = order->position;
+  const OrderIndex::Key last_key = order_pool.remove(queue, order_idx);
+
+  OrderIndex &order_index = order_indexes[side];
+  order_index.resolve(last_key)->position = order_idx;
+  order_index.erase(order);
+}
 
-  using Handler = void (OrderBook::*)(PriceLevels &, const size_t, const uint64_t);
-  static constexpr Handler handlers[] = {
-    &OrderBook::removeOrderFromPriceLevel,
-    &OrderBook::removePriceLevel
-  };
+HOT void OrderBook::removeHotLevel(const Side side, const uint32_t price_idx)
+{
+  HotLevels &hot = hot_sides[side];
+
+  std::copy(hot.prices.cbegin() + price_idx + 1, hot.prices.cbegin() + hot.count, hot.prices.begin() + price_idx);
+  std::copy(hot.cumulative_qtys.cbegin() + price_idx + 1, hot.cumulative_qtys.cbegin() + hot.count, hot.cumulative_qtys.begin() + price_idx);
+  std::copy(hot.queues.cbegin() + price_idx + 1, hot.queues.cbegin() + hot.count, hot.queues.begin() + price_idx);
+  hot.count--;
+
+  HotCounters::increment(counters->removed_levels);
 
-  const uint8_t idx = (cumulative_qty == 0);
-  (this->*handlers[idx])(levels, price_idx, id);
+  if (hot.count < HOT_REFILL && hot.cold_count != 0) [[unlikely]]
+    refillHotLevels(side);
 }
 
-HOT void OrderBook::removeOrderFromPriceLevel(PriceLevels &levels, const size_t price_idx, const uint64_t id)
+HOT void OrderBook::removeColdLevel(const Side side, const size_t price_idx)
 {
-  auto &order_ids = levels.order_ids[price_idx];
-  auto &order_qtys = levels.order_qtys[price_idx];
+  ColdLevels &cold = cold_sides[side];
 
-  static constexpr std::equal_to<uint64_t> order_ids_cmp;
-  const ssize_t order_idx = utils::forward_lower_bound(std::span<const uint64_t>{order_ids}, id, order_ids_cmp);
+  cold.prices.erase(cold.prices.cbegin() + price_idx);
+  cold.cumulative_qtys.erase(cold.cumulative_qtys.cbegin() + price_idx);
+  cold.queues.erase(cold.queues.cbegin() + price_idx);
+  hot_sides[side].cold_count--;
 
-  order_ids[order_idx] = order_ids.back();
-  order_qtys[order_idx] = order_qtys.back();
-  order_ids.pop_back();
-  order_qtys.pop_back();
+  HotCounters::increment(counters->removed_levels);
 }
 
-HOT void OrderBook::removePriceLevel(PriceLevels &levels, const size_t price_idx, UNUSED const uint64_t id)
+//the worse HOT_SPILL levels of a full block are still better than every cold level, they are appended
+NEVER_INLINE void OrderBook::spillHotLevels(const Side side)
 {
-  auto &prices = levels.prices;
-  auto &cumulative_qtys = levels.cumulative_qtys;
-  auto &order_ids = levels.order_ids;
-  auto &order_qtys = levels.order_qtys;
+  HotLevels &hot = hot_sides[side];
+  ColdLevels &cold = cold_sides[side];
+
+  cold.prices.insert(cold.prices.cend(), hot.prices.cbegin(), hot.prices.cbegin() + HOT_SPILL);
+  cold.cumulative_qtys.insert(cold.cumulative_qtys.cend(), hot.cumulative_qtys.cbegin(), hot.cumulative_qtys.cbegin() + HOT_SPILL);
+  cold.queues.insert(cold.queues.cend(), hot.queues.cbegin(), hot.queues.cbegin() + HOT_SPILL);
+
+  std::copy(hot.prices.cbegin() + HOT_SPILL, hot.prices.cbegin() + hot.count, hot.prices.begin());
+  std::copy(hot.cumulative_qtys.cbegin() + HOT_SPILL, hot.cumulative_qtys.cbegin() + hot.count, hot.cumulative_qtys.begin());
+  std::copy(hot.queues.cbegin() + HOT_SPILL, hot.queues.cbegin() + hot.count, hot.queues.begin());
 
-  prices.erase(prices.cbegin() + price_idx);
-  cumulative_qtys.erase(cumulative_qtys.cbegin() + price_idx);
-  order_ids.erase(order_ids.cbegin() + price_idx);
-  order_qtys.erase(order_qtys.cbegin() + price_idx);
-}
\ No newline at end of file
+  hot.count -= HOT_SPILL;
+  hot.cold_count += HOT_SPILL;
+}
+
+//the best cold levels go under the hot ones, up to half a block
+NEVER_INLINE void OrderBook::refillHotLevels(const Side side)
+{
+  HotLevels &hot = hot_sides[side];
+  ColdLevels &cold = cold_sides[side];
+
+  const uint32_t moved = std::min(hot.cold_count, HOT_SPILL - hot.count);
+  const size_t first_idx = cold.prices.size() - moved;
+
+  std::copy_backward(hot.prices.cbegin(), hot.prices.cbegin() + hot.count, hot.prices.begin() + hot.count + moved);
+  std::copy_backward(hot.cumulative_qtys.cbegin(), hot.cumulative_qtys.cbegin() + hot.count, hot.cumulative_qtys.begin() + hot.count + moved);
+  std::copy_backward(hot.queues.cbegin(), hot.queues.cbegin() + hot.count, hot.queues.begin() + hot.count + moved);
+
+  std::copy(cold.prices.cbegin() + first_idx, cold.prices.cend(), hot.prices.begin());
+  std::copy(cold.cumulative_qtys.cbegin() + first_idx, cold.cumulative_qtys.cend(), hot.cumulative_qtys.begin());
+  std::copy(cold.queues.cbegin() + first_idx, cold.queues.cend(), hot.queues.begin());
+
+  cold.prices.resize(first_idx);
+  cold.cumulative_qtys.resize(first_idx);
+  cold.queues.resize(first_idx);
+
+  hot.count += moved;
+  hot.cold_count -= moved;
+}
@@ -0,0 +1,149 @@
+/*================================================================================
+
+File: OrderIndex.cpp                                                            
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-05 18:12:40                                                 
+last edited: 2025-06-29 14:40:52                                                
+
+================================================================================*/
+
+#include <bit>
+
+#include "OrderIndex.hpp"
+#include "Config.hpp"
+#include "macros.hpp"
+#include "error.hpp"
+
+#ifdef COMPACT_ORDERS
+
+COLD OrderIndex::OrderIndex(void) noexcept :
+  slots(ORDER_INDEX_CAPACITY, EMPTY_SLOT),
+  entries(),
+  free_handle(EMPTY_SLOT),
+  mask(ORDER_INDEX_CAPACITY - 1),
+  shift(64 - std::countr_zero<size_t>(ORDER_INDEX_CAPACITY)),
+  size(0)
+{
+  static_assert(std::has_single_bit<size_t>(ORDER_INDEX_CAPACITY), "ORDER_INDEX_CAPACITY must be a power of 2");
+  entries.reserve(ORDER_INDEX_CAPACITY / 4 * 3);
+}
+
+COLD OrderIndex::OrderIndex(OrderIndex &&other) noexcept :
+  slots(std::move(other.slots)),
+  entries(std::move(other.entries)),
+  free_handle(other.free_handle),
+  mask(other.mask),
+  shift(other.shift),
+  size(other.size)
+{
+}
+
+#else
+
+COLD OrderIndex::OrderIndex(void) noexcept :
+  entries(ORDER_INDEX_CAPACITY),
+  mask(ORDER_INDEX_CAPACITY - 1),
+  shift(64 - std::countr_zero<size_t>(ORDER_INDEX_CAPACITY)),
+  size(0)
+{
+  static_assert(std::has_single_bit<size_t>(ORDER_INDEX_CAPACITY), "ORDER_INDEX_CAPACITY must be a power of 2");
+}
+
+COLD OrderIndex::OrderIndex(OrderIndex &&other) noexcept :
+  entries(std::move(other.entries)),
+  mask(other.mask),
+  shift(other.shift),
+  size(other.size)
+{
+}
+
+#endif
+
+COLD OrderIndex::~OrderIndex()
+{
+}
+
+#ifdef COMPACT_ORDERS
+
+//handles are what the order queues store, the entries keep theirs across a checkpoint
+COLD void OrderIndex::save(CheckpointWriter &writer) const
+{
+  writer.writeArray(slots);
+  writer.writeArray(entries);
+  writer.write(free_handle);
+  writer.write(size);
+}
+
+COLD void OrderIndex::load(CheckpointReader &reader)
+{
+  reader.readArray(slots);
+  reader.readArray(entries);
+  reader.read(free_handle);
+  reader.read(size);
+
+  mask = slots.size() - 1;
+  shift = 64 - std::countr_zero(slots.size());
+  entries.reserve(slots.size() / 4 * 3);
+}
+
+//only the slots are rebuilt, handles stay where they are. Past 2^24 slots a side of a book would run out of handles
+COLD NEVER_INLINE void OrderIndex::grow(void)
+{
+  error |= (slots.size() * 2 / 4 * 3 >= HANDLE_MASK);
+  CHECK_ERROR;
+
+  slots.assign(slots.size() * 2, EMPTY_SLOT);
+  entries.reserve(slots.size() / 4 * 3);
+
+  mask = slots.size() - 1;
+  shift--;
+
+  for (uint32_t handle = 0; handle < entries.size(); ++handle)
+  {
+    if (entries[handle].id == 0)
+      continue;
+
+    size_t slot = getSlot(entries[handle].id);
+    while (slots[slot] != EMPTY_SLOT)
+      slot = (slot + 1) & mask;
+    slots[slot] = getTag(entries[handle].id) | handle;
+  }
+}
+
+#else
+
+COLD void OrderIndex::save(CheckpointWriter &writer) const
+{
+  writer.writeArray(entries);
+  writer.write(size);
+}
+
+COLD void OrderIndex::load(CheckpointReader &reader)
+{
+  reader.readArray(entries);
+  reader.read(size);
+
+  mask = entries.size() - 1;
+  shift = 64 - std::countr_zero(entries.size());
+}
+
+//positions move with the entries, the level queues only hold ids
+COLD NEVER_INLINE void OrderIndex::grow(void)
+{
+  std::vector<Entry> old_entries(entries.size() * 2);
+  old_entries.swap(entries);
+
+  mask = entries.size() - 1;
+  shift--;
+  size = 0;
+
+  for (const Entry &entry : old_entries)
+  {
+    if (entry.id != 0)
+      insert(entry.id, entry.price)->position = entry.position;
+  }
+}
+
+#endif
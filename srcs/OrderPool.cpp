@@ -0,0 +1,144 @@
+/*================================================================================
+
+File: OrderPool.cpp                                                             
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-12 09:34:18                                                 
+last edited: 2025-06-28 10:36:18                                                
+
+================================================================================*/
+
+#include <algorithm>
+
+#include "OrderPool.hpp"
+#include "Config.hpp"
+#include "macros.hpp"
+
+COLD OrderPool::OrderPool(void) noexcept :
+  keys(ORDER_POOL_CAPACITY),
+  qtys(ORDER_POOL_CAPACITY),
+#ifdef COMPACT_ORDERS
+  large_qtys(),
+  free_large_qtys(),
+#endif
+  top(0),
+  allocated(0),
+  orders(0),
+  grows(0)
+{
+  free_lists.fill(FREE_LIST_END);
+}
+
+COLD OrderPool::OrderPool(OrderPool &&other) noexcept :
+  keys(std::move(other.keys)),
+  qtys(std::move(other.qtys)),
+#ifdef COMPACT_ORDERS
+  large_qtys(std::move(other.large_qtys)),
+  free_large_qtys(std::move(other.free_large_qtys)),
+#endif
+  free_lists(other.free_lists),
+  top(other.top),
+  allocated(other.allocated),
+  orders(other.orders),
+  grows(other.grows)
+{
+}
+
+COLD OrderPool::~OrderPool()
+{
+}
+
+COLD OrderPool::Stats OrderPool::getStats(void) const noexcept
+{
+  return { keys.size(), top, allocated, orders, grows };
+}
+
+//only the slots carved out so far hold anything
+COLD void OrderPool::save(CheckpointWriter &writer) const
+{
+  writer.write<uint64_t>(keys.size());
+  writer.write(top);
+  writer.writeArray(keys.data(), top);
+  writer.writeArray(qtys.data(), top);
+#ifdef COMPACT_ORDERS
+  writer.writeArray(large_qtys);
+  writer.writeArray(free_large_qtys);
+#endif
+  writer.write(free_lists);
+  writer.write(allocated);
+  writer.write(orders);
+  writer.write(grows);
+}
+
+COLD void OrderPool::load(CheckpointReader &reader)
+{
+  uint64_t capacity;
+  reader.read(capacity);
+  reader.read(top);
+
+  keys.resize(capacity);
+  qtys.resize(capacity);
+  reader.readArray(keys.data(), top);
+  reader.readArray(qtys.data(), top);
+#ifdef COMPACT_ORDERS
+  reader.readArray(large_qtys);
+  reader.readArray(free_large_qtys);
+#endif
+  reader.read(free_lists);
+  reader.read(allocated);
+  reader.read(orders);
+  reader.read(grows);
+}
+
+COLD NEVER_INLINE void OrderPool::grow(const uint32_t min_capacity)
+{
+  const size_t capacity = std::max<size_t>(keys.size() * 2, min_capacity);
+
+  keys.resize(capacity);
+  qtys.resize(capacity);
+  grows++;
+}
+
+#ifdef COMPACT_ORDERS
+
+//the new stored value of a slot, a quantity that fits again frees its entry
+COLD NEVER_INLINE OrderPool::Qty OrderPool::setLargeQty(const Qty stored, const uint64_t qty)
+{
+  if (stored & QTY_ESCAPE)
+  {
+    const uint32_t idx = stored & ~QTY_ESCAPE;
+
+    if (qty >= QTY_ESCAPE)
+    {
+      large_qtys[idx] = qty;
+      return stored;
+    }
+
+    free_large_qtys.push_back(idx);
+    return qty;
+  }
+
+  if (free_large_qtys.empty())
+  {
+    large_qtys.push_back(qty);
+    return QTY_ESCAPE | (large_qtys.size() - 1);
+  }
+
+  const uint32_t idx = free_large_qtys.back();
+  free_large_qtys.pop_back();
+  large_qtys[idx] = qty;
+  return QTY_ESCAPE | idx;
+}
+
+COLD NEVER_INLINE void OrderPool::dropLargeQtys(const OrderQueue &queue)
+{
+  for (uint32_t i = 0; i < queue.size; ++i)
+  {
+    const Qty stored = qtys[queue.offset + i];
+    if (stored & QTY_ESCAPE)
+      free_large_qtys.push_back(stored & ~QTY_ESCAPE);
+  }
+}
+
+#endif
@@ -0,0 +1,117 @@
+/*================================================================================
+
+File: PacketRing.cpp                                                            
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-08 16:42:13                                                 
+last edited: 2025-06-16 11:26:40                                                
+
+================================================================================*/
+
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "PacketRing.hpp"
+#include "error.hpp"
+#include "macros.hpp"
+
+static_assert((PACKET_RING_BLOCK_SIZE % PACKET_RING_FRAME_SIZE) == 0, "PACKET_RING_BLOCK_SIZE must hold whole frames");
+static_assert(PACKET_RING_FRAME_SIZE >= TPACKET3_HDRLEN + MTU, "PACKET_RING_FRAME_SIZE must fit a full datagram");
+
+//nothing is set up until open
+COLD PacketRing::PacketRing(const std::string &interface, const sockaddr_in &group_address) noexcept :
+  interface(interface),
+  group_address(group_address),
+  sock_fd(-1),
+  ring(nullptr),
+  block_index(0) {}
+
+COLD PacketRing::~PacketRing()
+{
+  if (ring != nullptr)
+    munmap(ring, RING_SIZE);
+  if (sock_fd != -1)
+    close(sock_fd);
+}
+
+//the socket only starts capturing once bound, after the filter is in place
+COLD void PacketRing::open(void)
+{
+  sock_fd = socket(AF_PACKET, SOCK_DGRAM, 0);
+  error |= sock_fd == -1;
+  CHECK_ERROR;
+
+  attachFilter();
+  setupRing();
+  bindInterface();
+}
+
+//SOCK_DGRAM offsets start at the ip header: destination is the group, udp, not a fragment (neither offset nor MF), destination port
+COLD void PacketRing::attachFilter(void) const
+{
+  const uint32_t group = ntohl(group_address.sin_addr.s_addr);
+  const uint32_t port = ntohs(group_address.sin_port);
+
+  sock_filter code[] = {
+    BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 16),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, group, 0, 8),
+    BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 6),
+    BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6),
+    BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x3fff, 4, 0),
+    BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),
+    BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, port, 0, 1),
+    BPF_STMT(BPF_RET | BPF_K, UINT32_MAX),
+    BPF_STMT(BPF_RET | BPF_K, 0)
+  };
+
+  const sock_fprog program = { sizeof(code) / sizeof(code[0]), code };
+
+  error |= setsockopt(sock_fd, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program)) == -1;
+  CHECK_ERROR;
+}
+
+COLD void PacketRing::setupRing(void)
+{
+  constexpr int version = TPACKET_V3;
+  constexpr int enable = 1;
+
+  tpacket_req3 request{};
+  request.tp_block_size = PACKET_RING_BLOCK_SIZE;
+  request.tp_block_nr = PACKET_RING_BLOCKS_COUNT;
+  request.tp_frame_size = PACKET_RING_FRAME_SIZE;
+  request.tp_frame_nr = RING_SIZE / PACKET_RING_FRAME_SIZE;
+  request.tp_retire_blk_tov = PACKET_RING_BLOCK_TIMEOUT_MS;
+
+  error |= setsockopt(sock_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) == -1;
+  //the sender's own copy on loopback
+  error |= setsockopt(sock_fd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &enable, sizeof(enable)) == -1;
+  error |= setsockopt(sock_fd, SOL_PACKET, PACKET_RX_RING, &request, sizeof(request)) == -1;
+  CHECK_ERROR;
+
+  void *const address = mmap(nullptr, RING_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, sock_fd, 0);
+  error |= address == MAP_FAILED;
+  CHECK_ERROR;
+
+  ring = static_cast<char *>(address);
+}
+
+COLD void PacketRing::bindInterface(void) const
+{
+  sockaddr_ll address{};
+  address.sll_family = AF_PACKET;
+  address.sll_protocol = htons(ETH_P_IP);
+  address.sll_ifindex = if_nametoindex(interface.c_str());
+
+  error |= address.sll_ifindex == 0;
+  error |= bind(sock_fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == -1;
+  CHECK_ERROR;
+}
@@ -0,0 +1,613 @@
+/*================================================================================
+
+File: Replayer.cpp                                                              
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-14 20:05:33                                                 
+last edited: 2025-06-22 10:41:05                                                
+
+================================================================================*/
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <immintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_set>
+
+#include "Replayer.hpp"
+#include "macros.hpp"
+#include "error.hpp"
+
+COLD Replayer::Replayer(const std::string_view path, const Options &options) noexcept :
+  capture(nullptr),
+  capture_size(0),
+  port(options.port),
+  workers_count(options.workers_count),
+  drop_every(options.drop_every),
+  checkpoint_path(options.checkpoint),
+  book_ids(options.book_ids),
+  recovery(nullptr),
+  counters{}
+{
+  const int fd = open(std::string(path).c_str(), O_RDONLY);
+  error |= fd == -1;
+  CHECK_ERROR;
+
+  struct stat st{};
+  error |= fstat(fd, &st) == -1;
+  CHECK_ERROR;
+
+  capture_size = st.st_size;
+  void *mapping = mmap(nullptr, capture_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+  error |= mapping == MAP_FAILED;
+  close(fd);
+  CHECK_ERROR;
+
+  capture = static_cast<const char *>(mapping);
+
+  uint32_t magic = 0;
+  std::memcpy(&magic, capture, std::min<size_t>(sizeof(magic), capture_size));
+
+  const bool is_pcap = (magic == 0xa1b2c3d4 || magic == 0xd4c3b2a1 || magic == 0xa1b23c4d || magic == 0x4d3cb2a1);
+  if (is_pcap)
+    loadPcap();
+  else
+    loadDump();
+
+  if (this->book_ids.empty())
+    collectBookIds();
+
+  if (!options.rewind.empty())
+  {
+    const size_t colon = options.rewind.find(':');
+    error |= colon == std::string::npos;
+    CHECK_ERROR;
+
+    sockaddr_in rewind_address{};
+    rewind_address.sin_family = AF_INET;
+    rewind_address.sin_port = htons(std::stoi(options.rewind.substr(colon + 1)));
+    error |= inet_pton(AF_INET, options.rewind.substr(0, colon).c_str(), &rewind_address.sin_addr) != 1;
+    CHECK_ERROR;
+
+    sockaddr_in bind_address{};
+    bind_address.sin_family = AF_INET;
+
+    recovery = std::make_unique<GapRecovery>(rewind_address, bind_address, -1);
+  }
+}
+
+COLD Replayer::~Replayer() noexcept
+{
+  munmap(const_cast<char *>(capture), capture_size);
+}
+
+COLD void Replayer::run(void)
+{
+  if (workers_count == 0)
+    runThroughput();
+  else
+    runShardedThroughput();
+
+  if (recovery)
+  {
+    const GapRecovery::Stats &stats = recovery->getStats();
+    std::printf("recovery: gaps %lu, missed messages %lu, max gap %lu, requests %lu, overflows %lu, total %.3f ms, max %.3f ms\n\n",
+      stats.gaps, stats.missed_messages, stats.max_gap, stats.requests, stats.overflows, stats.recovery_ns / 1e6, stats.max_recovery_ns / 1e6);
+  }
+
+  runProfile();
+
+  if (workers_count == 0)
+  {
+    runLatency();
+    runBursts();
+  }
+}
+
+COLD void Replayer::loadPcap(void)
+{
+  uint32_t magic;
+  std::memcpy(&magic, capture, sizeof(magic));
+  const bool swapped = (magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1);
+
+  const auto read32 = [swapped](const char *ptr)
+  {
+    uint32_t value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return swapped ? __builtin_bswap32(value) : value;
+  };
+  const auto read16be = [](const char *ptr) -> uint16_t
+  {
+    return *reinterpret_cast<const big_uint16_t *>(ptr);
+  };
+
+  static constexpr size_t file_header_size = 24;
+  static constexpr size_t record_header_size = 16;
+  static constexpr uint16_t ETHERTYPE_IPV4 = 0x0800;
+  static constexpr uint8_t IPPROTO_UDP_ = 17;
+
+  error |= capture_size < file_header_size;
+  CHECK_ERROR;
+
+  const uint32_t linktype = read32(capture + 20) & 0x0FFFFFFF;
+  size_t offset = file_header_size;
+
+  while (offset + record_header_size <= capture_size)
+  {
+    const size_t caplen = read32(capture + offset + 8);
+    const char *frame = capture + offset + record_header_size;
+
+    offset += record_header_size + caplen;
+    if (offset > capture_size) [[unlikely]]
+      break;
+
+    size_t link_length = 0;
+    uint16_t ethertype = 0;
+
+    switch (linktype)
+    {
+      case 1: //ethernet, possibly vlan tagged
+        link_length = 14;
+        ethertype = read16be(frame + 12);
+        while ((ethertype == 0x8100 || ethertype == 0x88A8) && link_length + 4 <= caplen)
+        {
+          ethertype = read16be(frame + link_length + 2);
+          link_length += 4;
+        }
+        break;
+      case 113: //linux cooked
+        link_length = 16;
+        ethertype = read16be(frame + 14);
+        break;
+      case 276: //linux cooked v2
+        link_length = 20;
+        ethertype = read16be(frame);
+        break;
+      case 12: //raw ip
+      case 101:
+        ethertype = ((frame[0] >> 4) == 4) ? ETHERTYPE_IPV4 : 0;
+        break;
+      default:
+        panic();
+    }
+
+    if (ethertype != ETHERTYPE_IPV4 || caplen < link_length + 20)
+      continue;
+
+    const char *ip = frame + link_length;
+    const size_t ip_header_length = (ip[0] & 0x0F) * 4;
+    const bool is_fragment = read16be(ip + 6) & 0x3FFF;
+
+    if (ip[9] != IPPROTO_UDP_ || is_fragment || caplen < link_length + ip_header_length + 8)
+      continue;
+
+    const char *udp = ip + ip_header_length;
+    const uint16_t destination_port = read16be(udp + 2);
+    const size_t udp_length = read16be(udp + 4);
+
+    if (port != 0 && destination_port != port)
+      continue;
+
+    const char *payload = udp + 8;
+    const size_t available = caplen - (payload - frame);
+    addPacket(payload, std::min(udp_length - 8, available));
+  }
+}
+
+COLD void Replayer::loadDump(void)
+{
+  size_t offset = 0;
+
+  while (offset + sizeof(big_uint16_t) <= capture_size)
+  {
+    const uint16_t length = *reinterpret_cast<const big_uint16_t *>(capture + offset);
+    offset += sizeof(big_uint16_t);
+
+    if (offset + length > capture_size) [[unlikely]]
+      break;
+
+    addPacket(capture + offset, length);
+    offset += length;
+  }
+}
+
+COLD void Replayer::addPacket(const char *data, const size_t length)
+{
+  if (length < sizeof(MoldUDP64Header))
+    return;
+
+  packets.emplace_back(data, length);
+}
+
+COLD void Replayer::collectBookIds(void)
+{
+  std::unordered_set<uint32_t> ids;
+
+  for (const auto &packet : packets)
+  {
+    const MoldUDP64Header &header = *reinterpret_cast<const MoldUDP64Header *>(packet.data());
+    const char *payload = packet.data() + sizeof(MoldUDP64Header);
+    const char *end = packet.data() + packet.size();
+    uint16_t message_count = header.message_count;
+
+    //end of session
+    if (message_count == UINT16_MAX)
+      continue;
+
+    while (message_count-- && payload < end)
+    {
+      const MessageBlock &block = *reinterpret_cast<const MessageBlock *>(payload);
+
+      if (block.data.type == 'R')
+        ids.insert(block.data.series_info_basic.orderbook_id);
+      else if (block.data.type == 'A')
+        ids.insert(block.data.new_order.orderbook_id);
+
+      payload += sizeof(block.length) + block.length;
+    }
+  }
+
+  book_ids.assign(ids.begin(), ids.end());
+  std::sort(book_ids.begin(), book_ids.end());
+}
+
+COLD void Replayer::setupBooks(MessageHandler &handler) const
+{
+  for (const uint32_t id : book_ids)
+  {
+    handler.addBookId(id);
+    handler.addOrderBook(id);
+  }
+}
+
+template <typename Callback>
+HOT uint64_t Replayer::forEachPacket(Callback &&callback)
+{
+  uint64_t sequence_number = 0;
+  uint64_t messages = 0;
+
+  counters.packets = 0;
+  counters.gaps = 0;
+  counters.duplicates = 0;
+
+  for (const auto &packet : packets)
+  {
+    const MoldUDP64Header &header = *reinterpret_cast<const MoldUDP64Header *>(packet.data());
+    const uint64_t packet_sequence = header.sequence_number;
+    uint16_t message_count = header.message_count;
+    const char *payload = packet.data() + sizeof(MoldUDP64Header);
+
+    counters.packets++;
+
+    if (drop_every != 0 && counters.packets % drop_every == 0)
+      continue;
+
+    //heartbeats and end of session
+    if (message_count == 0 || message_count == UINT16_MAX)
+      continue;
+
+    sequence_number += (sequence_number == 0) * packet_sequence;
+
+    //captures of both feed lines carry every packet twice
+    if (packet_sequence + message_count <= sequence_number)
+    {
+      counters.duplicates++;
+      continue;
+    }
+
+    if (packet_sequence > sequence_number)
+    {
+      counters.gaps++;
+
+      if (recovery)
+      {
+        MoldUDP64Packet pending{};
+        std::memcpy(&pending, packet.data(), std::min(packet.size(), sizeof(pending)));
+
+        recovery->recover(std::span(&pending, 1), sequence_number, [&](const char *payload, const uint16_t message_count)
+        {
+          callback(payload, message_count);
+          messages += message_count;
+        }, false);
+        continue;
+      }
+
+      sequence_number = packet_sequence;
+    }
+
+    for (uint64_t sequence = packet_sequence; sequence < sequence_number; ++sequence)
+    {
+      const MessageBlock &block = *reinterpret_cast<const MessageBlock *>(payload);
+      payload += sizeof(block.length) + block.length;
+      message_count--;
+    }
+
+    callback(payload, message_count);
+
+    sequence_number += message_count;
+    messages += message_count;
+  }
+
+  counters.next_sequence = sequence_number;
+  return messages;
+}
+
+COLD void Replayer::runThroughput(void)
+{
+  MessageHandler handler;
+  setupBooks(handler);
+
+  const auto start = std::chrono::steady_clock::now();
+
+  counters.messages = forEachPacket([&handler](const char *payload, const uint16_t message_count)
+  {
+    handler.handleMessageBlocks(payload, message_count);
+  });
+
+  const auto end = std::chrono::steady_clock::now();
+  const double seconds = std::chrono::duration<double>(end - start).count();
+
+  std::printf("packets: %lu, messages: %lu, gaps: %lu, duplicates: %lu\n", counters.packets, counters.messages, counters.gaps, counters.duplicates);
+  std::printf("throughput: %.3f s, %.0f msgs/s, %.1f ns/msg\n\n", seconds, counters.messages / seconds, seconds * 1e9 / counters.messages);
+
+  const OrderPool::Stats pool = handler.getPoolStats();
+  std::printf("order pool: capacity %zu, reserved %zu, allocated %zu, orders %zu, grows %zu\n\n", pool.capacity, pool.reserved, pool.allocated, pool.orders, pool.grows);
+
+  if (!checkpoint_path.empty())
+    runCheckpoint(handler);
+}
+
+//writes the books, restores them into a fresh handler and checks that checkpointing that one gives the same bytes
+COLD void Replayer::runCheckpoint(const MessageHandler &handler)
+{
+  const char *session = reinterpret_cast<const MoldUDP64Header *>(packets.front().data())->session;
+  const std::string copy_path = checkpoint_path + ".copy";
+
+  Checkpointer checkpointer(checkpoint_path, 0);
+
+  const auto save_start = std::chrono::steady_clock::now();
+  checkpointer.save(handler, counters.next_sequence, session);
+  const auto save_end = std::chrono::steady_clock::now();
+
+  //the periodic captures of the live client serialize into a warm staging buffer
+  checkpointer.save(handler, counters.next_sequence, session);
+  const double stall_ms = checkpointer.getSerializeNs() / 1e6;
+
+  error |= checkpointer.getFailures() != 0;
+  error |= checkpointer.open() == nullptr;
+  CHECK_ERROR;
+
+  MessageHandler restored;
+  const auto restore_start = std::chrono::steady_clock::now();
+  checkpointer.restore(restored);
+  const auto restore_end = std::chrono::steady_clock::now();
+
+  Checkpointer copy(copy_path, 0);
+  copy.save(restored, counters.next_sequence, session);
+  error |= copy.open() == nullptr;
+  CHECK_ERROR;
+
+  const CheckpointHeader &original = *checkpointer.open();
+  const CheckpointHeader &roundtrip = *copy.open();
+  const bool identical = (original.size == roundtrip.size) && std::memcmp(&original, &roundtrip, original.size) == 0;
+  unlink(copy_path.c_str());
+
+  std::printf("checkpoint: %.2f MB, save %.3f ms, capture stall %.3f ms, restore %.3f ms, round trip %s\n\n", original.size / 1e6,
+    std::chrono::duration<double, std::milli>(save_end - save_start).count(), stall_ms,
+    std::chrono::duration<double, std::milli>(restore_end - restore_start).count(),
+    identical ? "identical" : "DIFFERS");
+}
+
+COLD void Replayer::runShardedThroughput(void)
+{
+  Config config{};
+  config.book_ids = book_ids;
+  config.workers_count = workers_count;
+  config.dispatcher_core = -1;
+
+  HotCounters hot_counters("", workers_count + 1);
+  BookPublisher publisher("", 0);
+  Workers workers(config, hot_counters, publisher);
+
+  const auto start = std::chrono::steady_clock::now();
+
+  counters.messages = forEachPacket([&workers](const char *payload, const uint16_t message_count)
+  {
+    workers.handleMessageBlocks(payload, message_count);
+  });
+  workers.flush();
+
+  const auto end = std::chrono::steady_clock::now();
+  const double seconds = std::chrono::duration<double>(end - start).count();
+
+  std::printf("packets: %lu, messages: %lu, gaps: %lu, duplicates: %lu\n", counters.packets, counters.messages, counters.gaps, counters.duplicates);
+  std::printf("sharded throughput (%u workers): %.3f s, %.0f msgs/s, %.1f ns/msg\n\n", workers_count, seconds, counters.messages / seconds, seconds * 1e9 / counters.messages);
+
+  const OrderPool::Stats pool = workers.getPoolStats();
+  std::printf("order pool: capacity %zu, reserved %zu, allocated %zu, orders %zu, grows %zu\n\n", pool.capacity, pool.reserved, pool.allocated, pool.orders, pool.grows);
+}
+
+COLD void Replayer::runProfile(void)
+{
+  static constexpr std::array<const char *, 'Z' + 1> names = []()
+  {
+    std::array<const char *, 'Z' + 1> names{};
+    names['T'] = "seconds";
+    names['A'] = "new order";
+    names['D'] = "deleted order";
+    names['E'] = "execution notice";
+    names['C'] = "execution notice with trade info";
+    names['Z'] = "equilibrium price";
+    names['R'] = "series info basic";
+    names['M'] = "series info basic combination";
+    names['L'] = "tick size data";
+    names['S'] = "system event";
+    names['O'] = "trading status";
+    return names;
+  }();
+
+  MessageHandler handler;
+  setupBooks(handler);
+
+  //cost of the timestamps themselves, removed from every sample
+  uint64_t overhead = UINT64_MAX;
+  for (int i = 0; i < 1000; ++i)
+  {
+    _mm_lfence();
+    const uint64_t start = __rdtsc();
+    _mm_lfence();
+    const uint64_t end = __rdtsc();
+    overhead = std::min(overhead, end - start);
+  }
+
+  counters.counts.fill(0);
+  counters.cycles.fill(0);
+
+  const auto start_time = std::chrono::steady_clock::now();
+  const uint64_t start_cycles = __rdtsc();
+
+  forEachPacket([this, &handler, overhead](const char *payload, uint16_t message_count)
+  {
+    while (message_count--)
+    {
+      const MessageBlock &block = *reinterpret_cast<const MessageBlock *>(payload);
+      const uint8_t type = block.data.type;
+
+      _mm_lfence();
+      const uint64_t start = __rdtsc();
+      handler.handleMessage(block.data);
+      _mm_lfence();
+      const uint64_t end = __rdtsc();
+
+      counters.counts[type]++;
+      counters.cycles[type] += end - start - std::min(end - start, overhead);
+      payload += sizeof(block.length) + block.length;
+    }
+  });
+
+  const uint64_t end_cycles = __rdtsc();
+  const auto end_time = std::chrono::steady_clock::now();
+  const double ns_per_cycle = std::chrono::duration<double, std::nano>(end_time - start_time).count() / (end_cycles - start_cycles);
+
+  std::printf("%-4s %-34s %12s %10s\n", "type", "message", "count", "ns/msg");
+  for (uint8_t type = 0; type < names.size(); ++type)
+  {
+    if (counters.counts[type] == 0)
+      continue;
+
+    const char *name = names[type] ? names[type] : "unknown";
+    const double ns = counters.cycles[type] * ns_per_cycle / counters.counts[type];
+    std::printf("%-4c %-34s %12lu %10.1f\n", type, name, counters.counts[type], ns);
+  }
+}
+
+//same pass with and without the timestamps, to price them, alternated and keeping the fastest of each.
+//the packets carry no kernel timestamp, only userspace to book is measured
+COLD void Replayer::runLatency(void)
+{
+  static constexpr int passes = 3;
+
+  LatencyStats latency(true);
+  LatencyStats::PacketStamps stamps{};
+
+  double plain_ns = INFINITY;
+  double timed_ns = INFINITY;
+
+  for (int pass = 0; pass < passes; ++pass)
+  {
+    MessageHandler plain_handler;
+    setupBooks(plain_handler);
+
+    const auto plain_start = std::chrono::steady_clock::now();
+
+    const uint64_t messages = forEachPacket([&plain_handler](const char *payload, const uint16_t message_count)
+    {
+      plain_handler.handleMessageBlocks(payload, message_count);
+    });
+
+    const auto plain_end = std::chrono::steady_clock::now();
+    plain_ns = std::min(plain_ns, std::chrono::duration<double, std::nano>(plain_end - plain_start).count() / messages);
+
+    MessageHandler timed_handler;
+    setupBooks(timed_handler);
+
+    const auto timed_start = std::chrono::steady_clock::now();
+
+    forEachPacket([&timed_handler, &latency, &stamps](const char *payload, const uint16_t message_count)
+    {
+      latency.stampReceive(stamps);
+      timed_handler.handleMessageBlocks(payload, message_count, stamps, latency);
+    });
+
+    const auto timed_end = std::chrono::steady_clock::now();
+    timed_ns = std::min(timed_ns, std::chrono::duration<double, std::nano>(timed_end - timed_start).count() / messages);
+  }
+
+  std::printf("\nlatency stats: %.1f ns/msg, %.1f ns/msg without, overhead %.1f ns/msg\n", timed_ns, plain_ns, timed_ns - plain_ns);
+  latency.dump(stdout);
+}
+
+//same pass message by message and decoded as bursts of MAX_BURST_PACKETS packets, alternated and keeping the fastest of each
+COLD void Replayer::runBursts(void)
+{
+  static constexpr int passes = 3;
+
+  double plain_ns = INFINITY;
+  double burst_ns = INFINITY;
+  OrderPool::Stats plain_pool{};
+  OrderPool::Stats burst_pool{};
+
+  for (int pass = 0; pass < passes; ++pass)
+  {
+    MessageHandler plain_handler;
+    setupBooks(plain_handler);
+
+    const auto plain_start = std::chrono::steady_clock::now();
+
+    const uint64_t messages = forEachPacket([&plain_handler](const char *payload, const uint16_t message_count)
+    {
+      plain_handler.handleMessageBlocks(payload, message_count);
+    });
+
+    const auto plain_end = std::chrono::steady_clock::now();
+    plain_ns = std::min(plain_ns, std::chrono::duration<double, std::nano>(plain_end - plain_start).count() / messages);
+    plain_pool = plain_handler.getPoolStats();
+
+    MessageHandler burst_handler;
+    setupBooks(burst_handler);
+    burst_handler.enableBursts();
+
+    uint32_t burst_packets = 0;
+    const auto burst_start = std::chrono::steady_clock::now();
+
+    forEachPacket([&burst_handler, &burst_packets](const char *payload, const uint16_t message_count)
+    {
+      burst_handler.decodeMessageBlocks(payload, message_count);
+
+      if (++burst_packets == MAX_BURST_PACKETS)
+      {
+        burst_handler.applyBurst();
+        burst_packets = 0;
+      }
+    });
+    burst_handler.applyBurst();
+
+    const auto burst_end = std::chrono::steady_clock::now();
+    burst_ns = std::min(burst_ns, std::chrono::duration<double, std::nano>(burst_end - burst_start).count() / messages);
+    burst_pool = burst_handler.getPoolStats();
+  }
+
+  const bool identical = (plain_pool.allocated == burst_pool.allocated) & (plain_pool.orders == burst_pool.orders);
+
+  std::printf("\nbursts of %d packets: %.1f ns/msg, %.1f ns/msg message by message, books %s\n", MAX_BURST_PACKETS,
+    burst_ns, plain_ns, identical ? "identical" : "DIFFER");
+}
@@ -0,0 +1,48 @@
+/*================================================================================
+
+File: SoupBinTCPReader.cpp                                                      
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-26 11:07:42                                                 
+last edited: 2025-06-26 11:07:42                                                
+
+================================================================================*/
+
+#include <sys/socket.h>
+
+#include "SoupBinTCPReader.hpp"
+#include "macros.hpp"
+#include "error.hpp"
+
+extern volatile bool error;
+
+COLD SoupBinTCPReader::SoupBinTCPReader(void) :
+  buffer(std::make_unique_for_overwrite<char[]>(CAPACITY)),
+  size(0)
+{
+}
+
+COLD SoupBinTCPReader::~SoupBinTCPReader()
+{
+}
+
+//whatever the socket has, up to the free room. The session ends with the snapshot, never before it
+COLD void SoupBinTCPReader::read(const int fd)
+{
+  uint32_t count;
+  char *const free_bytes = claim(count);
+
+  const ssize_t received = recv(fd, free_bytes, count, 0);
+  error |= received <= 0;
+  CHECK_ERROR;
+
+  commit(received);
+}
+
+//the reader is only needed until the snapshot is complete
+COLD void SoupBinTCPReader::release(void)
+{
+  buffer.reset();
+  size = 0;
+}
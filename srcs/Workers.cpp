@@ -0,0 +1,172 @@
+/*================================================================================
+
+File: Workers.cpp                                                               
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-18 16:30:02                                                 
+last edited: 2025-06-19 10:27:14                                                
+
+================================================================================*/
+
+#include <immintrin.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "Workers.hpp"
+#include "error.hpp"
+#include "macros.hpp"
+
+COLD Workers::Workers(const Config &config, HotCounters &counters, BookPublisher &publisher) :
+  routes(),
+  workers(),
+  dirty(0)
+{
+  error |= (config.workers_count > 64);
+  error |= (!config.book_workers.empty() && config.book_workers.size() != config.book_ids.size());
+  CHECK_ERROR;
+
+  if (config.workers_count == 0)
+    return;
+
+  workers.reserve(config.workers_count);
+  for (uint8_t worker_idx = 0; worker_idx < config.workers_count; ++worker_idx)
+  {
+    workers.push_back(std::make_unique<Worker>());
+    workers.back()->handler.store(nullptr, std::memory_order_relaxed);
+    workers.back()->counters = &counters.getSlot(worker_idx + 1);
+    workers.back()->publisher = publisher.isEnabled() ? &publisher : nullptr;
+    workers.back()->core = (worker_idx < config.worker_cores.size()) ? config.worker_cores[worker_idx] : -1;
+  }
+
+  for (size_t i = 0; i < config.book_ids.size(); ++i)
+  {
+    const uint32_t worker_idx = config.book_workers.empty() ? (i % config.workers_count) : config.book_workers[i];
+
+    error |= (worker_idx >= config.workers_count);
+    CHECK_ERROR;
+
+    routes.insert(config.book_ids[i]);
+    routes.setBook(config.book_ids[i], worker_idx);
+    workers[worker_idx]->book_ids.push_back(config.book_ids[i]);
+  }
+
+  for (auto &worker : workers)
+    worker->thread = std::jthread(run, std::ref(*worker));
+
+  for (auto &worker : workers)
+    while (worker->handler.load(std::memory_order_acquire) == nullptr)
+      _mm_pause();
+}
+
+COLD Workers::~Workers()
+{
+  for (auto &worker : workers)
+    worker->thread.request_stop();
+}
+
+COLD void Workers::pinThread(const int16_t core)
+{
+  if (core < 0)
+    return;
+
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(core, &cpus);
+
+  error |= pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0;
+  CHECK_ERROR;
+}
+
+//the handler lives on the worker stack so that its books are first touched by the core processing them
+HOT void Workers::run(std::stop_token stop, Worker &worker)
+{
+  pinThread(worker.core);
+
+  MessageHandler handler;
+  handler.setCounters(*worker.counters);
+  if (worker.publisher != nullptr)
+    handler.setPublisher(*worker.publisher);
+  for (const uint32_t orderbook_id : worker.book_ids)
+    handler.addBookId(orderbook_id);
+
+  worker.handler.store(&handler, std::memory_order_release);
+
+  Ring &ring = worker.ring;
+
+  while (!stop.stop_requested())
+  {
+    size_t available = ring.poll();
+
+    if (available == 0)
+    {
+      _mm_pause();
+      continue;
+    }
+
+    while (available)
+    {
+      const MessageBlock &record = *reinterpret_cast<const MessageBlock *>(ring.front());
+      const size_t cells = (sizeof(record.length) + record.length + sizeof(Cell) - 1) / sizeof(Cell);
+
+      PREFETCH_R(ring.front() + cells, 0);
+      handler.handleMessage(record.data);
+
+      ring.consume(cells);
+      available -= cells;
+    }
+
+    ring.release();
+    handler.publishBooks();
+  }
+}
+
+HOT void Workers::handleMessage(const MessageData &data, const uint16_t length)
+{
+  dispatch(data, length);
+  commit();
+}
+
+HOT void Workers::handleMessageBlocks(const char *restrict buffer, uint16_t blocks_count)
+{
+  while (blocks_count--)
+  {
+    const MessageBlock &block = *reinterpret_cast<const MessageBlock *>(buffer);
+    const uint16_t length = block.length;
+
+    PREFETCH_R(buffer + sizeof(block.length) + length, 1);
+    dispatch(block.data, length);
+
+    buffer += sizeof(block.length) + length;
+  }
+
+  commit();
+}
+
+//waits until every worker has processed everything routed so far
+COLD void Workers::flush(void) noexcept
+{
+  commit();
+
+  for (auto &worker : workers)
+    while (!worker->ring.drained())
+      _mm_pause();
+}
+
+//only meaningful once flushed
+COLD OrderPool::Stats Workers::getPoolStats(void) const noexcept
+{
+  OrderPool::Stats total{};
+
+  for (const auto &worker : workers)
+  {
+    const OrderPool::Stats stats = worker->handler.load(std::memory_order_acquire)->getPoolStats();
+    total.capacity += stats.capacity;
+    total.reserved += stats.reserved;
+    total.allocated += stats.allocated;
+    total.orders += stats.orders;
+    total.grows += stats.grows;
+  }
+
+  return total;
+}
@@ -5,11 +5,13 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-03-08 18:21:38                                                 
-last edited: 2025-04-24 12:40:43                                                
+last edited: 2025-06-22 10:41:05                                                
 
 ================================================================================*/
 
 #include <csignal>
+#include <string>
+#include <string_view>
 
 #include "Client.hpp"
 #include "Config.hpp"
@@ -22,10 +24,11 @@ volatile bool error = false;
 //TODO rewind
 
 void init_signal_handler(void);
+FeedBackend parse_feed_backend(const std::string_view backend);
 
 int main(int argc, char **argv)
 {
-  if (argc != 3)
+  if (argc < 3 || argc > 5)
     return 1;
 
   init_signal_handler();
@@ -34,6 +37,8 @@ int main(int argc, char **argv)
     .bind_ip = "10.248.193.12",
     .multicast_ip = "239.194.169.2",
     .multicast_port = "21002",
+    .feed_backend = (argc == 5) ? parse_feed_backend(argv[4]) : FeedBackend::RECVMMSG,
+    .feed_interface = (argc == 5) ? argv[4] : "",
     .rewind_ip = "10.18.146.3",
     .rewind_port = "24003",
     .glimpse_ip = "10.18.146.3",
@@ -41,6 +46,16 @@ int main(int argc, char **argv)
     .book_ids = {
       53018725, 77267045, 128122981, 59965541, 66715749, 196709, 1114213, 51970149, 393317, 52363365, 66584677, 14090341, 60031077, 84279397, 262245, 52953189, 458853, 128057445, 65732709, 66650213, 36765797, 1048677, 77070437
     },
+    .book_workers = {},
+    .workers_count = static_cast<uint8_t>((argc >= 4) ? std::stoi(argv[3]) : 0),
+    .batch_bursts = false,
+    .dispatcher_core = -1,
+    .worker_cores = { 2, 3, 4, 5, 6, 7, 8, 9 },
+    .checkpoint_path = "",
+    .checkpoint_interval_s = 10,
+    .counters_name = "/orderbook_counters",
+    .books_name = "/orderbook_books",
+    .latency_stats = false,
     .username = argv[1],
     .password = argv[2]
   };
@@ -49,6 +64,16 @@ int main(int argc, char **argv)
   client.run();
 }
 
+//uring, uring-sqpoll, or the interface to read a TPACKET_V3 ring from
+COLD FeedBackend parse_feed_backend(const std::string_view backend)
+{
+  if (backend == "uring")
+    return FeedBackend::IO_URING;
+  if (backend == "uring-sqpoll")
+    return FeedBackend::IO_URING_SQPOLL;
+  return FeedBackend::PACKET_RING;
+}
+
 COLD void init_signal_handler(void)
 {
   struct sigaction sa{};
@@ -60,5 +85,12 @@ COLD void init_signal_handler(void)
   error |= sigaction(SIGQUIT, &sa, nullptr) == -1;
   error |= sigaction(SIGPIPE, &sa, nullptr) == -1;
 
+  //SIGUSR1 dumps the latency histograms. It is blocked here, before any thread starts, so that only
+  //LatencyStats takes it and no receive call is ever interrupted
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGUSR1);
+  error |= pthread_sigmask(SIG_BLOCK, &signals, nullptr) != 0;
+
   CHECK_ERROR;
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+/*================================================================================
+
+File: replay.cpp                                                                
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-14 20:05:33                                                 
+last edited: 2025-06-03 09:27:51                                                
+
+================================================================================*/
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Replayer.hpp"
+#include "error.hpp"
+
+volatile bool error = false;
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    std::fprintf(stderr, "usage: %s <capture> [--port <udp port>] [--workers <count>] [--drop <every nth packet>] [--rewind <ip:port>] [--checkpoint <path>] [orderbook_id...]\n", argv[0]);
+    return 1;
+  }
+
+  Replayer::Options options{};
+
+  for (int i = 2; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+      options.port = std::stoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+      options.workers_count = std::stoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--drop") == 0 && i + 1 < argc)
+      options.drop_every = std::stoul(argv[++i]);
+    else if (std::strcmp(argv[i], "--rewind") == 0 && i + 1 < argc)
+      options.rewind = argv[++i];
+    else if (std::strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc)
+      options.checkpoint = argv[++i];
+    else
+      options.book_ids.push_back(std::stoul(argv[i]));
+  }
+
+  Replayer replayer(argv[1], options);
+  replayer.run();
+}
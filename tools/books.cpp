@@ -0,0 +1,116 @@
+/*================================================================================
+
+File: books.cpp                                                                 
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-19 10:27:14                                                 
+last edited: 2025-06-19 10:27:14                                                
+
+================================================================================*/
+
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "BookPublisher.hpp"
+
+//prints the top of the books of a running client, read from its shared memory segment without stopping it.
+//usage: books <segment name> [every n seconds]
+
+using Slot = BookPublisher::Slot;
+using Snapshot = BookPublisher::Snapshot;
+
+static void print(const Snapshot &snapshot, const uint32_t depth)
+{
+  std::printf("book %u, %lu updates, equilibrium %d (%lu / %lu)\n", snapshot.orderbook_id, snapshot.updates,
+    snapshot.equilibrium_price, snapshot.equilibrium_bid_qty, snapshot.equilibrium_ask_qty);
+
+  for (uint32_t level = 0; level < depth; ++level)
+  {
+    const bool has_bid = level < snapshot.levels_count[0];
+    const bool has_ask = level < snapshot.levels_count[1];
+
+    if (!has_bid && !has_ask)
+      break;
+
+    if (has_bid)
+      std::printf("  %12lu @ %-10d", snapshot.qtys[0][level], snapshot.prices[0][level]);
+    else
+      std::printf("  %25s", "");
+
+    if (has_ask)
+      std::printf("  |  %-10d @ %lu", snapshot.prices[1][level], snapshot.qtys[1][level]);
+
+    std::printf("\n");
+  }
+}
+
+static void print(const BookPublisher::Header &header, const Slot *slots)
+{
+  const uint32_t books_count = __atomic_load_n(&header.books_count, __ATOMIC_ACQUIRE);
+
+  for (uint32_t i = 0; i < books_count && i < header.slots_count; ++i)
+  {
+    Snapshot snapshot;
+
+    //the writer never waits, a torn copy is just taken again
+    while (!BookPublisher::read(slots[i], snapshot))
+      ;
+
+    print(snapshot, header.depth);
+  }
+
+  std::printf("\n");
+  std::fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    std::fprintf(stderr, "usage: %s <segment name> [every n seconds]\n", argv[0]);
+    return 1;
+  }
+
+  const int fd = shm_open(argv[1], O_RDONLY, 0);
+  if (fd == -1)
+  {
+    std::perror("shm_open");
+    return 1;
+  }
+
+  BookPublisher::Header header;
+  const bool valid = (pread(fd, &header, sizeof(header), 0) == sizeof(header));
+  if (!valid || header.magic != BookPublisher::MAGIC || header.version != BookPublisher::VERSION || header.depth > BOOK_PUBLISH_DEPTH)
+  {
+    std::fprintf(stderr, "%s is not a books segment of this version\n", argv[1]);
+    return 1;
+  }
+
+  const size_t size = BookPublisher::getSize(header.slots_count);
+  const void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (mapping == MAP_FAILED)
+  {
+    std::perror("mmap");
+    return 1;
+  }
+
+  const BookPublisher::Header &live = *static_cast<const BookPublisher::Header *>(mapping);
+  const Slot *slots = reinterpret_cast<const Slot *>(static_cast<const char *>(mapping) + sizeof(BookPublisher::Header));
+  const unsigned interval = (argc > 2) ? std::stoul(argv[2]) : 0;
+
+  do
+  {
+    print(live, slots);
+  }
+  while (interval != 0 && sleep(interval) == 0);
+
+  return 0;
+}
@@ -0,0 +1,136 @@
+/*================================================================================
+
+File: counters.cpp                                                              
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-18 09:41:05                                                 
+last edited: 2025-06-18 09:41:05                                                
+
+================================================================================*/
+
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "HotCounters.hpp"
+
+//prints the hot path counters of a running client, read from its shared memory segment without stopping it.
+//usage: counters <segment name> [every n seconds]
+
+using Slot = HotCounters::Slot;
+
+static uint64_t load(const uint64_t &counter)
+{
+  return std::atomic_ref<const uint64_t>(counter).load(std::memory_order_relaxed);
+}
+
+//lower bound of the bucket holding the percentile, in cycles
+static uint64_t getPercentile(const Slot *slots, const uint32_t slots_count, const uint8_t type, const double percentile)
+{
+  uint64_t counts[HotCounters::CYCLE_BUCKETS]{};
+  uint64_t total = 0;
+
+  for (uint32_t i = 0; i < slots_count; ++i)
+    for (uint32_t bucket = 0; bucket < HotCounters::CYCLE_BUCKETS; ++bucket)
+      counts[bucket] += load(slots[i].cycles[type][bucket]), total += load(slots[i].cycles[type][bucket]);
+
+  const uint64_t target = total * percentile / 100;
+  uint64_t seen = 0;
+
+  for (uint32_t bucket = 0; bucket < HotCounters::CYCLE_BUCKETS; ++bucket)
+  {
+    seen += counts[bucket];
+    if (seen > target)
+      return 1ull << bucket;
+  }
+
+  return 0;
+}
+
+static void print(const HotCounters::Header &header, const Slot *slots)
+{
+  const uint32_t slots_count = header.slots_count;
+
+  std::printf("%-6s %12s %10s %10s %10s %10s %10s %10s\n", "slot", "messages", "dropped", "new lvl", "joined lvl", "removed", "bid depth", "ask depth");
+
+  for (uint32_t i = 0; i < slots_count; ++i)
+  {
+    const Slot &slot = slots[i];
+
+    uint64_t messages = 0;
+    for (const uint64_t &count : slot.messages)
+      messages += load(count);
+
+    std::printf("%-6u %12lu %10lu %10lu %10lu %10lu %10lu %10lu\n", i, messages, load(slot.dropped), load(slot.new_levels),
+      load(slot.existing_levels), load(slot.removed_levels), load(slot.max_depth[0]), load(slot.max_depth[1]));
+  }
+
+  std::printf("\n%-4s %12s %12s %12s %12s   (cycles, 1 in %u sampled)\n", "type", "count", "p50", "p99", "p99.9", header.sample_interval);
+
+  for (uint32_t type = 0; type < HotCounters::TYPES; ++type)
+  {
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < slots_count; ++i)
+      count += load(slots[i].messages[type]);
+
+    if (count == 0)
+      continue;
+
+    std::printf("%-4c %12lu %12lu %12lu %12lu\n", type, count, getPercentile(slots, slots_count, type, 50),
+      getPercentile(slots, slots_count, type, 99), getPercentile(slots, slots_count, type, 99.9));
+  }
+
+  std::printf("\n");
+  std::fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    std::fprintf(stderr, "usage: %s <segment name> [every n seconds]\n", argv[0]);
+    return 1;
+  }
+
+  const int fd = shm_open(argv[1], O_RDONLY, 0);
+  if (fd == -1)
+  {
+    std::perror("shm_open");
+    return 1;
+  }
+
+  HotCounters::Header header;
+  const bool valid = (pread(fd, &header, sizeof(header), 0) == sizeof(header));
+  if (!valid || header.magic != HotCounters::MAGIC || header.version != HotCounters::VERSION)
+  {
+    std::fprintf(stderr, "%s is not a counters segment of this version\n", argv[1]);
+    return 1;
+  }
+
+  const size_t size = HotCounters::getSize(header.slots_count);
+  const void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (mapping == MAP_FAILED)
+  {
+    std::perror("mmap");
+    return 1;
+  }
+
+  const Slot *slots = reinterpret_cast<const Slot *>(static_cast<const char *>(mapping) + sizeof(HotCounters::Header));
+  const unsigned interval = (argc > 2) ? std::stoul(argv[2]) : 0;
+
+  do
+  {
+    print(header, slots);
+  }
+  while (interval != 0 && sleep(interval) == 0);
+
+  return 0;
+}
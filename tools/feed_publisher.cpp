@@ -0,0 +1,109 @@
+/*================================================================================
+
+File: feed_publisher.cpp                                                        
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-06-08 16:42:13                                                 
+last edited: 2025-06-08 16:42:13                                                
+
+================================================================================*/
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Packets.hpp"
+
+//local stand-in for the exchange multicast feed, publishes the packets of a length prefixed capture to a group
+//from the interface owning the given address. loopback works as is, a veth pair makes the ring see real ethernet frames.
+//usage: feed_publisher <capture> <group> <port> <interface ip> [packets per second]
+
+static bool load(const char *path, std::vector<char> &data)
+{
+  FILE *file = std::fopen(path, "rb");
+  if (file == nullptr)
+  {
+    std::perror(path);
+    return false;
+  }
+
+  std::fseek(file, 0, SEEK_END);
+  data.resize(std::ftell(file));
+  std::fseek(file, 0, SEEK_SET);
+  const size_t read = std::fread(data.data(), 1, data.size(), file);
+  std::fclose(file);
+
+  return read == data.size();
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 5)
+  {
+    std::fprintf(stderr, "usage: %s <capture> <group> <port> <interface ip> [packets per second]\n", argv[0]);
+    return 1;
+  }
+
+  std::vector<char> data;
+  if (!load(argv[1], data))
+    return 1;
+
+  const uint64_t rate = (argc > 5) ? std::stoull(argv[5]) : 0;
+
+  sockaddr_in group{};
+  group.sin_family = AF_INET;
+  group.sin_port = htons(std::stoi(argv[3]));
+
+  in_addr interface{};
+  constexpr uint8_t ttl = 1;
+
+  const int sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+  if (sock_fd == -1 ||
+      inet_pton(AF_INET, argv[2], &group.sin_addr) != 1 ||
+      inet_pton(AF_INET, argv[4], &interface) != 1 ||
+      setsockopt(sock_fd, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface)) == -1 ||
+      setsockopt(sock_fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) == -1)
+  {
+    std::perror("socket");
+    return 1;
+  }
+
+  const auto interval = std::chrono::nanoseconds(rate ? 1000000000 / rate : 0);
+  auto next = std::chrono::steady_clock::now();
+  uint64_t packets = 0;
+  size_t offset = 0;
+
+  while (offset + sizeof(big_uint16_t) <= data.size())
+  {
+    const uint16_t length = *reinterpret_cast<const big_uint16_t *>(&data[offset]);
+    const char *packet = &data[offset + sizeof(big_uint16_t)];
+    offset += sizeof(big_uint16_t) + length;
+
+    if (offset > data.size())
+      break;
+
+    if (rate != 0)
+    {
+      next += interval;
+      std::this_thread::sleep_until(next);
+    }
+
+    if (sendto(sock_fd, packet, length, 0, reinterpret_cast<const sockaddr *>(&group), sizeof(group)) == -1)
+    {
+      std::perror("sendto");
+      return 1;
+    }
+
+    packets++;
+  }
+
+  std::fprintf(stderr, "published %lu packets\n", packets);
+}
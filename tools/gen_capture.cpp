@@ -0,0 +1,229 @@
+/*================================================================================
+
+File: gen_capture.cpp                                                           
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-14 20:05:33                                                 
+last edited: 2025-05-24 11:12:47                                                
+
+================================================================================*/
+
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Packets.hpp"
+
+//writes a synthetic length prefixed capture of the multicast feed, for the replay driver.
+//usage: gen_capture <output> [messages] [books] [seed]
+
+static constexpr size_t PACKET_PAYLOAD_LIMIT = 1400;
+static constexpr int32_t MID_PRICE = 100000;
+static constexpr int32_t PRICE_SPREAD = 256;
+static constexpr size_t TARGET_DEPTH = 1024;
+
+struct Order
+{
+  uint64_t id;
+  uint64_t qty;
+  char side;
+};
+
+class CaptureWriter
+{
+  public:
+    CaptureWriter(FILE *file) : file(file), sequence_number(1), message_count(0)
+    {
+      packet.reserve(MTU);
+      reset();
+    }
+
+    ~CaptureWriter()
+    {
+      flush();
+    }
+
+    template <typename Fill>
+    void append(const char type, const size_t body_size, Fill &&fill)
+    {
+      const size_t block_size = sizeof(big_uint16_t) + sizeof(char) + body_size;
+
+      if (packet.size() + block_size > PACKET_PAYLOAD_LIMIT)
+        flush();
+
+      MessageBlock block{};
+      block.length = sizeof(char) + body_size;
+      block.data.type = type;
+      fill(block.data);
+
+      const char *raw = reinterpret_cast<const char *>(&block);
+      packet.insert(packet.end(), raw, raw + block_size);
+      message_count++;
+    }
+
+    void flush(void)
+    {
+      if (message_count == 0)
+        return;
+
+      MoldUDP64Header &header = *reinterpret_cast<MoldUDP64Header *>(packet.data());
+      header.sequence_number = sequence_number;
+      header.message_count = message_count;
+
+      write();
+      //captures taken from both feed lines see packets twice
+      if (sequence_number % 97 == 0)
+        write();
+
+      sequence_number += message_count;
+      reset();
+    }
+
+  private:
+    void reset(void)
+    {
+      packet.assign(sizeof(MoldUDP64Header), 0);
+      std::memcpy(packet.data(), "GENCAPTURE", sizeof(MoldUDP64Header::session));
+      message_count = 0;
+    }
+
+    void write(void)
+    {
+      const big_uint16_t length = packet.size();
+      std::fwrite(&length, sizeof(length), 1, file);
+      std::fwrite(packet.data(), 1, packet.size(), file);
+    }
+
+    FILE *file;
+    uint64_t sequence_number;
+    uint16_t message_count;
+    std::vector<char> packet;
+};
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    std::fprintf(stderr, "usage: %s <output> [messages] [books] [seed]\n", argv[0]);
+    return 1;
+  }
+
+  const uint64_t total_messages = (argc > 2) ? std::stoull(argv[2]) : 1000000;
+  const uint32_t books_count = (argc > 3) ? std::stoul(argv[3]) : 8;
+  const uint64_t seed = (argc > 4) ? std::stoull(argv[4]) : 42;
+
+  FILE *file = std::fopen(argv[1], "wb");
+  if (file == nullptr)
+  {
+    std::perror(argv[1]);
+    return 1;
+  }
+
+  std::mt19937_64 rng(seed);
+  std::vector<std::vector<Order>> live_orders(books_count);
+  uint64_t next_order_id = 1;
+  uint32_t second = 0;
+
+  {
+    CaptureWriter writer(file);
+
+    writer.append('T', sizeof(MessageData::seconds), [&](MessageData &data) { data.seconds.second = second; });
+
+    for (uint32_t book = 0; book < books_count; ++book)
+    {
+      writer.append('R', sizeof(MessageData::series_info_basic), [&](MessageData &data)
+      {
+        data.series_info_basic.orderbook_id = book + 1;
+        std::snprintf(data.series_info_basic.symbol, sizeof(data.series_info_basic.symbol), "SYN%u", book + 1);
+      });
+    }
+
+    for (uint64_t i = 0; i < total_messages; ++i)
+    {
+      const uint32_t book = rng() % books_count;
+      std::vector<Order> &orders = live_orders[book];
+      const uint32_t roll = rng() % 100;
+      const uint32_t nanoseconds = i % 1000000000;
+
+      if (i % 10000 == 9999)
+      {
+        writer.append('T', sizeof(MessageData::seconds), [&](MessageData &data) { data.seconds.second = ++second; });
+      }
+      else if (orders.size() < 64 || roll < ((orders.size() < TARGET_DEPTH) ? 60 : 40))
+      {
+        const Order order{next_order_id++, 1 + rng() % 1000, (rng() & 1) ? 'B' : 'S'};
+        const int32_t offset = 1 + rng() % PRICE_SPREAD;
+        const int32_t price = (order.side == 'B') ? MID_PRICE - offset : MID_PRICE + offset;
+        orders.push_back(order);
+
+        writer.append('A', sizeof(MessageData::new_order), [&](MessageData &data)
+        {
+          data.new_order.timestamp_nanoseconds = nanoseconds;
+          data.new_order.order_id = order.id;
+          data.new_order.orderbook_id = book + 1;
+          data.new_order.side = order.side;
+          data.new_order.quantity = order.qty;
+          data.new_order.price = price;
+        });
+      }
+      else if (roll < 80)
+      {
+        const size_t idx = rng() % orders.size();
+        const Order order = orders[idx];
+        orders[idx] = orders.back();
+        orders.pop_back();
+
+        writer.append('D', sizeof(MessageData::deleted_order), [&](MessageData &data)
+        {
+          data.deleted_order.timestamp_nanoseconds = nanoseconds;
+          data.deleted_order.order_id = order.id;
+          data.deleted_order.orderbook_id = book + 1;
+          data.deleted_order.side = order.side;
+        });
+      }
+      else if (roll < 97)
+      {
+        const size_t idx = rng() % orders.size();
+        Order &order = orders[idx];
+        const uint64_t executed = 1 + rng() % order.qty;
+        const char type = (roll < 94) ? 'E' : 'C';
+        const size_t body_size = (type == 'E') ? sizeof(MessageData::execution_notice) : sizeof(MessageData::execution_notice_with_trade_info);
+
+        writer.append(type, body_size, [&](MessageData &data)
+        {
+          data.execution_notice.timestamp_nanoseconds = nanoseconds;
+          data.execution_notice.order_id = order.id;
+          data.execution_notice.orderbook_id = book + 1;
+          data.execution_notice.side = order.side;
+          data.execution_notice.executed_quantity = executed;
+          data.execution_notice.match_id = i;
+        });
+
+        order.qty -= executed;
+        if (order.qty == 0)
+        {
+          orders[idx] = orders.back();
+          orders.pop_back();
+        }
+      }
+      else
+      {
+        writer.append('Z', sizeof(MessageData::ep), [&](MessageData &data)
+        {
+          data.ep.timestamp_nanoseconds = nanoseconds;
+          data.ep.orderbook_id = book + 1;
+          data.ep.available_bid_quantity = rng() % 10000;
+          data.ep.available_ask_quantity = rng() % 10000;
+          data.ep.equilibrium_price = MID_PRICE;
+        });
+      }
+    }
+  }
+
+  std::fclose(file);
+}
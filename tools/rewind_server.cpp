@@ -0,0 +1,172 @@
+/*================================================================================
+
+File: rewind_server.cpp                                                         
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-05-24 11:12:47                                                 
+last edited: 2025-05-24 11:12:47                                                
+
+================================================================================*/
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Packets.hpp"
+
+//stand-in for the Rewind (MoldUDP64 retransmission) server, answers requests with the messages of a length prefixed capture.
+//every nth reply packet can be dropped to exercise re-requests.
+//usage: rewind_server <capture> <port> [drop every nth reply]
+
+static constexpr size_t PACKET_PAYLOAD_LIMIT = 1400;
+
+struct Capture
+{
+  char session[sizeof(MoldUDP64Header::session)];
+  uint64_t first_sequence;
+  std::vector<char> data;
+  std::vector<const MessageBlock *> messages;
+};
+
+static bool load(const char *path, Capture &capture)
+{
+  FILE *file = std::fopen(path, "rb");
+  if (file == nullptr)
+  {
+    std::perror(path);
+    return false;
+  }
+
+  std::fseek(file, 0, SEEK_END);
+  capture.data.resize(std::ftell(file));
+  std::fseek(file, 0, SEEK_SET);
+  const size_t read = std::fread(capture.data.data(), 1, capture.data.size(), file);
+  std::fclose(file);
+
+  if (read != capture.data.size())
+    return false;
+
+  capture.first_sequence = 0;
+  size_t offset = 0;
+
+  while (offset + sizeof(big_uint16_t) + sizeof(MoldUDP64Header) <= capture.data.size())
+  {
+    const uint16_t length = *reinterpret_cast<const big_uint16_t *>(&capture.data[offset]);
+    const char *packet = &capture.data[offset + sizeof(big_uint16_t)];
+    offset += sizeof(big_uint16_t) + length;
+
+    if (offset > capture.data.size())
+      break;
+
+    const MoldUDP64Header &header = *reinterpret_cast<const MoldUDP64Header *>(packet);
+    const uint16_t message_count = header.message_count;
+
+    if (message_count == 0 || message_count == UINT16_MAX)
+      continue;
+
+    if (capture.first_sequence == 0)
+    {
+      capture.first_sequence = header.sequence_number;
+      std::memcpy(capture.session, header.session, sizeof(capture.session));
+    }
+
+    //duplicated and overlapping packets only contribute what is new
+    uint64_t sequence = header.sequence_number;
+    const char *payload = packet + sizeof(MoldUDP64Header);
+
+    for (uint16_t i = 0; i < message_count; ++i, ++sequence)
+    {
+      const MessageBlock *block = reinterpret_cast<const MessageBlock *>(payload);
+      payload += sizeof(block->length) + block->length;
+
+      if (sequence == capture.first_sequence + capture.messages.size())
+        capture.messages.push_back(block);
+    }
+  }
+
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 3)
+  {
+    std::fprintf(stderr, "usage: %s <capture> <port> [drop every nth reply]\n", argv[0]);
+    return 1;
+  }
+
+  Capture capture{};
+  if (!load(argv[1], capture))
+    return 1;
+
+  const uint64_t drop_every = (argc > 3) ? std::stoull(argv[3]) : 0;
+
+  const int sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(std::stoi(argv[2]));
+
+  if (sock_fd == -1 || bind(sock_fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == -1)
+  {
+    std::perror("socket");
+    return 1;
+  }
+
+  std::fprintf(stderr, "serving sequences %lu..%lu\n", capture.first_sequence, capture.first_sequence + capture.messages.size() - 1);
+
+  const uint64_t end_sequence = capture.first_sequence + capture.messages.size();
+  uint64_t replies = 0;
+
+  while (true)
+  {
+    MoldUDP64Header request{};
+    sockaddr_in client{};
+    socklen_t client_size = sizeof(client);
+
+    const ssize_t size = recvfrom(sock_fd, &request, sizeof(request), 0, reinterpret_cast<sockaddr *>(&client), &client_size);
+    if (size != sizeof(request))
+      continue;
+
+    uint64_t sequence = std::max<uint64_t>(request.sequence_number, capture.first_sequence);
+    const uint64_t until = std::min<uint64_t>(request.sequence_number + request.message_count, end_sequence);
+
+    while (sequence < until)
+    {
+      MoldUDP64Packet packet{};
+      std::memcpy(packet.header.session, capture.session, sizeof(capture.session));
+      packet.header.sequence_number = sequence;
+
+      size_t payload_size = 0;
+      uint16_t message_count = 0;
+
+      while (sequence < until)
+      {
+        const MessageBlock *block = capture.messages[sequence - capture.first_sequence];
+        const size_t block_size = sizeof(block->length) + block->length;
+
+        if (payload_size + block_size > PACKET_PAYLOAD_LIMIT)
+          break;
+
+        std::memcpy(packet.payload + payload_size, block, block_size);
+        payload_size += block_size;
+        message_count++;
+        sequence++;
+      }
+
+      packet.header.message_count = message_count;
+
+      if (drop_every != 0 && ++replies % drop_every == 0)
+        continue;
+
+      sendto(sock_fd, &packet, sizeof(packet.header) + payload_size, 0, reinterpret_cast<const sockaddr *>(&client), client_size);
+    }
+  }
+}